@@ -0,0 +1,62 @@
+#ifndef CSV_ARROW_C_DATA_HPP
+#define CSV_ARROW_C_DATA_HPP
+
+// Arrow C Data Interface, reproduced verbatim from the Apache Arrow
+// specification (https://arrow.apache.org/docs/format/CDataInterface.html).
+// The spec is ABI-stable and designed to be copied, so no Arrow dependency
+// is needed. The include guard below is the one mandated by the spec, which
+// lets this header coexist with arrow/c/abi.h or nanoarrow.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CSV_ARROW_C_DATA_HPP
@@ -0,0 +1,86 @@
+#ifndef CSV_BLOB_DECODER_HPP
+#define CSV_BLOB_DECODER_HPP
+
+#include <cstddef>
+
+namespace csv {
+
+  /**
+   * @brief Incremental hex decoder for binary payload columns.
+   *
+   * Accepts the text of one field in arbitrary pieces, so a very large blob
+   * can be decoded through a fixed-size output buffer in constant memory.
+   * Both digit cases are accepted; anything else is rejected. Full 32-digit
+   * blocks are validated and decoded with SSE2 where available.
+   */
+  class HexDecoder {
+  public:
+    /// Upper bound of bytes produced by the next update() of @p len chars
+    [[nodiscard]] std::size_t max_output(std::size_t len) const noexcept {
+      return (len + (m_pending >= 0 ? 1 : 0)) / 2;
+    }
+
+    /**
+     * @brief Decodes the next piece of the field into @p out.
+     *
+     * @return Number of bytes written
+     *
+     * @throws CsvError (Econvert) on a non-hex character
+     * @throws CsvError (Einvalid) if @p out_size < max_output(len)
+     */
+    std::size_t update(const char *in, std::size_t len, void *out, std::size_t out_size);
+
+    /**
+     * @brief Ends the field and resets the decoder.
+     *
+     * @throws CsvError (Econvert) if an odd number of digits was supplied
+     */
+    void finish();
+
+  private:
+    int m_pending = -1;  // value of an unpaired high nibble
+  };
+
+
+  /**
+   * @brief Incremental base64 (RFC 4648, standard alphabet) decoder.
+   *
+   * Like HexDecoder, fields may be fed in pieces of any size. Padding is
+   * optional but, when present, must end the field. Full 16-character
+   * blocks are validated and translated with SSE2 where available.
+   */
+  class Base64Decoder {
+  public:
+    /// Upper bound of bytes produced by the next update() of @p len chars
+    [[nodiscard]] std::size_t max_output(std::size_t len) const noexcept {
+      return (len + m_pending) / 4 * 3;
+    }
+
+    /**
+     * @brief Decodes the next piece of the field into @p out.
+     *
+     * @return Number of bytes written
+     *
+     * @throws CsvError (Econvert) on invalid characters or misplaced padding
+     * @throws CsvError (Einvalid) if @p out_size < max_output(len)
+     */
+    std::size_t update(const char *in, std::size_t len, void *out, std::size_t out_size);
+
+    /**
+     * @brief Ends the field, flushing an unpadded final quantum, and resets.
+     *
+     * @return Number of bytes written (at most 2)
+     *
+     * @throws CsvError (Econvert) if the field ends with a dangling character
+     */
+    std::size_t finish(void *out, std::size_t out_size);
+
+  private:
+    char m_quantum[4] = {};
+    std::size_t m_pending = 0;
+    bool m_done = false;  // padding seen: no more data allowed
+  };
+
+} // namespace csv
+
+#endif // CSV_BLOB_DECODER_HPP
@@ -0,0 +1,149 @@
+#ifndef CSV_CATEGORICAL_HPP
+#define CSV_CATEGORICAL_HPP
+
+#include "FieldView.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace csv {
+
+  namespace detail {
+    // Categorical tables use 2N to 8N slots, rounded up to powers of two
+    constexpr unsigned categorical_min_bits(std::size_t n) noexcept {
+      unsigned b = 1;
+      while ((std::size_t{1} << b) < 2 * n) ++b;
+      return b;
+    }
+    constexpr unsigned categorical_max_bits(std::size_t n) noexcept {
+      return categorical_min_bits(n) + 2;
+    }
+  } // namespace detail
+
+  /**
+   * @brief Perfect-hash mapping from a fixed set of field values to indices.
+   *
+   * Built from a declared value set, e.g. {"BUY", "SELL"}. The constructor
+   * searches for a multiply-shift hash that is collision free over the set;
+   * when the set is constexpr the search runs at compile time. A lookup
+   * hashes the field 8 bytes at a time, probes a single slot and confirms
+   * the candidate with one comparison, so fields outside the set yield the
+   * explicit `unknown` result (== N) rather than a wrong index.
+   *
+   * @code
+   * enum class Side { Buy, Sell, Unknown };
+   * constexpr std::string_view kSides[] = {"BUY", "SELL"};
+   * constexpr csv::Categorical<2> sides(kSides);
+   * Side s = sides.as<Side>(field);
+   * @endcode
+   *
+   * Several spellings can share a meaning by mapping the returned index,
+   * e.g. {"N", "Y", "false", "true"} with `index % 2` for booleans.
+   */
+  template <std::size_t N>
+  class Categorical {
+    static_assert(N > 0 && N < 0xFFFF, "Categorical sets hold between 1 and 65534 values");
+
+  public:
+    /// Result of lookups for values outside the declared set
+    static constexpr std::size_t unknown = N;
+
+    constexpr explicit Categorical(const std::string_view (&values)[N]) {
+      for (std::size_t i = 0; i < N; ++i) m_values[i] = values[i];
+      for (m_bits = detail::categorical_min_bits(N); m_bits <= detail::categorical_max_bits(N); ++m_bits) {
+        for (std::uint64_t attempt = 0; attempt < kMaxAttempts; ++attempt) {
+          m_seed = (attempt * 0x9E3779B97F4A7C15ULL) | 1;
+          if (try_build()) return;
+        }
+      }
+      throw std::invalid_argument("Categorical: no perfect hash found (duplicate values?)");
+    }
+
+    /**
+     * @brief Returns the index of @p s in the declared set, or `unknown`.
+     */
+    [[nodiscard]] constexpr std::size_t find(const char *s, std::size_t len) const noexcept {
+      if (s == nullptr) return unknown;
+      const std::uint16_t i = m_slots[slot(key(s, len))];
+      if (i == kEmpty) return unknown;
+      const std::string_view &v = m_values[i];
+      if (v.size() != len) return unknown;
+      for (std::size_t k = 0; k < len; ++k) {
+        if (v[k] != s[k]) return unknown;
+      }
+      return i;
+    }
+
+    [[nodiscard]] constexpr std::size_t find(std::string_view s) const noexcept {
+      return find(s.data(), s.size());
+    }
+
+    [[nodiscard]] constexpr std::size_t find(FieldView f) const noexcept {
+      return find(f.data(), f.size());
+    }
+
+    /**
+     * @brief Maps a field to an enumeration declared in the same order as the set.
+     *
+     * Values outside the set map to `static_cast<Enum>(N)`, typically an
+     * `Unknown` enumerator placed last.
+     */
+    template <typename Enum>
+    [[nodiscard]] constexpr Enum as(FieldView f) const noexcept {
+      return static_cast<Enum>(find(f));
+    }
+
+    [[nodiscard]] constexpr std::string_view value(std::size_t i) const noexcept { return m_values[i]; }
+    [[nodiscard]] static constexpr std::size_t size() noexcept { return N; }
+
+  private:
+    static constexpr std::uint16_t kEmpty = 0xFFFF;
+    static constexpr std::uint64_t kMaxAttempts = 4096;
+
+    std::array<std::string_view, N> m_values{};
+    std::array<std::uint16_t, std::size_t{1} << detail::categorical_max_bits(N)> m_slots{};
+    std::uint64_t m_seed = 1;
+    unsigned m_bits = 0;
+
+    static constexpr std::uint64_t load(const char *s, std::size_t n) noexcept {
+      std::uint64_t v = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        v |= static_cast<std::uint64_t>(static_cast<unsigned char>(s[i])) << (8 * i);
+      }
+      return v;
+    }
+
+    // Length and every 8-byte word, each multiplied in so values differing anywhere get distinct keys
+    static constexpr std::uint64_t key(const char *s, std::size_t n) noexcept {
+      constexpr std::uint64_t kMul = 0xFF51AFD7ED558CCDULL;
+      std::uint64_t k = n * 0x9E3779B97F4A7C15ULL;
+      std::size_t i = 0;
+      for (; i + 8 <= n; i += 8) {
+        k = (k ^ load(s + i, 8)) * kMul;
+        k ^= k >> 29;
+      }
+      if (i < n) k = (k ^ load(s + i, n - i)) * kMul;
+      return k ^ (k >> 31);
+    }
+
+    [[nodiscard]] constexpr std::size_t slot(std::uint64_t k) const noexcept {
+      return static_cast<std::size_t>((k * m_seed) >> (64 - m_bits));
+    }
+
+    constexpr bool try_build() noexcept {
+      for (auto &s : m_slots) s = kEmpty;
+      for (std::size_t i = 0; i < N; ++i) {
+        std::uint16_t &s = m_slots[slot(key(m_values[i].data(), m_values[i].size()))];
+        if (s != kEmpty) return false;
+        s = static_cast<std::uint16_t>(i);
+      }
+      return true;
+    }
+  };
+
+} // namespace csv
+
+#endif // CSV_CATEGORICAL_HPP
@@ -0,0 +1,105 @@
+#ifndef CSV_COLUMN_BUILDER_HPP
+#define CSV_COLUMN_BUILDER_HPP
+
+#include "ArrowCData.hpp"
+#include "CsvParser.hpp"
+#include "ValidityBitmap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Physical type of a built column.
+   *
+   * Each type maps onto one Arrow format string.
+   */
+  enum class ColumnType : unsigned char {
+    Int64,    ///< 64-bit signed integer ("l")
+    Float64,  ///< IEEE double ("g")
+    Bool,     ///< bit-packed boolean ("b"), accepts 1/0/true/false
+    Utf8      ///< variable-length string, int32 offsets ("u")
+  };
+
+  /**
+   * @brief Declares the name and type of one CSV column.
+   */
+  struct ColumnSpec {
+    std::string name;
+    ColumnType type;
+  };
+
+
+  /**
+   * @brief Turns the parse stream into per-column buffers.
+   *
+   * Fields are appended to column buffers laid out exactly as the Arrow
+   * columnar format expects: a validity bitmap, a typed value array, and
+   * offsets plus character data for strings. Validity bits are recorded by
+   * the field callback as each field is tokenized, into 64-byte aligned
+   * ValidityBitmap storage. Finished columns are handed
+   * over through the Arrow C Data Interface without copying.
+   *
+   * Empty fields in numeric and boolean columns, and null fields reported
+   * under Option::EmptyIsNull, become nulls. Rows shorter than the declared
+   * schema are padded with nulls; extra fields are ignored.
+   */
+  class ColumnBuilder {
+  public:
+    /**
+     * @brief Creates a builder for the given column layout.
+     *
+     * @throws CsvError (Einvalid) if @p columns is empty
+     */
+    explicit ColumnBuilder(std::vector<ColumnSpec> columns);
+    ~ColumnBuilder();
+
+    ColumnBuilder(const ColumnBuilder&) = delete;
+    ColumnBuilder& operator=(const ColumnBuilder&) = delete;
+
+    /**
+     * @brief Parses a chunk with @p parser, appending completed fields.
+     *
+     * @throws CsvError on parse errors, or with Econvert when a field does not
+     *         match its column type or would take a Utf8 column past the
+     *         2 GiB its int32 offsets address
+     */
+    std::size_t parse(CsvParser &parser, const void *s, std::size_t len);
+
+    /**
+     * @brief Flushes the last row; see CsvParser::finish().
+     */
+    void finish(CsvParser &parser);
+
+    [[nodiscard]] std::size_t rows() const noexcept;
+    [[nodiscard]] std::size_t columns() const noexcept;
+    [[nodiscard]] const ColumnSpec &spec(std::size_t col) const;
+
+    /**
+     * @brief Moves all complete rows into a struct array ("+s") and its schema.
+     *
+     * May be called between any two parse() calls; fields of a row that is
+     * still in progress are kept for the next batch.
+     *
+     * Ownership of the buffers passes to @p out_array; the consumer frees
+     * them by calling its release callback. Individual columns can be moved
+     * out of the struct's children as the C Data Interface allows. The
+     * builder is left empty and can be reused for the next batch of rows.
+     */
+    void export_arrow(ArrowArray *out_array, ArrowSchema *out_schema);
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+
+    static void on_field(void *s, std::size_t len, void *data);
+    static void on_row(int c, void *data);
+  };
+
+} // namespace csv
+
+#endif // CSV_COLUMN_BUILDER_HPP
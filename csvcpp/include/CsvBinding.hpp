@@ -0,0 +1,331 @@
+#ifndef CSV_BINDING_HPP
+#define CSV_BINDING_HPP
+
+#include "CsvParser.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Converts raw field bytes into a typed struct member.
+   *
+   * Specialize this template to bind custom member types. A specialization
+   * provides a static `convert(const char *s, std::size_t len, Field &out)`
+   * returning false when the field cannot be represented as `Field`.
+   *
+   * Built-in support covers integral types, floating point types, bool,
+   * char and std::string. Empty (or null) fields leave non-string members
+   * untouched.
+   */
+  template <typename Field, typename Enable = void>
+  struct FieldConverter;
+
+  template <typename Field>
+  struct FieldConverter<Field, std::enable_if_t<std::is_integral_v<Field> &&
+                                                !std::is_same_v<Field, bool> &&
+                                                !std::is_same_v<Field, char>>> {
+    static bool convert(const char *s, std::size_t len, Field &out) noexcept {
+      if (len == 0) return true;
+      if (len > 1 && *s == '+' && s[1] != '-') { ++s; --len; }  // "+-5" stays invalid
+      auto [ptr, ec] = std::from_chars(s, s + len, out);
+      return ec == std::errc() && ptr == s + len;
+    }
+  };
+
+  template <typename Field>
+  struct FieldConverter<Field, std::enable_if_t<std::is_floating_point_v<Field>>> {
+    static bool convert(const char *s, std::size_t len, Field &out) noexcept {
+      if (len == 0) return true;
+      if (len > 1 && *s == '+' && s[1] != '-') { ++s; --len; }  // "+-5" stays invalid
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+      auto [ptr, ec] = std::from_chars(s, s + len, out);
+      return ec == std::errc() && ptr == s + len;
+#else
+      // Floating point from_chars is missing on some standard libraries
+      char tmp[64];
+      if (len >= sizeof(tmp)) return false;
+      std::memcpy(tmp, s, len);
+      tmp[len] = '\0';
+      char *end = nullptr;
+      out = static_cast<Field>(std::strtold(tmp, &end));
+      return end == tmp + len;
+#endif
+    }
+  };
+
+  template <>
+  struct FieldConverter<bool> {
+    static bool convert(const char *s, std::size_t len, bool &out) noexcept {
+      if (len == 0) return true;
+      if ((len == 1 && *s == '1') || (len == 4 && std::memcmp(s, "true", 4) == 0)) {
+        out = true;
+        return true;
+      }
+      if ((len == 1 && *s == '0') || (len == 5 && std::memcmp(s, "false", 5) == 0)) {
+        out = false;
+        return true;
+      }
+      return false;
+    }
+  };
+
+  template <>
+  struct FieldConverter<char> {
+    static bool convert(const char *s, std::size_t len, char &out) noexcept {
+      if (len == 0) return true;
+      out = *s;
+      return len == 1;
+    }
+  };
+
+  template <>
+  struct FieldConverter<std::string> {
+    static bool convert(const char *s, std::size_t len, std::string &out) {
+      if (s == nullptr) out.clear();
+      else out.assign(s, len);
+      return true;
+    }
+  };
+
+
+  /**
+   * @brief Compile-time mapping from CSV columns to members of @p T.
+   *
+   * Column i of each row is converted into the i-th bound member. The
+   * column-to-converter dispatch is expanded from a parameter pack, so the
+   * compiler sees a plain switch: no virtual calls and no function pointers
+   * per field. Use csv::bind() to create instances.
+   */
+  template <typename T, typename... Fields>
+  class CsvBinding {
+  public:
+    static constexpr std::size_t column_count = sizeof...(Fields);
+
+    explicit constexpr CsvBinding(Fields T::*... members) noexcept
+        : m_members(members...) {}
+
+    /**
+     * @brief Converts one field into the member bound to @p col.
+     *
+     * Columns beyond the bound members are ignored.
+     *
+     * @return false if the field could not be converted
+     */
+    bool assign(T &row, std::size_t col, const char *s, std::size_t len) const {
+      return assign(row, col, s, len, std::index_sequence_for<Fields...>{});
+    }
+
+    template <typename Sink>
+    class Reader;
+
+    /**
+     * @brief Creates a reader appending one element to @p out per CSV row.
+     */
+    Reader<std::vector<T>> reader(std::vector<T> &out) const {
+      return Reader<std::vector<T>>(*this, out);
+    }
+
+    /**
+     * @brief Creates a reader filling the caller-provided range [first, first + count).
+     *
+     * Rows that do not fit are counted by Reader::dropped() but not stored.
+     */
+    Reader<T *> reader(T *first, std::size_t count) const {
+      return Reader<T *>(*this, first, count);
+    }
+
+  private:
+    std::tuple<Fields T::*...> m_members;
+
+    template <std::size_t... I>
+    bool assign(T &row, std::size_t col, const char *s, std::size_t len,
+                std::index_sequence<I...>) const {
+      bool ok = true;
+      (void)((col == I
+                  ? (ok = FieldConverter<Fields>::convert(s, len, row.*std::get<I>(m_members)), true)
+                  : false) || ...);
+      return ok;
+    }
+  };
+
+  /**
+   * @brief Streams parser output into a vector or a fixed range of @p T.
+   *
+   * The reader owns the libcsv callbacks: fields are converted straight from
+   * the parser's entry buffer into the destination element. Conversion
+   * failures do not interrupt the parse; the first one is reported as a
+   * CsvError (Econvert) once the current parse()/finish() call returns.
+   * Members are bound to columns by position, or by header name after
+   * by_name().
+   */
+  template <typename T, typename... Fields>
+  template <typename Sink>
+  class CsvBinding<T, Fields...>::Reader {
+  public:
+    Reader(const CsvBinding &binding, std::vector<T> &out)
+        : m_binding(binding), m_vec(&out) {}
+
+    Reader(const CsvBinding &binding, T *first, std::size_t count)
+        : m_binding(binding), m_first(first), m_capacity(count) {}
+
+    /**
+     * @brief Binds the i-th member to the column named @p names[i].
+     *
+     * Requires CsvParser::set_header_row(). Names are resolved once, when
+     * the first data row arrives, against CsvParser::header() and the
+     * parser's projection; unnamed columns are ignored.
+     */
+    Reader &by_name(const std::array<std::string_view, column_count> &names) {
+      m_names.assign(names.begin(), names.end());
+      m_slot.clear();
+      m_unresolved = true;
+      return *this;
+    }
+
+    /**
+     * @brief Parses a chunk with @p parser, binding complete fields.
+     *
+     * @throws CsvError on parse errors or on the first conversion failure
+     * @throws CsvError (Einvalid) if a by_name() column is not in the header
+     */
+    std::size_t parse(CsvParser &parser, const void *s, std::size_t len) {
+      m_parser = &parser;
+      std::size_t n = parser.parse(s, len, on_field, on_row, this);
+      check_error();
+      return n;
+    }
+
+    /**
+     * @brief Flushes the last row; see CsvParser::finish().
+     */
+    void finish(CsvParser &parser) {
+      m_parser = &parser;
+      parser.finish(on_field, on_row, this);
+      check_error();
+    }
+
+    /// Number of rows stored into the destination
+    [[nodiscard]] std::size_t rows() const noexcept { return m_rows; }
+
+    /// Number of rows that did not fit into a fixed destination range
+    [[nodiscard]] std::size_t dropped() const noexcept { return m_dropped; }
+
+  private:
+    CsvBinding m_binding;
+    std::vector<T> *m_vec = nullptr;
+    T *m_first = nullptr;
+    std::size_t m_capacity = 0;
+    T *m_current = nullptr;
+    std::size_t m_col = 0;
+    std::size_t m_rows = 0;
+    std::size_t m_dropped = 0;
+    bool m_failed = false;
+    std::size_t m_err_row = 0;
+    std::size_t m_err_col = 0;
+
+    // by_name(): delivered column -> member, resolved on the first data row
+    static constexpr std::size_t kUnbound = static_cast<std::size_t>(-1);
+    std::vector<std::string> m_names;
+    std::vector<std::size_t> m_slot;
+    bool m_unresolved = false;
+    std::string m_missing;
+    CsvParser *m_parser = nullptr;
+
+    void resolve() {
+      m_unresolved = false;
+      const HeaderMap &header = m_parser->header();
+      const std::vector<std::size_t> projection = m_parser->get_projection();
+      m_slot.assign(projection.empty() ? header.size() : projection.size(), kUnbound);
+      for (std::size_t i = 0; i < m_names.size(); ++i) {
+        const std::size_t col = header.find(m_names[i]);
+        if (col == HeaderMap::npos) {
+          if (m_missing.empty()) m_missing = m_names[i];
+          continue;
+        }
+        for (std::size_t k = 0; k < m_slot.size(); ++k) {
+          if ((projection.empty() ? k : projection[k]) == col) m_slot[k] = i;
+        }
+      }
+    }
+
+    std::size_t member(std::size_t col) const noexcept {
+      if (m_names.empty()) return col;
+      return col < m_slot.size() ? m_slot[col] : kUnbound;
+    }
+
+    T *begin_row() {
+      if (m_vec) return &m_vec->emplace_back();
+      if (m_rows < m_capacity) return m_first + m_rows;
+      return nullptr;
+    }
+
+    static void on_field(void *s, std::size_t len, void *data) {
+      auto *r = static_cast<Reader *>(data);
+      if (r->m_col == 0) {
+        if (r->m_unresolved) r->resolve();
+        r->m_current = r->begin_row();
+      }
+      if (r->m_current &&
+          !r->m_binding.assign(*r->m_current, r->member(r->m_col), static_cast<const char *>(s), len) &&
+          !r->m_failed) {
+        r->m_failed = true;
+        r->m_err_row = r->m_rows;
+        r->m_err_col = r->m_col;
+      }
+      ++r->m_col;
+    }
+
+    static void on_row(int, void *data) {
+      auto *r = static_cast<Reader *>(data);
+      if (r->m_col == 0) return;  // blank line reported under RepAllNl
+      if (r->m_current) ++r->m_rows;
+      else ++r->m_dropped;
+      r->m_col = 0;
+      r->m_current = nullptr;
+    }
+
+    void check_error() {
+      if (!m_missing.empty()) {
+        std::string name;
+        name.swap(m_missing);
+        throw CsvError("CSV Binding Error: no column named '" + name + "'",
+                       CsvError::ErrorType::Einvalid);
+      }
+      if (!m_failed) return;
+      m_failed = false;
+      throw CsvError("CSV Binding Error: cannot convert field " + std::to_string(m_err_col) +
+                         " of row " + std::to_string(m_err_row),
+                     CsvError::ErrorType::Econvert);
+    }
+  };
+
+  /**
+   * @brief Binds CSV columns, in order, to the given members of @p T.
+   *
+   * @code
+   * auto binding = csv::bind<Trade>(&Trade::ts, &Trade::px, &Trade::qty);
+   * std::vector<Trade> trades;
+   * auto reader = binding.reader(trades);
+   * reader.parse(parser, buf, n);
+   * reader.finish(parser);
+   * @endcode
+   */
+  template <typename T, typename... Fields>
+  constexpr CsvBinding<T, Fields...> bind(Fields T::*... members) noexcept {
+    return CsvBinding<T, Fields...>(members...);
+  }
+
+} // namespace csv
+
+#endif // CSV_BINDING_HPP
@@ -0,0 +1,171 @@
+#ifndef CSV_CACHE_HPP
+#define CSV_CACHE_HPP
+
+#include "ColumnBuilder.hpp"
+#include "CsvParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Read-only view of one column chunk inside a mapped cache file.
+   *
+   * All pointers reference the mapping owned by the CsvCache the chunk was
+   * obtained from and stay valid for its lifetime. Utf8 chunks are dictionary
+   * encoded: values holds one uint32 dictionary index per row.
+   */
+  struct ColumnChunk {
+    ColumnType type = ColumnType::Int64;
+    std::size_t rows = 0;
+    std::size_t null_count = 0;
+    const std::uint8_t *validity = nullptr;   ///< Arrow-style bitmap, bit set = valid
+    const void *values = nullptr;             ///< int64/double array, bool bits, or dictionary indices
+    const std::uint32_t *dict_offsets = nullptr;
+    const char *dict_data = nullptr;
+    std::size_t dict_size = 0;
+
+    [[nodiscard]] bool is_valid(std::size_t i) const noexcept {
+      return (validity[i / 8] >> (i % 8)) & 1;
+    }
+    [[nodiscard]] std::int64_t int64_at(std::size_t i) const noexcept {
+      return static_cast<const std::int64_t *>(values)[i];
+    }
+    [[nodiscard]] double float64_at(std::size_t i) const noexcept {
+      return static_cast<const double *>(values)[i];
+    }
+    [[nodiscard]] bool bool_at(std::size_t i) const noexcept {
+      return (static_cast<const std::uint8_t *>(values)[i / 8] >> (i % 8)) & 1;
+    }
+    [[nodiscard]] std::string_view string_at(std::size_t i) const noexcept {
+      std::uint32_t k = static_cast<const std::uint32_t *>(values)[i];
+      return std::string_view(dict_data + dict_offsets[k], dict_offsets[k + 1] - dict_offsets[k]);
+    }
+  };
+
+
+  /**
+   * @brief Binary columnar cache of a CSV file: parse once, mmap many.
+   *
+   * convert() parses a CSV file into typed column chunks grouped in row
+   * groups (strings are dictionary encoded per chunk) and records the
+   * source file's size and mtime. open() maps the cache read-only and
+   * performs no parsing: columns are served straight from the mapping.
+   *
+   * Every chunk carries an XXH64 checksum seeded with the source size and
+   * mtime, so verify() detects both corruption and chunks written for a
+   * different version of the source file.
+   *
+   * Row groups end at row boundaries and record the XXH64 of the source
+   * bytes they were parsed from, which lets refresh() re-parse only the
+   * parts of a rewritten source that changed.
+   */
+  class CsvCache {
+  public:
+    /**
+     * @brief What refresh() had to redo.
+     */
+    struct RefreshStats {
+      std::size_t row_groups = 0;         ///< Row groups in the refreshed cache
+      std::size_t reparsed_groups = 0;    ///< Row groups parsed again from changed bytes
+      std::uint64_t reparsed_bytes = 0;   ///< Source bytes parsed again
+    };
+
+    /**
+     * @brief Parses @p csv_path with @p parser and writes a cache to @p cache_path.
+     *
+     * The cache is written to a temporary file and renamed into place, so
+     * readers never observe a partially written cache.
+     *
+     * @param row_group_rows Approximate number of rows per row group
+     *
+     * @throws CsvError on parse or conversion errors
+     * @throws std::runtime_error on I/O errors
+     */
+    static void convert(
+      const std::string &csv_path,
+      const std::string &cache_path,
+      const std::vector<ColumnSpec> &columns,
+      CsvParser &parser,
+      std::size_t row_group_rows = 65536
+    );
+
+    /**
+     * @brief Brings @p cache_path up to date with a rewritten @p csv_path.
+     *
+     * Each row group of the cache is looked up in the new source by the
+     * hash of its bytes, at its old offset or moved by the change in file
+     * size. Groups found are copied without parsing; the bytes between
+     * them are parsed again into new groups. A changed region must end on
+     * a row boundary, so if an edit changed the quoting of the bytes that
+     * follow it, the next groups are parsed again as well. Like convert(),
+     * the result is written to a temporary file and renamed into place.
+     *
+     * @param parser Configured as for convert(); it is finished afterwards
+     *
+     * @throws CsvError (Einvalid) if @p cache_path is not a cache or was
+     *         built with a different parser configuration
+     * @throws CsvError on parse or conversion errors
+     * @throws std::runtime_error on I/O errors
+     */
+    static RefreshStats refresh(const std::string &csv_path, const std::string &cache_path, CsvParser &parser);
+
+    /**
+     * @brief Checks that @p cache_path was built from the current @p source_path.
+     *
+     * Only the header is read; chunk checksums are not verified.
+     */
+    [[nodiscard]] static bool is_fresh(const std::string &cache_path, const std::string &source_path) noexcept;
+
+    /**
+     * @brief Maps @p cache_path after validating it against @p source_path.
+     *
+     * @throws CsvError (Einvalid) if the cache is malformed or stale
+     * @throws std::runtime_error if the file cannot be mapped
+     */
+    static CsvCache open(const std::string &cache_path, const std::string &source_path);
+
+    CsvCache(CsvCache&&) noexcept;
+    CsvCache& operator=(CsvCache&&) noexcept;
+    ~CsvCache();
+
+    [[nodiscard]] std::size_t rows() const noexcept;
+    [[nodiscard]] std::size_t columns() const noexcept;
+    [[nodiscard]] std::size_t row_groups() const noexcept;
+    [[nodiscard]] const ColumnSpec &spec(std::size_t col) const;
+
+    /// Index of the first row stored in @p group
+    [[nodiscard]] std::size_t row_group_first_row(std::size_t group) const;
+
+    /**
+     * @brief Returns the chunk of column @p col in row group @p group.
+     *
+     * @throws std::out_of_range for invalid indices
+     */
+    [[nodiscard]] ColumnChunk chunk(std::size_t group, std::size_t col) const;
+
+    /**
+     * @brief Recomputes every chunk checksum.
+     *
+     * open() only validates the file structure; call verify() before trusting
+     * the contents of a cache that may have been modified.
+     *
+     * @return false if any chunk does not match its stored checksum
+     */
+    [[nodiscard]] bool verify() const noexcept;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+
+    CsvCache();
+  };
+
+} // namespace csv
+
+#endif // CSV_CACHE_HPP
@@ -1,16 +1,28 @@
 #ifndef CSV_PARSER_HPP
 #define CSV_PARSER_HPP
 
+#include "HeaderMap.hpp"
+#include "RawField.hpp"
+#include "RowFilter.hpp"
+
 #include <initializer_list>
 #include <memory>
 #include <vector>
 #include <cstdio>
 #include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace csv {
 
+  class RowIndex;
+
+  namespace detail {
+    struct ParserAccess;
+  }
+
   /**
    * @brief Exception type for CSV parsing and processing errors.
    *
@@ -26,7 +38,8 @@ namespace csv {
       Eparse   = 1,  ///< Parsing error (malformed CSV)
       Enomem   = 2,  ///< Out of memory
       Etoobig  = 3,  ///< Field or buffer size exceeds limits
-      Einvalid = 4   ///< Invalid parameter or configuration
+      Einvalid = 4,  ///< Invalid parameter or configuration
+      Econvert = 5   ///< Field could not be converted to the requested type
     };
     
     ErrorType type;           ///< The specific type of error that occurred
@@ -184,6 +197,54 @@ namespace csv {
     [[nodiscard]] std::size_t get_block_size() const noexcept;
     [[nodiscard]] std::size_t get_buffer_size() const noexcept;
 
+    /**
+     * @brief Tokenizers parse() and finish() can run on.
+     *
+     * All produce the same callbacks, bytes consumed and errors. Settings
+     * that act inside the tokenizer (projection, filter, header row,
+     * seek()) always use one of the C++ engines.
+     */
+    enum class Engine : unsigned char {
+      Libcsv,  ///< csv_parse(), one byte and one capacity check at a time
+      Runs,    ///< C++ port of the same state machine: the bytes of a field up to
+               ///< the next quote, delimiter or terminator are found with a
+               ///< memchr-style scan and copied as one run
+      Simd,    ///< Runs, two-stage: runs are located through 64-byte structural
+               ///< bit masks (SSE2 where available). Needs the default space and
+               ///< terminator functions; Runs is used otherwise
+      Auto     ///< Picks one of the above per block from the data; see EngineStats
+    };
+
+    /**
+     * @brief Which engines parsed the input so far.
+     *
+     * Under Engine::Auto the first blocks of input are profiled (quote
+     * density and bytes per field), and every 16th block after that to
+     * follow changes in the data; an engine is chosen from the latest
+     * profile for each block: auto_block_size() bytes of a parse() call,
+     * or all of a shorter one.
+     */
+    struct EngineStats {
+      Engine active = Engine::Libcsv;  ///< Engine of the last block parsed
+      std::uint64_t bytes[3] = {};     ///< Bytes parsed per engine, indexed by Engine
+      std::uint64_t blocks = 0;        ///< Blocks parsed under Engine::Auto
+      std::uint64_t sampled = 0;       ///< Blocks profiled under Engine::Auto
+      std::uint64_t switches = 0;      ///< Engine changes under Engine::Auto
+    };
+
+    /// Size of the blocks Engine::Auto decides on
+    static constexpr std::size_t auto_block_size() noexcept { return std::size_t{64} << 10; }
+
+    /**
+     * @brief Selects the tokenizer. All share the parser state, so the
+     *        engine may be changed between any two parse() calls.
+     */
+    void set_engine(Engine engine) noexcept;
+    [[nodiscard]] Engine get_engine() const noexcept;
+
+    /// Engine activity since construction
+    [[nodiscard]] const EngineStats &engine_stats() const noexcept;
+
     // ------------------------------------------------------------------
     // CSV writing
     // ------------------------------------------------------------------
@@ -255,6 +316,29 @@ namespace csv {
       void *data
     );
 
+    /**
+     * @brief Parses a buffer the caller owns, unescaping fields inside it.
+     *
+     * Same as parse(), but fields are never copied to the parser's entry
+     * buffer: doubled quotes are compacted over the input and cb1 receives
+     * pointers into @p s, valid for as long as the caller keeps the buffer.
+     * With Option::AppendNull each field is terminated in place, over its
+     * delimiter or terminator. The bytes of @p s are undefined afterwards
+     * (e.g. a MAP_PRIVATE mapping or a read buffer about to be refilled).
+     * A field cut by the end of @p s is copied to the entry buffer and
+     * completed by the next parse(), parse_insitu() or finish() call;
+     * that one field is delivered from the entry buffer.
+     *
+     * @throws CsvError on parsing errors or memory failures
+     */
+    std::size_t parse_insitu(
+      void *s,
+      std::size_t len,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    );
+
     /**
      * @brief Finalizes parsing and flushes any buffered data.
      *
@@ -274,7 +358,202 @@ namespace csv {
       void *data
     );
 
+    /**
+     * @brief Same as parse(), delivering each field as a RawField.
+     *
+     * Field bytes are not copied or unescaped: each field is reported as
+     * its span of @p s plus the flags needed to derive its value, and only
+     * fields the consumer asks for are unescaped. A field cut by the end
+     * of @p s is gathered, raw, in the parser and delivered from there.
+     * Header fields and fields held back by a filter are unescaped as
+     * they are read and delivered as plain values. Option::AppendNull
+     * does not apply. A document started with parse_raw() must be
+     * continued with parse_raw() and ended with finish_raw().
+     *
+     * @throws CsvError on parsing errors or memory failures
+     */
+    std::size_t parse_raw(
+      const void *s,
+      std::size_t len,
+      RawFieldCallback cb1,
+      void (*cb2)(int, void *),
+      void *data
+    );
+
+    /**
+     * @brief finish() for a document parsed with parse_raw().
+     *
+     * @throws std::runtime_error if finalization fails
+     */
+    void finish_raw(RawFieldCallback cb1, void (*cb2)(int, void *), void *data);
+
+    // ------------------------------------------------------------------
+    // Header row
+    // ------------------------------------------------------------------
+
+    /**
+     * @brief Treats the first row of each document as a header.
+     *
+     * The header row is captured into header() instead of being reported
+     * through callbacks; blank lines before it are ignored and a leading
+     * UTF-8 byte order mark is stripped from the first name. Column names
+     * given to set_projection() or set_filter() are resolved against it
+     * once, before the first data row is tokenized. After finish() the
+     * next row is captured again as the header of a new document.
+     * Must be called between rows, e.g. before the first parse().
+     */
+    void set_header_row(bool enabled);
+    [[nodiscard]] bool get_header_row() const noexcept;
+
+    /// Most recently captured header, empty until one has been parsed
+    [[nodiscard]] const HeaderMap &header() const noexcept;
+
+    // ------------------------------------------------------------------
+    // Projection
+    // ------------------------------------------------------------------
+
+    /**
+     * @brief Restricts field callbacks to the given zero-based columns.
+     *
+     * Fields of other columns are still scanned to find field and row
+     * boundaries but are never copied into the entry buffer, and cb1 is
+     * only invoked for selected columns (in file order). Row callbacks are
+     * unchanged. An empty list, or clear_projection(), delivers every column.
+     * Must be called between rows, e.g. before the first parse().
+     */
+    void set_projection(const std::vector<std::size_t> &columns);
+    void clear_projection() noexcept;
+
+    /**
+     * @brief Same as set_projection(), selecting columns by header name.
+     *
+     * Resolved when the header row is parsed, or immediately if a header
+     * was already captured.
+     *
+     * @throws CsvError (Einvalid) if header rows are disabled and no header
+     *         was captured, or if a name is not in the header
+     */
+    void set_named_projection(const std::vector<std::string> &names);
+
+    /// Selected columns in ascending order, empty when not projecting
+    [[nodiscard]] std::vector<std::size_t> get_projection() const;
+
+    // ------------------------------------------------------------------
+    // Filtering
+    // ------------------------------------------------------------------
+
+    /**
+     * @brief Drops rows that do not satisfy @p filter.
+     *
+     * Each predicate is evaluated as soon as its field is tokenized. Fields
+     * of earlier columns are held back until the row passes its last
+     * tested column; a rejected row is skipped up to its terminator
+     * without any field or row callback. Tested columns are evaluated
+     * even when excluded by the projection. Must be called between rows.
+     * Predicates on named columns are resolved like set_named_projection().
+     *
+     * @throws CsvError (Einvalid) if @p filter names columns that cannot
+     *         be resolved, as for set_named_projection()
+     */
+    void set_filter(RowFilter filter);
+    void clear_filter() noexcept;
+
+    /// Rows rejected by the filter since set_filter()
+    [[nodiscard]] std::uint64_t rows_filtered() const noexcept;
+
+    // ------------------------------------------------------------------
+    // Random access
+    // ------------------------------------------------------------------
+
+    /**
+     * @brief Prepares the parser to resume at row @p row of an indexed file.
+     *
+     * Discards any partial row and returns the byte offset from which the
+     * caller must feed the file to parse(). Rows between the closest indexed
+     * row and @p row are parsed but not reported, so the first callbacks
+     * delivered belong to row @p row. Rows are counted as in the file, so
+     * with set_header_row() data row k is index row k + 1; the header is
+     * not read again and must have been captured before seeking if column
+     * names are in use.
+     *
+     * @return Byte offset to resume reading at
+     *
+     * @throws CsvError (Einvalid) if @p index was built with a different
+     *         delimiter, quote character or Option::RepAllNl setting, or if
+     *         column names are pending on a header that was never parsed
+     * @throws std::out_of_range if @p row >= index.rows()
+     */
+    std::uint64_t seek(const RowIndex &index, std::uint64_t row);
+
+    /**
+     * @brief Same as seek(index, row), and positions @p fp at the returned offset.
+     *
+     * @throws std::runtime_error if @p fp cannot be repositioned
+     */
+    void seek(const RowIndex &index, FILE *fp, std::uint64_t row);
+
+    /**
+     * @brief Reads one cell through an index built with field offsets.
+     *
+     * Seeks @p fp to the start of the field and reads exactly the bytes up
+     * to the next field or row, decoding them with this parser's settings.
+     * Any partial row is discarded. A NULL field (Option::EmptyIsNull)
+     * reads as an empty string.
+     *
+     * @throws CsvError (Einvalid) on a parser configuration mismatch
+     * @throws CsvError on parse errors in the field
+     * @throws std::logic_error if @p index has no field offsets
+     * @throws std::out_of_range if @p row or @p col is out of range
+     * @throws std::runtime_error on I/O errors
+     */
+    std::string read_cell(const RowIndex &index, FILE *fp, std::uint64_t row, std::size_t col);
+
+    // ------------------------------------------------------------------
+    // Checkpoints
+    // ------------------------------------------------------------------
+
+    /**
+     * @brief Where a checkpointed ingest resumes, as given to checkpoint().
+     */
+    struct ResumePoint {
+      std::uint64_t offset = 0;  ///< Input offset of the first byte not yet parsed
+      std::uint64_t row = 0;     ///< Rows completed before that byte
+    };
+
+    /**
+     * @brief Serializes the complete parsing state, partial row included.
+     *
+     * Can be taken between any two parse() calls, also in the middle of a
+     * row or of a quoted field: the tokenizer state, the bytes of the
+     * field being read, the fields held back by a filter, seek skipping,
+     * filter counters and the captured header are all saved. The parser
+     * does not know where it is in the input, so @p offset and @p row are
+     * supplied by the caller and handed back by restore(). The result is
+     * a versioned byte string to be stored by the caller.
+     */
+    [[nodiscard]] std::string checkpoint(std::uint64_t offset, std::uint64_t row) const;
+
+    /**
+     * @brief Continues from a state saved by checkpoint().
+     *
+     * The parser must be configured as the one that took the checkpoint:
+     * same delimiter, quote, options, character classes, header row
+     * setting, projection and filter. Feeding parse() from the returned
+     * offset then delivers exactly the callbacks the original parser
+     * would have.
+     *
+     * @return The offset and row given to checkpoint()
+     *
+     * @throws CsvError (Einvalid) if @p state is not a checkpoint (its
+     *         tokenizer state included), was taken after a parse error or
+     *         with a different configuration
+     * @throws std::runtime_error if the entry buffer cannot be allocated
+     */
+    ResumePoint restore(std::string_view state);
+
   private:
+    friend struct detail::ParserAccess;
+
     struct impl;
     std::unique_ptr<impl> m_pimpl;
 
@@ -0,0 +1,54 @@
+#ifndef CSV_FIELD_ARENA_HPP
+#define CSV_FIELD_ARENA_HPP
+
+#include "FieldView.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Bump allocator that keeps retained field bytes alive.
+   *
+   * Memory is taken from blocks of block_size() bytes; a field larger
+   * than half a block gets a block of its own. Nothing is freed individually:
+   * every copy stays valid, at a fixed address, until clear() or the
+   * arena is destroyed. Used by FieldView::retain(), RawField::retain()
+   * and RowBatch::retain().
+   */
+  class FieldArena {
+  public:
+    explicit FieldArena(std::size_t block_size = std::size_t{64} << 10);
+
+    FieldArena(FieldArena&&) noexcept = default;
+    FieldArena& operator=(FieldArena&&) noexcept = default;
+    FieldArena(const FieldArena&) = delete;
+    FieldArena& operator=(const FieldArena&) = delete;
+
+    /// Uninitialized storage for @p size bytes
+    char *allocate(std::size_t size);
+
+    /// A stable copy of [data, data + size)
+    FieldView copy(const char *data, std::size_t size);
+
+    /// Invalidates every copy; the first block is kept for reuse
+    void clear() noexcept;
+
+    /// Bytes handed out since construction or clear()
+    [[nodiscard]] std::size_t size() const noexcept { return m_used; }
+    [[nodiscard]] std::size_t block_size() const noexcept { return m_block_size; }
+
+  private:
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    std::vector<std::unique_ptr<char[]>> m_large;   // one per oversized field
+    char *m_next = nullptr;   // free space in the current block
+    std::size_t m_left = 0;
+    std::size_t m_block_size;
+    std::size_t m_used = 0;
+  };
+
+} // namespace csv
+
+#endif // CSV_FIELD_ARENA_HPP
@@ -0,0 +1,89 @@
+#ifndef CSV_FIELD_VIEW_HPP
+#define CSV_FIELD_VIEW_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace csv {
+
+  class FieldArena;
+
+  /**
+   * @brief Non-owning view of one parsed field.
+   *
+   * A null view (data() == nullptr) represents a field reported as NULL
+   * under Option::EmptyIsNull. Views point into parser- or batch-owned
+   * memory and are only valid as long as documented by their producer.
+   *
+   * Producers mark views into memory they recycle (the parser's entry
+   * buffer, a batch's storage) as transient(); retain() copies those and
+   * passes any other view through untouched.
+   */
+  class FieldView {
+  public:
+    constexpr FieldView() noexcept = default;
+    constexpr FieldView(const char *data, std::size_t size) noexcept
+        : m_data(data), m_size(size) {}
+    constexpr FieldView(const char *data, std::size_t size, bool transient) noexcept
+        : m_data(data), m_size(size), m_transient(transient) {}
+
+    [[nodiscard]] constexpr const char *data() const noexcept { return m_data; }
+    [[nodiscard]] constexpr std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] constexpr bool is_null() const noexcept { return m_data == nullptr; }
+
+    [[nodiscard]] constexpr std::string_view view() const noexcept {
+      return m_data ? std::string_view(m_data, m_size) : std::string_view();
+    }
+
+    [[nodiscard]] std::string str() const { return std::string(view()); }
+
+    /// The bytes are overwritten once the producer moves on
+    [[nodiscard]] constexpr bool transient() const noexcept { return m_transient; }
+
+    /**
+     * @brief A view that outlives the callback: transient bytes are copied
+     *        into @p arena, any other view is returned as is.
+     */
+    [[nodiscard]] FieldView retain(FieldArena &arena) const;
+
+    // ------------------------------------------------------------------
+    // Binary payload accessors
+    // ------------------------------------------------------------------
+
+    /// Bytes produced by decode_hex() for a well-formed field
+    [[nodiscard]] constexpr std::size_t hex_size() const noexcept { return m_size / 2; }
+
+    /// Upper bound of bytes produced by decode_base64()
+    [[nodiscard]] constexpr std::size_t base64_size() const noexcept { return (m_size + 3) / 4 * 3; }
+
+    /**
+     * @brief Decodes a hex encoded field straight into @p out.
+     *
+     * @return Number of bytes written
+     *
+     * @throws CsvError (Econvert) if the field is not valid hex
+     * @throws CsvError (Einvalid) if @p out_size < hex_size()
+     */
+    std::size_t decode_hex(void *out, std::size_t out_size) const;
+
+    /**
+     * @brief Decodes a base64 encoded field straight into @p out.
+     *
+     * @return Number of bytes written
+     *
+     * @throws CsvError (Econvert) if the field is not valid base64
+     * @throws CsvError (Einvalid) if @p out_size < base64_size()
+     */
+    std::size_t decode_base64(void *out, std::size_t out_size) const;
+
+  private:
+    const char *m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_transient = false;
+  };
+
+} // namespace csv
+
+#endif // CSV_FIELD_VIEW_HPP
@@ -0,0 +1,104 @@
+#ifndef CSV_FOLLOW_SOURCE_HPP
+#define CSV_FOLLOW_SOURCE_HPP
+
+#include "CsvParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace csv {
+
+  /**
+   * @brief Incrementally parses a file that other processes append to (`tail -f`).
+   *
+   * Each poll() reads only the bytes appended since the previous call.
+   * Their row structure is tracked across polls with the csv_parse()
+   * transition table, and only complete rows are handed to the parser:
+   * the bytes of a row whose terminator has not arrived yet are held back,
+   * so no callback ever reports part of a row. The concatenation of what
+   * the parser receives is the file itself, so callbacks match a single
+   * parse of the final file.
+   *
+   * wait() blocks on inotify where available and polls the file size
+   * elsewhere. The file opened at construction is followed; if it shrinks
+   * (truncated for rotation) reading restarts at its beginning.
+   *
+   * @code
+   * csv::FollowSource src("events.csv");
+   * for (;;) {
+   *   src.poll(parser, on_field, on_row, &ctx);
+   *   src.wait(1000);
+   * }
+   * @endcode
+   */
+  class FollowSource {
+  public:
+    /**
+     * @brief Opens @p path for following from byte @p offset.
+     *
+     * @p offset must be a row boundary, e.g. a previous offset().
+     *
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    explicit FollowSource(const std::string &path, std::uint64_t offset = 0);
+
+    FollowSource(FollowSource&&) noexcept;
+    FollowSource& operator=(FollowSource&&) noexcept;
+    ~FollowSource();
+
+    /**
+     * @brief Parses the complete rows appended since the last call.
+     *
+     * @return Number of bytes handed to the parser
+     *
+     * @throws CsvError on parse errors
+     * @throws std::runtime_error on I/O errors
+     */
+    std::size_t poll(
+      CsvParser &parser,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    );
+
+    /**
+     * @brief Blocks until the file may have changed or @p timeout_ms elapses.
+     *
+     * A negative timeout waits indefinitely.
+     *
+     * @return false on timeout
+     */
+    bool wait(int timeout_ms);
+
+    /**
+     * @brief Parses everything read so far, including a final row without
+     *        terminator, and finishes @p parser.
+     *
+     * Call once the writer is known to be done.
+     */
+    void finish(
+      CsvParser &parser,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    );
+
+    /// Offset just past the last row handed to the parser; a valid restart point
+    [[nodiscard]] std::uint64_t offset() const noexcept;
+
+    /// Bytes of an incomplete row held back until its terminator arrives
+    [[nodiscard]] std::size_t pending() const noexcept;
+
+    /// Whether wait() is backed by inotify
+    [[nodiscard]] bool uses_inotify() const noexcept;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+  };
+
+} // namespace csv
+
+#endif // CSV_FOLLOW_SOURCE_HPP
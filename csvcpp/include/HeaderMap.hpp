@@ -0,0 +1,57 @@
+#ifndef CSV_HEADER_MAP_HPP
+#define CSV_HEADER_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Column names of a header row and their zero-based indices.
+   *
+   * Names are stored back to back in one buffer and looked up through an
+   * open-addressing table of 32-bit slots, so a header of N columns costs
+   * three allocations. Lookups happen once, when a name is resolved to an
+   * index; rows are then processed by index only. If a name appears more
+   * than once, lookups return its first column.
+   */
+  class HeaderMap {
+  public:
+    /// Result of find() for names that are not in the header
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    HeaderMap() = default;
+    explicit HeaderMap(const std::vector<std::string> &names);
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_begin.empty() ? 0 : m_begin.size() - 1; }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    /// Name of column @p col; @p col must be < size()
+    [[nodiscard]] std::string_view name(std::size_t col) const noexcept {
+      return std::string_view(m_chars).substr(m_begin[col], m_begin[col + 1] - m_begin[col]);
+    }
+
+    /// Index of the column called @p name, or npos
+    [[nodiscard]] std::size_t find(std::string_view name) const noexcept;
+
+    [[nodiscard]] bool contains(std::string_view name) const noexcept { return find(name) != npos; }
+
+    /**
+     * @brief Index of the column called @p name.
+     *
+     * @throws CsvError (Einvalid) if there is no such column
+     */
+    [[nodiscard]] std::size_t index(std::string_view name) const;
+
+  private:
+    std::string m_chars;
+    std::vector<std::uint32_t> m_begin;  // size() + 1 offsets into m_chars
+    std::vector<std::uint32_t> m_slots;  // column + 1, 0 for empty slots
+  };
+
+} // namespace csv
+
+#endif // CSV_HEADER_MAP_HPP
@@ -0,0 +1,155 @@
+#ifndef CSV_KEY_INDEX_HPP
+#define CSV_KEY_INDEX_HPP
+
+#include "CsvParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Persistent secondary index on one key column (`.csvkey` sidecar).
+   *
+   * build() parses the file once and records, for every row with a
+   * non-NULL key, the XXH64 hash of the unescaped key together with the
+   * row number and the byte range of the row, sorted by hash. The sidecar
+   * is mapped read-only by open(); a lookup binary searches the hash,
+   * then parses only the candidate rows to confirm their key, so hash
+   * collisions never produce false matches.
+   *
+   * Rows are numbered as in RowIndex, counting a header row. When the
+   * source has only been appended to, update() keeps the existing entries
+   * and scans just the new bytes.
+   *
+   * @code
+   * csv::KeyIndex::build("ref.csv", "ref.csvkey", parser, "id");
+   * csv::KeyIndex keys = csv::KeyIndex::open("ref.csvkey", "ref.csv");
+   * keys.lookup(parser, "A-1042", on_field, on_row, &ctx);
+   * @endcode
+   */
+  class KeyIndex {
+  public:
+    /**
+     * @brief A row holding the key.
+     */
+    struct Match {
+      std::uint64_t row;    ///< Row number, counting a header row
+      std::uint64_t begin;  ///< Byte offset where the row starts
+      std::uint64_t end;    ///< Byte offset where the next row starts
+    };
+
+    /**
+     * @brief Indexes column @p column of @p csv_path into @p index_path.
+     *
+     * @throws CsvError on parse errors
+     * @throws std::runtime_error on I/O errors
+     */
+    static void build(
+      const std::string &csv_path,
+      const std::string &index_path,
+      const CsvParser &parser,
+      std::size_t column
+    );
+
+    /**
+     * @brief Indexes the column named @p column in the first row, which is
+     *        not indexed itself.
+     *
+     * @throws CsvError (Einvalid) if the first row has no such column
+     * @throws CsvError on parse errors
+     * @throws std::runtime_error on I/O errors
+     */
+    static void build(
+      const std::string &csv_path,
+      const std::string &index_path,
+      const CsvParser &parser,
+      std::string_view column
+    );
+
+    /**
+     * @brief Brings @p index_path up to date with @p csv_path.
+     *
+     * If the bytes the index was built from are still the start of the
+     * file, only the rows after them are parsed (a final row that had no
+     * terminator is parsed again). This is checked by comparing an XXH64
+     * hash of the whole indexed prefix, so the old bytes are read but not
+     * parsed. Otherwise the index is rebuilt on the same column.
+     *
+     * @return false if a full rebuild was needed
+     *
+     * @throws CsvError (Einvalid) if @p index_path is not a key index or was
+     *         built with a different parser configuration
+     * @throws CsvError on parse errors
+     * @throws std::runtime_error on I/O errors
+     */
+    static bool update(const std::string &csv_path, const std::string &index_path, const CsvParser &parser);
+
+    /**
+     * @brief Maps @p index_path and @p source_path after checking the index is current.
+     *
+     * @throws CsvError (Einvalid) if the index is malformed or stale
+     * @throws std::runtime_error if a file cannot be mapped
+     */
+    static KeyIndex open(const std::string &index_path, const std::string &source_path);
+
+    KeyIndex(KeyIndex&&) noexcept;
+    KeyIndex& operator=(KeyIndex&&) noexcept;
+    ~KeyIndex();
+
+    /// Rows in the source file, a header row included
+    [[nodiscard]] std::uint64_t rows() const noexcept;
+
+    /// Number of indexed keys (rows with a non-NULL key)
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    /// Indexed column
+    [[nodiscard]] std::size_t column() const noexcept;
+
+    /// Whether the first row is a header naming the column
+    [[nodiscard]] bool has_header() const noexcept;
+
+    /**
+     * @brief Rows whose key equals @p key, in file order.
+     *
+     * Only the rows sharing the key's hash are parsed.
+     *
+     * @throws CsvError (Einvalid) if @p parser's delimiter, quote or
+     *         Option::RepAllNl differ from the index
+     */
+    [[nodiscard]] std::vector<Match> find(const CsvParser &parser, std::string_view key) const;
+
+    /**
+     * @brief Parses the rows whose key equals @p key, in file order.
+     *
+     * Each matching row is fed to @p parser, so its projection and filter
+     * apply, and the parser is finished afterwards. With
+     * set_header_row(), a header not captured yet is parsed first.
+     *
+     * @return Number of matching rows
+     *
+     * @throws CsvError (Einvalid) on a parser configuration mismatch
+     * @throws CsvError on parse errors
+     */
+    std::size_t lookup(
+      CsvParser &parser,
+      std::string_view key,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    ) const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+
+    KeyIndex();
+  };
+
+} // namespace csv
+
+#endif // CSV_KEY_INDEX_HPP
@@ -0,0 +1,109 @@
+#ifndef CSV_RAW_FIELD_HPP
+#define CSV_RAW_FIELD_HPP
+
+#include "FieldView.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace csv {
+
+  /**
+   * @brief A field as it appears in the input, unescaped only on demand.
+   *
+   * raw() spans the field from its first byte (the opening quote, or the
+   * first non-space byte) up to the delimiter or terminator. The flags tell
+   * how the value is derived from it: span() drops the opening and closing
+   * quotes and the trailing spaces, and when escaped() is set the doubled
+   * quotes left in span() still have to be collapsed by unescape(). A
+   * field that is never asked for its value costs nothing beyond its
+   * boundaries.
+   *
+   * A null view (data() == nullptr) represents a field reported as NULL
+   * under Option::EmptyIsNull. Views point into the input or the parser
+   * and are only valid during the callback that delivers them; retain()
+   * keeps the value beyond it.
+   */
+  class RawField {
+  public:
+    constexpr RawField() noexcept = default;
+
+    /// An unquoted field whose value is [data, data + size)
+    constexpr RawField(const char *data, std::size_t size) noexcept
+        : m_data(data), m_size(size) {}
+
+    /**
+     * @param quoted      raw() starts with an opening quote
+     * @param closed      a closing quote precedes the trailing spaces
+     * @param spaces      trailing spaces dropped from the value
+     * @param escaped     span() holds doubled quotes to collapse
+     * @param quote       the quote character
+     * @param transient   the bytes live in the parser, not in the input
+     */
+    constexpr RawField(const char *data, std::size_t size, bool quoted, bool closed,
+                       std::size_t spaces, bool escaped, char quote, bool transient = false) noexcept
+        : m_data(data), m_size(size), m_spaces(spaces), m_quoted(quoted), m_closed(closed),
+          m_escaped(escaped), m_transient(transient), m_quote(quote) {}
+
+    [[nodiscard]] constexpr const char *data() const noexcept { return m_data; }
+    [[nodiscard]] constexpr std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] constexpr bool is_null() const noexcept { return m_data == nullptr; }
+
+    [[nodiscard]] constexpr bool quoted() const noexcept { return m_quoted; }
+    [[nodiscard]] constexpr bool escaped() const noexcept { return m_escaped; }
+    [[nodiscard]] constexpr std::size_t trailing_spaces() const noexcept { return m_spaces; }
+    [[nodiscard]] constexpr bool transient() const noexcept { return m_transient; }
+
+    /// The field bytes exactly as in the input
+    [[nodiscard]] constexpr std::string_view raw() const noexcept {
+      return m_data ? std::string_view(m_data, m_size) : std::string_view();
+    }
+
+    /// raw() without quotes and trailing spaces: the value unless escaped()
+    [[nodiscard]] constexpr std::string_view span() const noexcept {
+      const std::size_t head = m_quoted ? 1 : 0;
+      return m_data ? std::string_view(m_data + head, m_size - head - m_spaces - (m_closed ? 1 : 0))
+                    : std::string_view();
+    }
+
+    /**
+     * @brief Writes the value to @p out, which must hold span().size() bytes.
+     *
+     * @return Size of the value
+     */
+    std::size_t unescape(char *out) const noexcept;
+
+    /// The value, unescaped
+    [[nodiscard]] std::string str() const;
+
+    /**
+     * @brief The value as a FieldView: span() itself when nothing needs
+     *        unescaping, otherwise unescaped into @p scratch.
+     */
+    [[nodiscard]] FieldView value(std::string &scratch) const;
+
+    /**
+     * @brief The value, valid after the callback: span() itself when it
+     *        points into the input and needs no unescaping, otherwise
+     *        unescaped into @p arena.
+     */
+    [[nodiscard]] FieldView retain(FieldArena &arena) const;
+
+  private:
+    const char *m_data = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_spaces = 0;
+    bool m_quoted = false;
+    bool m_closed = false;
+    bool m_escaped = false;
+    bool m_transient = false;
+    char m_quote = '"';
+  };
+
+  /// Field callback of CsvParser::parse_raw()
+  using RawFieldCallback = void (*)(const RawField &, void *);
+
+} // namespace csv
+
+#endif // CSV_RAW_FIELD_HPP
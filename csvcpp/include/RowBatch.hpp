@@ -0,0 +1,131 @@
+#ifndef CSV_ROW_BATCH_HPP
+#define CSV_ROW_BATCH_HPP
+
+#include "CsvParser.hpp"
+#include "FieldArena.hpp"
+#include "FieldView.hpp"
+#include "ValidityBitmap.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Collects complete rows from the parser and hands them out in batches.
+   *
+   * Field bytes of a batch are stored back to back in one buffer. Each field
+   * also gets one bit in a packed ValidityBitmap (row-major, see
+   * field_index()), written by the field callback as the field is
+   * tokenized: the bit is cleared for fields reported as NULL under
+   * Option::EmptyIsNull and set otherwise. Vectorized consumers can count or
+   * mask nulls a 64-bit word at a time instead of testing each field.
+   *
+   * The batch callback fires whenever capacity() rows are complete and once
+   * more from finish() for the remainder. Field views are valid until the
+   * callback returns.
+   *
+   * parse_insitu() skips the copy: field views point into the caller's
+   * buffer, and only the rows still pending when it returns are copied
+   * into the batch.
+   *
+   * Views into the batch's own storage are transient(); those into the
+   * caller's buffer are not, so retain() copies only the former.
+   */
+  class RowBatch {
+  public:
+    using BatchCallback = void (*)(const RowBatch &, void *);
+
+    explicit RowBatch(std::size_t capacity = 1024);
+
+    /**
+     * @brief Parses a chunk with @p parser, delivering every full batch to @p cb.
+     */
+    std::size_t parse(CsvParser &parser, const void *s, std::size_t len,
+                      BatchCallback cb, void *data);
+
+    /**
+     * @brief Same as parse(), parsing @p s in place with CsvParser::parse_insitu().
+     *
+     * Views of the batches delivered during the call point into @p s.
+     * Pending rows are copied before returning, so @p s may be reused or
+     * unmapped as soon as the call returns.
+     */
+    std::size_t parse_insitu(CsvParser &parser, void *s, std::size_t len,
+                             BatchCallback cb, void *data);
+
+    /**
+     * @brief Finishes parsing and delivers the last, possibly partial, batch.
+     */
+    void finish(CsvParser &parser, BatchCallback cb, void *data);
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+    [[nodiscard]] std::size_t rows() const noexcept { return m_row_begin.size() - 1; }
+
+    /// Number of fields in @p row; rows need not have equal widths
+    [[nodiscard]] std::size_t fields(std::size_t row) const noexcept {
+      return m_row_begin[row + 1] - m_row_begin[row];
+    }
+
+    /// Position of field (@p row, @p col) in field order and in validity()
+    [[nodiscard]] std::size_t field_index(std::size_t row, std::size_t col) const noexcept {
+      return m_row_begin[row] + col;
+    }
+
+    [[nodiscard]] FieldView field(std::size_t row, std::size_t col) const noexcept {
+      const std::size_t i = field_index(row, col);
+      if (!m_validity.test(i)) return FieldView();
+      if (m_insitu) return m_views[i];
+      return FieldView(m_chars.data() + m_field_begin[i], m_field_begin[i + 1] - m_field_begin[i], true);
+    }
+
+    /**
+     * @brief The fields of @p row, valid after the batch callback returns.
+     *
+     * Transient fields are copied into @p arena, the others are returned
+     * as they are (see FieldView::retain()).
+     */
+    [[nodiscard]] std::vector<FieldView> retain(std::size_t row, FieldArena &arena) const;
+
+    [[nodiscard]] const ValidityBitmap &validity() const noexcept { return m_validity; }
+
+    /// Number of NULL fields in @p row (popcount over its bitmap range)
+    [[nodiscard]] std::size_t null_count(std::size_t row) const noexcept {
+      return m_validity.null_count(m_row_begin[row], m_row_begin[row + 1]);
+    }
+
+  private:
+    std::size_t m_capacity;
+    std::vector<char> m_chars;
+    std::vector<std::size_t> m_field_begin{0};   // per field, plus end sentinel
+    std::vector<std::size_t> m_row_begin{0};     // per row, plus end sentinel
+    ValidityBitmap m_validity;
+    BatchCallback m_cb = nullptr;
+    void *m_cb_data = nullptr;
+
+    // In-situ batches: one view per field, into the input or m_owned
+    bool m_insitu = false;
+    std::vector<FieldView> m_views;
+    std::deque<std::string> m_owned;
+    const char *m_input = nullptr;
+    std::size_t m_input_size = 0;
+
+    void clear() noexcept;
+    void begin_insitu();
+    void own_input();
+    FieldView own(const char *s, std::size_t len);
+
+    [[nodiscard]] std::size_t field_count() const noexcept {
+      return m_insitu ? m_views.size() : m_field_begin.size() - 1;
+    }
+
+    static void on_field(void *s, std::size_t len, void *data);
+    static void on_field_insitu(void *s, std::size_t len, void *data);
+    static void on_row(int c, void *data);
+  };
+
+} // namespace csv
+
+#endif // CSV_ROW_BATCH_HPP
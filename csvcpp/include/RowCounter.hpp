@@ -0,0 +1,86 @@
+#ifndef CSV_ROW_COUNTER_HPP
+#define CSV_ROW_COUNTER_HPP
+
+#include "CsvParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace csv {
+
+  /**
+   * @brief Totals reported by RowCounter.
+   *
+   * rows and fields equal the number of row and field callbacks a
+   * CsvParser with the same configuration would make.
+   */
+  struct RowCounts {
+    std::uint64_t rows = 0;
+    std::uint64_t fields = 0;
+    std::size_t min_fields = 0;  ///< Fewest fields in a row (width tracking only)
+    std::size_t max_fields = 0;  ///< Most fields in a row (width tracking only)
+  };
+
+
+  /**
+   * @brief Counts rows and fields without tokenizing field contents.
+   *
+   * Input is classified 64 bytes at a time into bit masks of quotes,
+   * delimiters, terminators and spaces (SSE2 where available). Quoted
+   * regions come from a prefix XOR of the quote mask, and counts from
+   * popcounts of the structural bits outside them. Blocks whose quotes
+   * are not plainly paired at field boundaries (a quote inside an
+   * unquoted field, spaces around quoted fields, characters after a
+   * closing quote) are counted byte by byte with the csv_parse()
+   * transition table. Results therefore always match the callbacks of
+   * CsvParser, including Option::Strict errors.
+   *
+   * @code
+   * csv::RowCounter counter(parser);
+   * while (size_t n = fread(buf, 1, sizeof(buf), fp)) counter.count(buf, n);
+   * csv::RowCounts c = counter.finish();
+   * @endcode
+   */
+  class RowCounter {
+  public:
+    /**
+     * @brief Counts with the delimiter, quote, space and terminator
+     *        functions and options @p parser has now.
+     *
+     * @param track_widths Also record min_fields/max_fields, at the cost of
+     *        visiting every row end
+     */
+    explicit RowCounter(const CsvParser &parser, bool track_widths = false);
+
+    RowCounter(RowCounter&&) noexcept;
+    RowCounter& operator=(RowCounter&&) noexcept;
+    ~RowCounter();
+
+    /**
+     * @brief Counts the next chunk of input; see CsvParser::parse().
+     *
+     * @throws CsvError (Eparse) where CsvParser::parse() would under Option::Strict
+     */
+    void count(const void *s, std::size_t len);
+
+    /**
+     * @brief Counts a final row without terminator and returns the totals.
+     *
+     * The counter is reset for a new document afterwards.
+     *
+     * @throws std::runtime_error where CsvParser::finish() would
+     */
+    RowCounts finish();
+
+    /// Totals so far, not including an unterminated final row
+    [[nodiscard]] const RowCounts &counts() const noexcept;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+  };
+
+} // namespace csv
+
+#endif // CSV_ROW_COUNTER_HPP
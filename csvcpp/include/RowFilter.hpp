@@ -0,0 +1,123 @@
+#ifndef CSV_ROW_FILTER_HPP
+#define CSV_ROW_FILTER_HPP
+
+#include "FieldView.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace csv {
+
+  class HeaderMap;
+  class RowIndex;
+
+  /**
+   * @brief Conjunction of simple column predicates for CsvParser::set_filter().
+   *
+   * Predicates are grouped per column when added, so evaluating a field
+   * only visits the predicates of its own column. Every predicate must
+   * hold for a row to be kept. NULL fields (Option::EmptyIsNull) and
+   * fields that do not convert to the range type never match.
+   *
+   * @code
+   * csv::RowFilter f;
+   * f.equals(3, "FAILED").int_range(0, since, INT64_MAX);
+   * parser.set_filter(f);
+   * @endcode
+   *
+   * Each predicate can also name its column, e.g. `f.equals("status", "FAILED")`;
+   * names are resolved to indices once, against the header row captured by
+   * CsvParser::set_header_row(), or explicitly through resolve().
+   */
+  class RowFilter {
+  public:
+    /// Field equals @p value byte for byte
+    RowFilter &equals(std::size_t col, std::string_view value);
+
+    /// Field starts with @p value
+    RowFilter &prefix(std::size_t col, std::string_view value);
+
+    /// Field equals one of @p values
+    RowFilter &in(std::size_t col, std::vector<std::string> values);
+
+    /// Field parses as an integer within [lo, hi]
+    RowFilter &int_range(std::size_t col, std::int64_t lo, std::int64_t hi);
+
+    /// Field parses as a floating point number within [lo, hi]
+    RowFilter &float_range(std::size_t col, double lo, double hi);
+
+    RowFilter &equals(std::string_view column, std::string_view value);
+    RowFilter &prefix(std::string_view column, std::string_view value);
+    RowFilter &in(std::string_view column, std::vector<std::string> values);
+    RowFilter &int_range(std::string_view column, std::int64_t lo, std::int64_t hi);
+    RowFilter &float_range(std::string_view column, double lo, double hi);
+
+    [[nodiscard]] bool empty() const noexcept { return m_last == kNone && m_named.empty(); }
+
+    /// Whether some predicates still refer to their column by name
+    [[nodiscard]] bool has_names() const noexcept { return !m_named.empty(); }
+
+    /**
+     * @brief Copy of this filter with every column name replaced by its index in @p header.
+     *
+     * @throws CsvError (Einvalid) if a name is not in @p header
+     */
+    [[nodiscard]] RowFilter resolve(const HeaderMap &header) const;
+
+    /// Whether any predicate refers to @p col
+    [[nodiscard]] bool tests(std::size_t col) const noexcept {
+      return col < m_columns.size() && !m_columns[col].empty();
+    }
+
+    /// Highest column with a predicate; rows are decided once it is seen
+    [[nodiscard]] std::size_t last_column() const noexcept { return m_last; }
+
+    /// Evaluates every predicate on @p col against @p field
+    [[nodiscard]] bool matches(std::size_t col, FieldView field) const noexcept;
+
+    /**
+     * @brief Whether block @p zone of @p index may hold a matching row.
+     *
+     * false means no row of the block satisfies every predicate, so the
+     * block need not be parsed. Predicates still naming their column are
+     * not consulted; resolve() them first.
+     *
+     * @throws std::logic_error if @p index has no zone maps
+     * @throws std::out_of_range if @p zone >= index.zones()
+     */
+    [[nodiscard]] bool may_match(const RowIndex &index, std::size_t zone) const;
+
+  private:
+    static constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+    struct Predicate {
+      enum class Kind : unsigned char { Equals, Prefix, In, IntRange, FloatRange };
+      Kind kind;
+      std::string value;
+      std::vector<std::string> values;  // sorted IN-list
+      std::int64_t int_lo = 0;
+      std::int64_t int_hi = 0;
+      double float_lo = 0.0;
+      double float_hi = 0.0;
+    };
+
+    std::vector<std::vector<Predicate>> m_columns;
+    std::size_t m_last = kNone;
+    std::vector<std::pair<std::string, Predicate>> m_named;
+
+    RowFilter &add(std::size_t col, Predicate p);
+    RowFilter &add(std::string_view column, Predicate p);
+
+    static Predicate make(Predicate::Kind kind, std::string_view value);
+    static Predicate make_in(std::vector<std::string> values);
+    static Predicate make_int(std::int64_t lo, std::int64_t hi);
+    static Predicate make_float(double lo, double hi);
+  };
+
+} // namespace csv
+
+#endif // CSV_ROW_FILTER_HPP
@@ -0,0 +1,248 @@
+#ifndef CSV_ROW_INDEX_HPP
+#define CSV_ROW_INDEX_HPP
+
+#include "CsvParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace csv {
+
+  /**
+   * @brief Build settings for RowIndex::build().
+   */
+  struct IndexOptions {
+    /// Record every stride-th row (1 records every row)
+    std::size_t stride = 1024;
+
+    /// Scanning threads; 0 uses the hardware concurrency
+    unsigned threads = 1;
+
+    /**
+     * Also record where every field of every row starts, enabling
+     * RowIndex::field_offset() and CsvParser::read_cell(). Offsets are
+     * delta encoded per row as uint16, or uint32 for rows with a field
+     * of 64 KiB or more. Implies stride 1.
+     */
+    bool field_offsets = false;
+
+    /**
+     * Rows per zone map block; 0 records no zone maps. For every block
+     * and column the index stores the NULL count, the min/max of the
+     * fields that convert to int64 and to double, and bounds on the field
+     * text, so RowFilter::may_match() can rule out whole blocks. Rounded
+     * up to a multiple of the stride, so every block starts at an indexed
+     * row.
+     */
+    std::size_t zone_rows = 0;
+
+    /// Bloom filter bits per column and zone (rounded up to 64); 0 stores none
+    std::size_t bloom_bits = 0;
+  };
+
+
+  /**
+   * @brief Persistent row-offset index of a CSV file (`.csvidx` sidecar).
+   *
+   * build() records the byte offset at which every `stride`-th row starts,
+   * as csv_parse() delimits rows for the given parser setup: quoted fields
+   * spanning several lines are accounted for, and rows are counted as row
+   * callbacks (blank lines only count under Option::RepAllNl). Offsets
+   * point just past the previous row terminator, where a fresh parser
+   * reproduces the remaining rows exactly.
+   *
+   * The sidecar is versioned and records the source size and mtime; open()
+   * maps it read-only and rejects it once the source has changed. Use
+   * CsvParser::seek() to resume parsing at an arbitrary row.
+   *
+   * With zone maps, a filtered query only parses the blocks its filter
+   * may match:
+   *
+   * @code
+   * for (size_t z = 0; z < index.zones(); ++z) {
+   *   if (!filter.may_match(index, z)) continue;
+   *   csv::RowIndex::ZoneSpan span = index.zone_span(z);
+   *   parser.seek(index, fp, span.row);
+   *   // parse span.end - span.begin bytes, then finish()
+   * }
+   * @endcode
+   */
+  class RowIndex {
+  public:
+    /**
+     * @brief Indexed row at or before a requested row.
+     */
+    struct Position {
+      std::uint64_t row;     ///< Row number of the indexed row
+      std::uint64_t offset;  ///< Byte offset where that row starts
+    };
+
+    /**
+     * @brief Rows and bytes covered by one zone map block.
+     */
+    struct ZoneSpan {
+      std::uint64_t row;    ///< First row of the block
+      std::uint64_t rows;   ///< Rows in the block
+      std::uint64_t begin;  ///< Byte offset of the first row
+      std::uint64_t end;    ///< Byte offset just past the last row
+    };
+
+    /**
+     * @brief Summary of one column within one zone map block.
+     *
+     * Fields are the unescaped values a parser with the index settings
+     * reports. The may_*() tests never return false for a block holding
+     * a matching field; text bounds keep at most 16 bytes of the smallest
+     * and largest field.
+     */
+    struct ColumnZone {
+      std::uint64_t nulls = 0;   ///< Empty, NULL (Option::EmptyIsNull) or missing fields
+      std::uint64_t ints = 0;    ///< Fields that convert to int64
+      std::int64_t int_min = 0;
+      std::int64_t int_max = 0;
+      std::uint64_t floats = 0;  ///< Fields that convert to double (NaN excluded)
+      double float_min = 0.0;
+      double float_max = 0.0;
+      bool has_text = false;     ///< Whether any field is not NULL
+      std::string_view text_min;  ///< Prefix of the smallest field
+      std::string_view text_max;  ///< Prefix of the largest field
+      bool text_max_exact = false;  ///< Whether text_max is the whole largest field
+      const unsigned char *bloom = nullptr;
+      std::size_t bloom_bits = 0;
+
+      [[nodiscard]] bool may_equal(std::string_view value) const noexcept;
+      [[nodiscard]] bool may_start_with(std::string_view prefix) const noexcept;
+      [[nodiscard]] bool may_int_range(std::int64_t lo, std::int64_t hi) const noexcept;
+      [[nodiscard]] bool may_float_range(double lo, double hi) const noexcept;
+    };
+
+    /**
+     * @brief Scans @p csv_path and writes the index to @p index_path.
+     *
+     * With several threads the file is split into chunks scanned in
+     * parallel: each chunk first runs speculatively from every parser
+     * state it could start in, then the true start states are chained
+     * from the beginning of the file and the chunks are indexed again.
+     * Zone map blocks are parsed in parallel as well.
+     *
+     * @throws CsvError on parse errors while building zone maps
+     * @throws std::runtime_error on I/O errors
+     */
+    static void build(
+      const std::string &csv_path,
+      const std::string &index_path,
+      const CsvParser &parser,
+      const IndexOptions &options = IndexOptions()
+    );
+
+    /**
+     * @brief Checks that @p index_path was built from the current @p source_path.
+     */
+    [[nodiscard]] static bool is_fresh(const std::string &index_path, const std::string &source_path) noexcept;
+
+    /**
+     * @brief Maps @p index_path after validating it against @p source_path.
+     *
+     * @throws CsvError (Einvalid) if the index is malformed or stale
+     * @throws std::runtime_error if the file cannot be mapped
+     */
+    static RowIndex open(const std::string &index_path, const std::string &source_path);
+
+    RowIndex(RowIndex&&) noexcept;
+    RowIndex& operator=(RowIndex&&) noexcept;
+    ~RowIndex();
+
+    /// Total number of rows in the source file
+    [[nodiscard]] std::uint64_t rows() const noexcept;
+    [[nodiscard]] std::size_t stride() const noexcept;
+
+    /// Number of recorded offsets, ceil(rows() / stride())
+    [[nodiscard]] std::size_t entries() const noexcept;
+
+    /**
+     * @brief Returns the closest indexed row at or before @p row.
+     *
+     * @throws std::out_of_range if @p row >= rows()
+     */
+    [[nodiscard]] Position locate(std::uint64_t row) const;
+
+    /// Whether the index was built with IndexOptions::field_offsets
+    [[nodiscard]] bool has_field_offsets() const noexcept;
+
+    /**
+     * @brief Number of fields in @p row (0 for a blank row under RepAllNl).
+     *
+     * @throws std::logic_error if the index has no field offsets
+     * @throws std::out_of_range if @p row >= rows()
+     */
+    [[nodiscard]] std::size_t fields(std::uint64_t row) const;
+
+    /**
+     * @brief Byte offset where field @p col of @p row starts.
+     *
+     * The first field starts at the row offset; later fields start right
+     * after their delimiter.
+     *
+     * @throws std::logic_error if the index has no field offsets
+     * @throws std::out_of_range if @p row or @p col is out of range
+     */
+    [[nodiscard]] std::uint64_t field_offset(std::uint64_t row, std::size_t col) const;
+
+    /**
+     * @brief Byte offset where the row after @p row starts (source size for the last row).
+     *
+     * @throws std::logic_error if the index does not record every row (stride != 1)
+     * @throws std::out_of_range if @p row >= rows()
+     */
+    [[nodiscard]] std::uint64_t row_end(std::uint64_t row) const;
+
+    [[nodiscard]] unsigned char delimiter() const noexcept;
+    [[nodiscard]] unsigned char quote() const noexcept;
+
+    /// Whether blank lines were counted as rows (Option::RepAllNl)
+    [[nodiscard]] bool counts_blank_lines() const noexcept;
+
+    /// Whether the index was built with IndexOptions::zone_rows
+    [[nodiscard]] bool has_zone_maps() const noexcept;
+
+    /// Rows per zone map block (0 without zone maps)
+    [[nodiscard]] std::size_t zone_rows() const noexcept;
+
+    /// Number of zone map blocks, ceil(rows() / zone_rows())
+    [[nodiscard]] std::size_t zones() const noexcept;
+
+    /// Columns summarized per block: the field count of the widest row
+    [[nodiscard]] std::size_t zone_columns() const noexcept;
+
+    /**
+     * @brief Rows and byte range of block @p zone.
+     *
+     * @throws std::logic_error if the index has no zone maps
+     * @throws std::out_of_range if @p zone >= zones()
+     */
+    [[nodiscard]] ZoneSpan zone_span(std::size_t zone) const;
+
+    /**
+     * @brief Summary of column @p col in block @p zone.
+     *
+     * Columns at or beyond zone_columns() are missing from every row and
+     * summarized as all NULL.
+     *
+     * @throws std::logic_error if the index has no zone maps
+     * @throws std::out_of_range if @p zone >= zones()
+     */
+    [[nodiscard]] ColumnZone zone(std::size_t zone, std::size_t col) const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+
+    RowIndex();
+  };
+
+} // namespace csv
+
+#endif // CSV_ROW_INDEX_HPP
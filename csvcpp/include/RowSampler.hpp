@@ -0,0 +1,117 @@
+#ifndef CSV_ROW_SAMPLER_HPP
+#define CSV_ROW_SAMPLER_HPP
+
+#include "CsvParser.hpp"
+#include "RowIndex.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Draws random rows from a CSV file and parses only those.
+   *
+   * With a RowIndex of the file the sample is exact: row numbers are
+   * drawn uniformly without replacement and located through the index.
+   *
+   * Without one, random byte offsets are drawn and each is moved forward
+   * to the next row start. To find it, the row structure of csv_parse()
+   * is run from every parser state at once until all of them agree,
+   * after which row boundaries are exact. If they still disagree after
+   * 8 KiB (a quoted field that long, or no quote characters at all), the
+   * state with the fewest quoting errors wins, preferring one outside
+   * quotes. A row is then picked with a probability proportional to the
+   * length of the row before it, so the sample is only roughly uniform.
+   *
+   * The file is mapped read-only when the sampler is constructed. With
+   * CsvParser::set_header_row() the header row is never sampled; it is
+   * captured first if the parser has not read it yet.
+   *
+   * @code
+   * csv::RowSampler sampler("big.csv", 42);
+   * sampler.read(parser, 5000, on_field, on_row, &stats);
+   * @endcode
+   */
+  class RowSampler {
+  public:
+    /**
+     * @brief Maps @p path; @p seed makes the samples reproducible.
+     *
+     * @throws std::runtime_error if the file cannot be mapped
+     */
+    explicit RowSampler(const std::string &path, std::uint64_t seed = 0);
+
+    RowSampler(RowSampler&&) noexcept;
+    RowSampler& operator=(RowSampler&&) noexcept;
+    ~RowSampler();
+
+    /// Size of the mapped file in bytes
+    [[nodiscard]] std::uint64_t size() const noexcept;
+
+    /**
+     * @brief Start offsets of @p rows distinct rows drawn uniformly through
+     *        @p index, ascending (every row if the file holds fewer).
+     *
+     * @throws CsvError (Einvalid) if @p index was built with a different
+     *         parser configuration or does not match the file
+     */
+    [[nodiscard]] std::vector<std::uint64_t> locate(const CsvParser &parser, const RowIndex &index, std::uint64_t rows);
+
+    /**
+     * @brief Start offsets of up to @p rows distinct rows found from random
+     *        byte offsets, ascending.
+     *
+     * Fewer rows are returned when repeated draws keep landing on rows
+     * already taken, as they do once @p rows nears the rows in the file.
+     */
+    [[nodiscard]] std::vector<std::uint64_t> locate(const CsvParser &parser, std::uint64_t rows);
+
+    /**
+     * @brief Parses the rows locate(parser, index, rows) returns, in file
+     *        order, and finishes @p parser.
+     *
+     * Any partial row in @p parser is discarded. Projection and filters
+     * apply as usual.
+     *
+     * @return Number of rows parsed
+     *
+     * @throws CsvError (Einvalid) on an index mismatch
+     * @throws CsvError on parse errors in the sampled rows
+     */
+    std::uint64_t read(
+      CsvParser &parser,
+      const RowIndex &index,
+      std::uint64_t rows,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    );
+
+    /**
+     * @brief Parses the rows locate(parser, rows) returns, in file order,
+     *        and finishes @p parser.
+     *
+     * @return Number of rows parsed
+     *
+     * @throws CsvError on parse errors in the sampled rows
+     */
+    std::uint64_t read(
+      CsvParser &parser,
+      std::uint64_t rows,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    );
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+  };
+
+} // namespace csv
+
+#endif // CSV_ROW_SAMPLER_HPP
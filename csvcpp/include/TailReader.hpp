@@ -0,0 +1,81 @@
+#ifndef CSV_TAIL_READER_HPP
+#define CSV_TAIL_READER_HPP
+
+#include "CsvParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace csv {
+
+  /**
+   * @brief Reads the last rows of a CSV file without scanning it from the start.
+   *
+   * The file is mapped read-only when the reader is constructed; construct
+   * a new reader to observe data appended later.
+   *
+   * Rows are located by walking backwards from the end of the file: a line
+   * terminator followed by an even number of quote characters is taken as
+   * a row boundary, which is exact as long as quote characters only appear
+   * in quoted fields. The boundary is then verified by running the row
+   * structure of csv_parse() forward from an earlier boundary, up to 64 KiB
+   * before it. If the verification fails, or the file ends inside a quoted
+   * field, the rows are located by a forward scan of the whole file.
+   *
+   * With CsvParser::set_header_row() the header row is never part of the
+   * tail; it is captured first if the parser has not read it yet.
+   */
+  class TailReader {
+  public:
+    /**
+     * @brief Maps @p path.
+     *
+     * @throws std::runtime_error if the file cannot be mapped
+     */
+    explicit TailReader(const std::string &path);
+
+    TailReader(TailReader&&) noexcept;
+    TailReader& operator=(TailReader&&) noexcept;
+    ~TailReader();
+
+    /// Size of the mapped file in bytes
+    [[nodiscard]] std::uint64_t size() const noexcept;
+
+    /**
+     * @brief Byte offset where the last @p rows rows start, as rows are
+     *        delimited by @p parser (size() when @p rows is 0).
+     *
+     * Rows are counted as row callbacks: blank lines only count under
+     * Option::RepAllNl. The offset of the first row is returned if the
+     * file holds fewer rows.
+     */
+    [[nodiscard]] std::uint64_t locate(const CsvParser &parser, std::uint64_t rows) const;
+
+    /**
+     * @brief Parses the last @p rows rows with @p parser and finishes it.
+     *
+     * Any partial row in @p parser is discarded. Projection and filters
+     * apply as usual.
+     *
+     * @return Number of rows parsed, at most @p rows
+     *
+     * @throws CsvError on parse errors in the tail
+     */
+    std::uint64_t read(
+      CsvParser &parser,
+      std::uint64_t rows,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    ) const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+  };
+
+} // namespace csv
+
+#endif // CSV_TAIL_READER_HPP
@@ -0,0 +1,148 @@
+#ifndef CSV_TEXT_INDEX_HPP
+#define CSV_TEXT_INDEX_HPP
+
+#include "CsvParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Build settings for TextIndex::build().
+   */
+  struct TextIndexOptions {
+    /// Columns whose tokens are indexed; empty indexes every column
+    std::vector<std::size_t> columns;
+
+    /// Whether the first row is a header; it is not indexed
+    bool header_row = false;
+
+    /// Keep ASCII letter case in tokens (folded to lower case by default)
+    bool case_sensitive = false;
+  };
+
+
+  /**
+   * @brief Full-text inverted index of a CSV file (`.csvtxt` sidecar).
+   *
+   * build() tokenizes the selected columns of every row in one pass over
+   * the file and writes a sorted token dictionary with, per token, the
+   * byte offsets of the rows containing it. Offsets are delta encoded as
+   * LEB128 varints, so frequent tokens cost about one byte per row.
+   *
+   * A token is a maximal run of ASCII letters and digits or bytes of 0x80
+   * and above (so UTF-8 text stays intact); everything else separates
+   * tokens. Queries are tokenized the same way and match rows holding
+   * every query token in an indexed column. open() rejects a sidecar
+   * whose source file has changed; the build settings are kept in the
+   * sidecar so built_with() can tell whether it fits a request.
+   *
+   * @code
+   * csv::TextIndex::build("tickets.csv", "tickets.csvtxt", parser, {{3, 4}, true});
+   * csv::TextIndex text = csv::TextIndex::open("tickets.csvtxt", "tickets.csv");
+   * text.lookup(parser, "timeout gateway", on_field, on_row, &ctx);
+   * @endcode
+   */
+  class TextIndex {
+  public:
+    /**
+     * @brief Tokenizes @p csv_path into @p index_path.
+     *
+     * @throws CsvError on parse errors
+     * @throws std::runtime_error on I/O errors
+     */
+    static void build(
+      const std::string &csv_path,
+      const std::string &index_path,
+      const CsvParser &parser,
+      const TextIndexOptions &options = TextIndexOptions()
+    );
+
+    /**
+     * @brief Checks that @p index_path was built from the current @p source_path.
+     */
+    [[nodiscard]] static bool is_fresh(const std::string &index_path, const std::string &source_path) noexcept;
+
+    /**
+     * @brief Maps @p index_path and @p source_path after checking the index is current.
+     *
+     * @throws CsvError (Einvalid) if the index is malformed or stale
+     * @throws std::runtime_error if a file cannot be mapped
+     */
+    static TextIndex open(const std::string &index_path, const std::string &source_path);
+
+    /**
+     * @brief Splits @p text into tokens as the index does.
+     */
+    [[nodiscard]] static std::vector<std::string> tokenize(std::string_view text, bool case_sensitive = false);
+
+    TextIndex(TextIndex&&) noexcept;
+    TextIndex& operator=(TextIndex&&) noexcept;
+    ~TextIndex();
+
+    /// Rows in the source file, a header row included
+    [[nodiscard]] std::uint64_t rows() const noexcept;
+
+    /// Number of distinct tokens
+    [[nodiscard]] std::size_t tokens() const noexcept;
+
+    [[nodiscard]] bool case_sensitive() const noexcept;
+
+    /// Indexed columns, ascending and without duplicates; empty if every column is
+    [[nodiscard]] const std::vector<std::size_t> &columns() const noexcept;
+
+    /// Whether the first row was treated as a header and left out
+    [[nodiscard]] bool header_row() const noexcept;
+
+    /**
+     * @brief Whether build() was given settings equivalent to @p options.
+     *
+     * An index built for other columns, header or case handling answers
+     * queries differently; callers reusing a sidecar rebuild it when this
+     * returns false.
+     */
+    [[nodiscard]] bool built_with(const TextIndexOptions &options) const;
+
+    /**
+     * @brief Start offsets of the rows holding every token of @p query, ascending.
+     *
+     * A query without tokens matches nothing.
+     */
+    [[nodiscard]] std::vector<std::uint64_t> find(std::string_view query) const;
+
+    /**
+     * @brief Parses the rows find() returns for @p query, in file order.
+     *
+     * Each row is fed to @p parser, so its projection and filter apply,
+     * and the parser is finished afterwards. With set_header_row(), a
+     * header not captured yet is parsed first.
+     *
+     * @return Number of rows parsed
+     *
+     * @throws CsvError (Einvalid) if @p parser's delimiter, quote or
+     *         Option::RepAllNl differ from the index
+     * @throws CsvError on parse errors
+     */
+    std::size_t lookup(
+      CsvParser &parser,
+      std::string_view query,
+      void (*cb1)(void *, std::size_t, void *),
+      void (*cb2)(int, void *),
+      void *data
+    ) const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_pimpl;
+
+    TextIndex();
+  };
+
+} // namespace csv
+
+#endif // CSV_TEXT_INDEX_HPP
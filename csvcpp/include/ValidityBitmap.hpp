@@ -0,0 +1,118 @@
+#ifndef CSV_VALIDITY_BITMAP_HPP
+#define CSV_VALIDITY_BITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace csv {
+
+  /**
+   * @brief Minimal allocator returning storage aligned to @p Align bytes.
+   */
+  template <typename T, std::size_t Align>
+  struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align> &) noexcept {}
+
+    T *allocate(std::size_t n) {
+      return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    void deallocate(T *p, std::size_t) noexcept {
+      ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Align> &) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Align> &) const noexcept { return false; }
+  };
+
+
+  /**
+   * @brief Packed validity bitmap, one bit per value, set = valid.
+   *
+   * Bits are stored in 64-bit words on 64-byte aligned storage, so consumers
+   * can process nulls a word at a time with popcount and masks. On
+   * little-endian hosts the byte view returned by bytes() is bit-for-bit
+   * the Arrow validity bitmap layout. Bits past size() are always zero.
+   */
+  class ValidityBitmap {
+  public:
+    static constexpr std::size_t kAlignment = 64;
+
+    void push_back(bool valid) {
+      if (m_size % 64 == 0) m_words.push_back(0);
+      if (valid) m_words.back() |= std::uint64_t{1} << (m_size % 64);
+      else ++m_nulls;
+      ++m_size;
+    }
+
+    /// Drops the last value
+    void pop_back() noexcept {
+      --m_size;
+      if (!test(m_size)) --m_nulls;
+      if (m_size % 64 == 0) m_words.pop_back();
+      else m_words.back() &= ~(std::uint64_t{1} << (m_size % 64));
+    }
+
+    void clear() noexcept {
+      m_words.clear();
+      m_size = 0;
+      m_nulls = 0;
+    }
+
+    void reserve(std::size_t bits) { m_words.reserve((bits + 63) / 64); }
+
+    [[nodiscard]] bool test(std::size_t i) const noexcept {
+      return (m_words[i / 64] >> (i % 64)) & 1;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+    /// Number of cleared (null) bits, maintained incrementally
+    [[nodiscard]] std::size_t null_count() const noexcept { return m_nulls; }
+
+    /// Number of nulls among bits [first, last)
+    [[nodiscard]] std::size_t null_count(std::size_t first, std::size_t last) const noexcept {
+      const std::size_t total = last - first;
+      std::size_t valid = 0;
+      while (first < last && first % 64 != 0) valid += test(first++);
+      for (; first + 64 <= last; first += 64) valid += popcount(m_words[first / 64]);
+      while (first < last) valid += test(first++);
+      return total - valid;
+    }
+
+    [[nodiscard]] const std::uint64_t *words() const noexcept { return m_words.data(); }
+    [[nodiscard]] std::size_t word_count() const noexcept { return m_words.size(); }
+    [[nodiscard]] const std::uint8_t *bytes() const noexcept {
+      return reinterpret_cast<const std::uint8_t *>(m_words.data());
+    }
+
+  private:
+    std::vector<std::uint64_t, AlignedAllocator<std::uint64_t, kAlignment>> m_words;
+    std::size_t m_size = 0;
+    std::size_t m_nulls = 0;
+
+    static unsigned popcount(std::uint64_t w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_popcountll(w));
+#else
+      unsigned n = 0;
+      for (; w; w &= w - 1) ++n;
+      return n;
+#endif
+    }
+  };
+
+} // namespace csv
+
+#endif // CSV_VALIDITY_BITMAP_HPP
@@ -0,0 +1,253 @@
+#include "BlobDecoder.hpp"
+
+#include "CsvParser.hpp"
+#include "FieldView.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace csv {
+  namespace {
+
+    constexpr unsigned char kInvalid = 0xFF;
+
+    struct DecodeTables {
+      unsigned char hex[256];
+      unsigned char base64[256];
+
+      constexpr DecodeTables() : hex(), base64() {
+        for (int i = 0; i < 256; ++i) hex[i] = base64[i] = kInvalid;
+        for (int i = 0; i < 10; ++i) hex['0' + i] = static_cast<unsigned char>(i);
+        for (int i = 0; i < 6; ++i) {
+          hex['a' + i] = static_cast<unsigned char>(10 + i);
+          hex['A' + i] = static_cast<unsigned char>(10 + i);
+        }
+        for (int i = 0; i < 26; ++i) {
+          base64['A' + i] = static_cast<unsigned char>(i);
+          base64['a' + i] = static_cast<unsigned char>(26 + i);
+        }
+        for (int i = 0; i < 10; ++i) base64['0' + i] = static_cast<unsigned char>(52 + i);
+        base64['+'] = 62;
+        base64['/'] = 63;
+      }
+    };
+
+    constexpr DecodeTables g_tables;
+
+    [[noreturn]] void throw_invalid(const char *what) {
+      throw CsvError(std::string("CSV Decode Error: ") + what, CsvError::ErrorType::Econvert);
+    }
+
+    void check_capacity(std::size_t needed, std::size_t out_size) {
+      if (out_size < needed) {
+        throw CsvError("CSV Decode Error: output buffer too small", CsvError::ErrorType::Einvalid);
+      }
+    }
+
+#if defined(__SSE2__)
+    // Unsigned "x <= n" per byte
+    inline __m128i le_epu8(__m128i x, char n) {
+      const __m128i vn = _mm_set1_epi8(n);
+      return _mm_cmpeq_epi8(_mm_max_epu8(x, vn), vn);
+    }
+
+    // Translates 16 hex digits to nibbles; false if any byte is not a digit
+    inline bool hex_nibbles(__m128i c, __m128i &v) {
+      const __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+      const __m128i a = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+      const __m128i is_d = le_epu8(d, 9);
+      const __m128i is_a = le_epu8(a, 5);
+      v = _mm_or_si128(_mm_and_si128(is_d, d),
+                       _mm_and_si128(is_a, _mm_add_epi8(a, _mm_set1_epi8(10))));
+      return _mm_movemask_epi8(_mm_or_si128(is_d, is_a)) == 0xFFFF;
+    }
+
+    // Joins nibble pairs into bytes held in the low half of each 16-bit lane
+    inline __m128i hex_join(__m128i v) {
+      const __m128i hi = _mm_and_si128(v, _mm_set1_epi16(0x00FF));
+      return _mm_or_si128(_mm_slli_epi16(hi, 4), _mm_srli_epi16(v, 8));
+    }
+
+    // Translates 16 base64 characters to sextets; false on any other byte, '=' included
+    inline bool base64_sextets(__m128i c, __m128i &v) {
+      const __m128i u = _mm_sub_epi8(c, _mm_set1_epi8('A'));
+      const __m128i l = _mm_sub_epi8(c, _mm_set1_epi8('a'));
+      const __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+      const __m128i is_u = le_epu8(u, 25);
+      const __m128i is_l = le_epu8(l, 25);
+      const __m128i is_d = le_epu8(d, 9);
+      const __m128i is_p = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+      const __m128i is_s = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+      v = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(is_u, u), _mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(26)))),
+        _mm_or_si128(_mm_and_si128(is_d, _mm_add_epi8(d, _mm_set1_epi8(52))),
+                     _mm_or_si128(_mm_and_si128(is_p, _mm_set1_epi8(62)),
+                                  _mm_and_si128(is_s, _mm_set1_epi8(63)))));
+      const __m128i ok = _mm_or_si128(_mm_or_si128(is_u, is_l), _mm_or_si128(is_d, _mm_or_si128(is_p, is_s)));
+      return _mm_movemask_epi8(ok) == 0xFFFF;
+    }
+#endif
+
+    // Decodes an even number of hex digits
+    std::size_t hex_block(const char *in, std::size_t len, unsigned char *out) {
+      std::size_t i = 0;
+#if defined(__SSE2__)
+      for (; i + 32 <= len; i += 32) {
+        __m128i v0, v1;
+        const bool ok0 = hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), v0);
+        const bool ok1 = hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 16)), v1);
+        if (!(ok0 && ok1)) throw_invalid("invalid hex digit");
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i / 2),
+                         _mm_packus_epi16(hex_join(v0), hex_join(v1)));
+      }
+#endif
+      for (; i < len; i += 2) {
+        const unsigned char hi = g_tables.hex[static_cast<unsigned char>(in[i])];
+        const unsigned char lo = g_tables.hex[static_cast<unsigned char>(in[i + 1])];
+        if (hi == kInvalid || lo == kInvalid) throw_invalid("invalid hex digit");
+        out[i / 2] = static_cast<unsigned char>((hi << 4) | lo);
+      }
+      return len / 2;
+    }
+
+    // Decodes one quantum; sets @p padded if it ends with '='
+    std::size_t base64_quantum(const char *q, unsigned char *out, bool &padded) {
+      const unsigned char a = g_tables.base64[static_cast<unsigned char>(q[0])];
+      const unsigned char b = g_tables.base64[static_cast<unsigned char>(q[1])];
+      if (a == kInvalid || b == kInvalid) throw_invalid("invalid base64 character");
+      out[0] = static_cast<unsigned char>((a << 2) | (b >> 4));
+      if (q[2] == '=') {
+        if (q[3] != '=') throw_invalid("misplaced base64 padding");
+        padded = true;
+        return 1;
+      }
+      const unsigned char c = g_tables.base64[static_cast<unsigned char>(q[2])];
+      if (c == kInvalid) throw_invalid("invalid base64 character");
+      out[1] = static_cast<unsigned char>((b << 4) | (c >> 2));
+      if (q[3] == '=') {
+        padded = true;
+        return 2;
+      }
+      const unsigned char d = g_tables.base64[static_cast<unsigned char>(q[3])];
+      if (d == kInvalid) throw_invalid("invalid base64 character");
+      out[2] = static_cast<unsigned char>((c << 6) | d);
+      return 3;
+    }
+
+    // Decodes whole quanta; padding may only appear in the last one
+    std::size_t base64_block(const char *in, std::size_t len, unsigned char *out, bool &padded) {
+      std::size_t i = 0;
+      std::size_t n = 0;
+#if defined(__SSE2__)
+      for (; i + 16 <= len; i += 16, n += 12) {
+        __m128i v;
+        if (!base64_sextets(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), v)) break;
+        // 16-bit lanes: a|b<<8 -> a<<6|b; 32-bit lanes: ab|cd<<16 -> ab<<12|cd
+        const __m128i ab = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00FF)), 6),
+                                        _mm_srli_epi16(v, 8));
+        const __m128i abcd = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(ab, _mm_set1_epi32(0xFFFF)), 12),
+                                          _mm_srli_epi32(ab, 16));
+        alignas(16) std::uint32_t w[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(w), abcd);
+        for (int k = 0; k < 4; ++k) {
+          out[n + 3 * k]     = static_cast<unsigned char>(w[k] >> 16);
+          out[n + 3 * k + 1] = static_cast<unsigned char>(w[k] >> 8);
+          out[n + 3 * k + 2] = static_cast<unsigned char>(w[k]);
+        }
+      }
+#endif
+      for (; i < len; i += 4) {
+        if (padded) throw_invalid("data after base64 padding");
+        n += base64_quantum(in + i, out + n, padded);
+      }
+      return n;
+    }
+
+  } // namespace
+
+  std::size_t HexDecoder::update(const char *in, std::size_t len, void *out, std::size_t out_size) {
+    check_capacity(max_output(len), out_size);
+    auto *dst = static_cast<unsigned char *>(out);
+    std::size_t n = 0;
+    if (m_pending >= 0 && len > 0) {
+      const unsigned char lo = g_tables.hex[static_cast<unsigned char>(*in)];
+      if (lo == kInvalid) throw_invalid("invalid hex digit");
+      dst[n++] = static_cast<unsigned char>((m_pending << 4) | lo);
+      m_pending = -1;
+      ++in;
+      --len;
+    }
+    n += hex_block(in, len & ~std::size_t{1}, dst + n);
+    if (len & 1) {
+      const unsigned char hi = g_tables.hex[static_cast<unsigned char>(in[len - 1])];
+      if (hi == kInvalid) throw_invalid("invalid hex digit");
+      m_pending = hi;
+    }
+    return n;
+  }
+
+  void HexDecoder::finish() {
+    const bool dangling = m_pending >= 0;
+    m_pending = -1;
+    if (dangling) throw_invalid("odd number of hex digits");
+  }
+
+  std::size_t Base64Decoder::update(const char *in, std::size_t len, void *out, std::size_t out_size) {
+    if (len == 0) return 0;
+    if (m_done) throw_invalid("data after base64 padding");
+    check_capacity(max_output(len), out_size);
+    auto *dst = static_cast<unsigned char *>(out);
+    std::size_t n = 0;
+    if (m_pending > 0) {
+      while (m_pending < 4 && len > 0) {
+        m_quantum[m_pending++] = *in++;
+        --len;
+      }
+      if (m_pending < 4) return 0;
+      m_pending = 0;
+      n += base64_quantum(m_quantum, dst, m_done);
+      if (m_done && len > 0) throw_invalid("data after base64 padding");
+    }
+    const std::size_t whole = len & ~std::size_t{3};
+    n += base64_block(in, whole, dst + n, m_done);
+    if (m_done && whole < len) throw_invalid("data after base64 padding");
+    m_pending = len - whole;
+    std::memcpy(m_quantum, in + whole, m_pending);
+    return n;
+  }
+
+  std::size_t Base64Decoder::finish(void *out, std::size_t out_size) {
+    const std::size_t pending = m_pending;
+    m_pending = 0;
+    m_done = false;
+    if (pending == 0) return 0;
+    if (pending == 1) throw_invalid("truncated base64 quantum");
+    check_capacity(pending - 1, out_size);
+    // Unpadded final quantum: decode it as if the padding were present
+    for (std::size_t i = pending; i < 4; ++i) m_quantum[i] = '=';
+    unsigned char bytes[3];
+    bool padded = false;
+    const std::size_t n = base64_quantum(m_quantum, bytes, padded);
+    std::memcpy(out, bytes, n);
+    return n;
+  }
+
+  std::size_t FieldView::decode_hex(void *out, std::size_t out_size) const {
+    HexDecoder decoder;
+    const std::size_t n = decoder.update(m_data, m_size, out, out_size);
+    decoder.finish();
+    return n;
+  }
+
+  std::size_t FieldView::decode_base64(void *out, std::size_t out_size) const {
+    check_capacity(base64_size(), out_size);
+    Base64Decoder decoder;
+    const std::size_t n = decoder.update(m_data, m_size, out, out_size);
+    return n + decoder.finish(static_cast<unsigned char *>(out) + n, out_size - n);
+  }
+
+} // namespace csv
@@ -0,0 +1,99 @@
+#ifndef CSV_CLASSIFY_HPP
+#define CSV_CLASSIFY_HPP
+
+#include "csv.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Internal: 64-byte block classification into structural bit masks,
+// shared by RowCounter and the SIMD tokenizer engine.
+
+namespace csv {
+  namespace detail {
+
+    constexpr std::size_t kClassifyBlock = 64;
+
+    inline unsigned lowest_bit(std::uint64_t w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctzll(w));
+#else
+      unsigned n = 0;
+      for (; !(w & 1); w >>= 1) ++n;
+      return n;
+#endif
+    }
+
+    inline unsigned popcount(std::uint64_t w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_popcountll(w));
+#else
+      unsigned n = 0;
+      for (; w; w &= w - 1) ++n;
+      return n;
+#endif
+    }
+
+    /// Bit i is set when byte i of the block is of that class
+    struct Masks {
+      std::uint64_t quote;
+      std::uint64_t delim;
+      std::uint64_t term;   // CR or LF
+      std::uint64_t space;  // space or tab
+    };
+
+#if defined(__SSE2__)
+    inline std::uint64_t movemask(__m128i a, __m128i b, __m128i c, __m128i d) noexcept {
+      return static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(a))) |
+             static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(b))) << 16 |
+             static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(c))) << 32 |
+             static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(d))) << 48;
+    }
+#endif
+
+    /// Classifies the kClassifyBlock bytes at @p p (SSE2 where available)
+    inline Masks classify(const unsigned char *p, unsigned char quote, unsigned char delim) noexcept {
+#if defined(__SSE2__)
+      const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+      const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+      const __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 48));
+      auto eq = [&](unsigned char c) {
+        const __m128i k = _mm_set1_epi8(static_cast<char>(c));
+        return movemask(_mm_cmpeq_epi8(v0, k), _mm_cmpeq_epi8(v1, k),
+                        _mm_cmpeq_epi8(v2, k), _mm_cmpeq_epi8(v3, k));
+      };
+      return Masks{eq(quote), eq(delim), eq(CSV_CR) | eq(CSV_LF), eq(CSV_SPACE) | eq(CSV_TAB)};
+#else
+      Masks m{0, 0, 0, 0};
+      for (std::size_t i = 0; i < kClassifyBlock; ++i) {
+        const std::uint64_t bit = std::uint64_t{1} << i;
+        const unsigned char c = p[i];
+        if (c == quote) m.quote |= bit;
+        if (c == delim) m.delim |= bit;
+        if (c == CSV_CR || c == CSV_LF) m.term |= bit;
+        if (c == CSV_SPACE || c == CSV_TAB) m.space |= bit;
+      }
+      return m;
+#endif
+    }
+
+    /// Whether the masks of classify() describe this parser setup
+    inline bool default_classes(const struct csv_parser &p) noexcept {
+      auto space = [&](unsigned char c) { return p.is_space ? p.is_space(c) != 0 : c == CSV_SPACE || c == CSV_TAB; };
+      auto term = [&](unsigned char c) { return p.is_term ? p.is_term(c) != 0 : c == CSV_CR || c == CSV_LF; };
+      for (int i = 0; i < 256; ++i) {
+        const auto c = static_cast<unsigned char>(i);
+        if (space(c) != (c == CSV_SPACE || c == CSV_TAB) || term(c) != (c == CSV_CR || c == CSV_LF)) return false;
+      }
+      return p.quote_char != p.delim_char && !term(p.delim_char) && !term(p.quote_char) && !space(p.quote_char);
+    }
+
+  } // namespace detail
+} // namespace csv
+
+#endif // CSV_CLASSIFY_HPP
@@ -0,0 +1,326 @@
+#include "ColumnBuilder.hpp"
+
+#include "CsvBinding.hpp"
+
+#include <limits>
+#include <utility>
+
+namespace csv {
+  namespace {
+
+    const char *arrow_format(ColumnType type) noexcept {
+      switch (type) {
+        case ColumnType::Int64:   return "l";
+        case ColumnType::Float64: return "g";
+        case ColumnType::Bool:    return "b";
+        case ColumnType::Utf8:    return "u";
+      }
+      return "n";
+    }
+
+    // Arrow requires non-null data buffers even when they are empty
+    const char g_empty_buffer[8] = {};
+
+    struct Column {
+      ColumnType type;
+      ValidityBitmap validity;
+      std::vector<std::int64_t> ints;
+      std::vector<double> doubles;
+      ValidityBitmap bools;  // packed boolean values, same layout as validity
+      std::vector<std::int32_t> offsets{0};
+      std::vector<char> chars;
+      const void *buffers[3] = {};
+
+      explicit Column(ColumnType t) : type(t) {}
+
+      [[nodiscard]] std::int64_t length() const noexcept {
+        return static_cast<std::int64_t>(validity.size());
+      }
+
+      void append_null() {
+        switch (type) {
+          case ColumnType::Int64:   ints.push_back(0); break;
+          case ColumnType::Float64: doubles.push_back(0.0); break;
+          case ColumnType::Bool:    bools.push_back(false); break;
+          case ColumnType::Utf8:    offsets.push_back(offsets.back()); break;
+        }
+        validity.push_back(false);
+      }
+
+      // Returns false if the field does not match the column type
+      bool append(const char *s, std::size_t len) {
+        if (s == nullptr || (len == 0 && type != ColumnType::Utf8)) {
+          append_null();
+          return true;
+        }
+        bool ok = true;
+        switch (type) {
+          case ColumnType::Int64: {
+            std::int64_t v = 0;
+            ok = FieldConverter<std::int64_t>::convert(s, len, v);
+            ints.push_back(v);
+            break;
+          }
+          case ColumnType::Float64: {
+            double v = 0.0;
+            ok = FieldConverter<double>::convert(s, len, v);
+            doubles.push_back(v);
+            break;
+          }
+          case ColumnType::Bool: {
+            bool v = false;
+            ok = FieldConverter<bool>::convert(s, len, v);
+            bools.push_back(v);
+            break;
+          }
+          case ColumnType::Utf8: {
+            // int32 offsets cap a column at 2 GiB; a field past that fails it with Econvert
+            ok = chars.size() + len <= static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max());
+            if (ok) chars.insert(chars.end(), s, s + len);
+            offsets.push_back(static_cast<std::int32_t>(chars.size()));
+            break;
+          }
+        }
+        validity.push_back(ok);
+        return ok;
+      }
+
+      // Moves the last value, a field of the row still being parsed, into @p to
+      void move_last_to(Column &to) {
+        const std::size_t i = validity.size() - 1;
+        switch (type) {
+          case ColumnType::Int64:
+            to.ints.push_back(ints.back());
+            ints.pop_back();
+            break;
+          case ColumnType::Float64:
+            to.doubles.push_back(doubles.back());
+            doubles.pop_back();
+            break;
+          case ColumnType::Bool:
+            to.bools.push_back(bools.test(i));
+            bools.pop_back();
+            break;
+          case ColumnType::Utf8: {
+            const auto begin = chars.begin() + offsets[i];
+            to.chars.insert(to.chars.end(), begin, chars.end());
+            to.offsets.push_back(static_cast<std::int32_t>(to.chars.size()));
+            chars.erase(begin, chars.end());
+            offsets.pop_back();
+            break;
+          }
+        }
+        to.validity.push_back(validity.test(i));
+        validity.pop_back();
+      }
+
+      std::int64_t fill_buffers() noexcept {
+        buffers[0] = validity.empty() ? g_empty_buffer : static_cast<const void *>(validity.bytes());
+        switch (type) {
+          case ColumnType::Int64:
+            buffers[1] = ints.empty() ? g_empty_buffer : static_cast<const void *>(ints.data());
+            return 2;
+          case ColumnType::Float64:
+            buffers[1] = doubles.empty() ? g_empty_buffer : static_cast<const void *>(doubles.data());
+            return 2;
+          case ColumnType::Bool:
+            buffers[1] = bools.empty() ? g_empty_buffer : static_cast<const void *>(bools.bytes());
+            return 2;
+          case ColumnType::Utf8:
+            buffers[1] = offsets.data();
+            buffers[2] = chars.empty() ? g_empty_buffer : static_cast<const void *>(chars.data());
+            return 3;
+        }
+        return 1;
+      }
+    };
+
+    struct StructPrivate {
+      std::vector<ArrowArray> child_storage;
+      std::vector<ArrowArray *> children;
+      const void *buffers[1] = {nullptr};
+    };
+
+    struct SchemaPrivate {
+      std::string format;
+      std::string name;
+      std::vector<ArrowSchema> child_storage;
+      std::vector<ArrowSchema *> children;
+    };
+
+    void release_column(ArrowArray *array) {
+      delete static_cast<Column *>(array->private_data);
+      array->release = nullptr;
+    }
+
+    void release_struct(ArrowArray *array) {
+      auto *priv = static_cast<StructPrivate *>(array->private_data);
+      for (ArrowArray *child : priv->children) {
+        if (child->release) child->release(child);
+      }
+      delete priv;
+      array->release = nullptr;
+    }
+
+    void release_schema(ArrowSchema *schema) {
+      auto *priv = static_cast<SchemaPrivate *>(schema->private_data);
+      for (ArrowSchema *child : priv->children) {
+        if (child->release) child->release(child);
+      }
+      delete priv;
+      schema->release = nullptr;
+    }
+
+    void init_schema(ArrowSchema *schema, std::string format, std::string name, std::int64_t flags) {
+      auto *priv = new SchemaPrivate{std::move(format), std::move(name), {}, {}};
+      schema->format = priv->format.c_str();
+      schema->name = priv->name.c_str();
+      schema->metadata = nullptr;
+      schema->flags = flags;
+      schema->n_children = 0;
+      schema->children = nullptr;
+      schema->dictionary = nullptr;
+      schema->release = release_schema;
+      schema->private_data = priv;
+    }
+
+  } // namespace
+
+  struct ColumnBuilder::impl {
+    std::vector<ColumnSpec> m_specs;
+    std::vector<Column> m_columns;
+    std::size_t m_col = 0;
+    std::size_t m_rows = 0;
+    bool m_failed = false;
+    std::size_t m_err_row = 0;
+    std::size_t m_err_col = 0;
+
+    void reset_columns() {
+      m_columns.clear();
+      m_columns.reserve(m_specs.size());
+      for (const ColumnSpec &spec : m_specs) m_columns.emplace_back(spec.type);
+    }
+
+    void check_error() {
+      if (!m_failed) return;
+      m_failed = false;
+      throw CsvError("CSV Column Error: cannot convert field " + std::to_string(m_err_col) +
+                         " of row " + std::to_string(m_err_row) + " to column '" +
+                         m_specs[m_err_col].name + "'",
+                     CsvError::ErrorType::Econvert);
+    }
+  };
+
+  ColumnBuilder::ColumnBuilder(std::vector<ColumnSpec> columns)
+      : m_pimpl(std::make_unique<impl>()) {
+    if (columns.empty()) {
+      throw CsvError("CSV Column Error: empty column layout", CsvError::ErrorType::Einvalid);
+    }
+    m_pimpl->m_specs = std::move(columns);
+    m_pimpl->reset_columns();
+  }
+
+  ColumnBuilder::~ColumnBuilder() = default;
+
+  void ColumnBuilder::on_field(void *s, size_t len, void *data) {
+    auto *d = static_cast<impl *>(data);
+    if (d->m_col < d->m_columns.size() &&
+        !d->m_columns[d->m_col].append(static_cast<const char *>(s), len) && !d->m_failed) {
+      d->m_failed = true;
+      d->m_err_row = d->m_rows;
+      d->m_err_col = d->m_col;
+    }
+    ++d->m_col;
+  }
+
+  void ColumnBuilder::on_row(int, void *data) {
+    auto *d = static_cast<impl *>(data);
+    if (d->m_col == 0) return;  // blank line reported under RepAllNl
+    for (size_t c = d->m_col; c < d->m_columns.size(); ++c) {
+      d->m_columns[c].append_null();
+    }
+    d->m_col = 0;
+    ++d->m_rows;
+  }
+
+  size_t ColumnBuilder::parse(CsvParser &parser, const void *s, size_t len) {
+    size_t n = parser.parse(s, len, on_field, on_row, m_pimpl.get());
+    m_pimpl->check_error();
+    return n;
+  }
+
+  void ColumnBuilder::finish(CsvParser &parser) {
+    parser.finish(on_field, on_row, m_pimpl.get());
+    m_pimpl->check_error();
+  }
+
+  size_t ColumnBuilder::rows() const noexcept {
+    return m_pimpl->m_rows;
+  }
+
+  size_t ColumnBuilder::columns() const noexcept {
+    return m_pimpl->m_specs.size();
+  }
+
+  const ColumnSpec &ColumnBuilder::spec(size_t col) const {
+    return m_pimpl->m_specs.at(col);
+  }
+
+  void ColumnBuilder::export_arrow(ArrowArray *out_array, ArrowSchema *out_schema) {
+    const size_t ncols = m_pimpl->m_columns.size();
+
+    // Fields of a row that is still being parsed stay in the builder
+    std::vector<Column> pending;
+    pending.reserve(ncols);
+    for (size_t c = 0; c < ncols; ++c) {
+      pending.emplace_back(m_pimpl->m_specs[c].type);
+      if (c < m_pimpl->m_col) m_pimpl->m_columns[c].move_last_to(pending.back());
+    }
+
+    auto array_priv = std::make_unique<StructPrivate>();
+    array_priv->child_storage.resize(ncols);
+    array_priv->children.resize(ncols);
+
+    init_schema(out_schema, "+s", "", 0);
+    auto *schema_priv = static_cast<SchemaPrivate *>(out_schema->private_data);
+    schema_priv->child_storage.resize(ncols);
+    schema_priv->children.resize(ncols);
+
+    for (size_t c = 0; c < ncols; ++c) {
+      auto *column = new Column(std::move(m_pimpl->m_columns[c]));
+      ArrowArray &child = array_priv->child_storage[c];
+      child.length = column->length();
+      child.null_count = static_cast<std::int64_t>(column->validity.null_count());
+      child.offset = 0;
+      child.n_buffers = column->fill_buffers();
+      child.n_children = 0;
+      child.buffers = column->buffers;
+      child.children = nullptr;
+      child.dictionary = nullptr;
+      child.release = release_column;
+      child.private_data = column;
+      array_priv->children[c] = &child;
+
+      init_schema(&schema_priv->child_storage[c], arrow_format(m_pimpl->m_specs[c].type),
+        m_pimpl->m_specs[c].name, ARROW_FLAG_NULLABLE);
+      schema_priv->children[c] = &schema_priv->child_storage[c];
+    }
+    out_schema->n_children = static_cast<std::int64_t>(ncols);
+    out_schema->children = schema_priv->children.data();
+
+    out_array->length = static_cast<std::int64_t>(m_pimpl->m_rows);
+    out_array->null_count = 0;
+    out_array->offset = 0;
+    out_array->n_buffers = 1;
+    out_array->n_children = static_cast<std::int64_t>(ncols);
+    out_array->buffers = array_priv->buffers;
+    out_array->children = array_priv->children.data();
+    out_array->dictionary = nullptr;
+    out_array->release = release_struct;
+    out_array->private_data = array_priv.release();
+
+    m_pimpl->m_columns = std::move(pending);
+    m_pimpl->m_rows = 0;
+  }
+
+} // namespace csv
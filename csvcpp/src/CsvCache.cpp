@@ -0,0 +1,686 @@
+#include "CsvCache.hpp"
+
+#include "CsvParserImpl.hpp"
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+#include "Structure.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+// Cache file layout (host byte order, all sections 8-byte aligned):
+//
+//   FileHeader
+//   schema      : per column { u32 type, u32 name_len, name bytes }
+//   chunks      : 64-byte aligned, each { ChunkHeader, validity, values[, dict] }
+//   directory   : GroupEntry[row_groups], ChunkEntry[row_groups * columns]
+//
+// Row groups end at row boundaries. Every source byte belongs to exactly
+// one group, whose byte range and XXH64 are kept so refresh() can tell
+// which groups a rewrite of the source left unchanged.
+//
+// The header is rewritten last, so a truncated file never passes validation.
+
+namespace csv {
+  namespace {
+
+    constexpr char kMagic[8] = {'C', 'S', 'V', 'C', 'A', 'C', 'H', 'E'};
+    constexpr std::uint32_t kVersion = 2;
+    constexpr std::uint32_t kByteOrder = 0x01020304;
+    constexpr std::uint8_t kHasHeader = 0x01;
+
+    struct FileHeader {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byte_order;
+      std::uint64_t rows;
+      std::uint64_t columns;
+      std::uint64_t row_groups;
+      std::uint64_t source_size;
+      std::int64_t source_mtime_ns;
+      std::uint64_t schema_offset;
+      std::uint64_t directory_offset;
+      std::uint64_t file_size;
+      std::uint64_t row_group_rows;
+      std::uint8_t delim;
+      std::uint8_t quote;
+      std::uint8_t options;
+      std::uint8_t flags;
+      std::uint8_t reserved[4];
+    };
+
+    struct SchemaEntry {
+      std::uint32_t type;
+      std::uint32_t name_len;
+    };
+
+    struct GroupEntry {
+      std::uint64_t first_row;
+      std::uint64_t rows;
+      std::uint64_t source_offset;
+      std::uint64_t source_size;
+      std::uint64_t source_hash;  // XXH64 of the group's source bytes
+    };
+
+    struct ChunkEntry {
+      std::uint64_t offset;
+      std::uint64_t size;
+      std::uint64_t checksum;
+    };
+
+    struct ChunkHeader {
+      std::uint32_t rows;
+      std::uint32_t null_count;
+      std::uint32_t dict_size;
+      std::uint32_t reserved;
+      std::uint64_t validity_off;
+      std::uint64_t values_off;
+      std::uint64_t dict_offsets_off;
+      std::uint64_t dict_data_off;
+    };
+
+    constexpr std::size_t kChunkAlign = 64;
+
+    std::uint64_t align_up(std::uint64_t v, std::uint64_t a) noexcept {
+      return (v + a - 1) / a * a;
+    }
+
+    std::uint64_t checksum_seed(const detail::FileStat &st) noexcept {
+      std::uint64_t key[2] = {st.size, static_cast<std::uint64_t>(st.mtime_ns)};
+      return detail::xxh64(key, sizeof(key));
+    }
+
+    struct FileDeleter {
+      void operator()(FILE* f) const { if (f) std::fclose(f); }
+    };
+
+    class CacheWriter {
+    public:
+      explicit CacheWriter(FILE *fp) : m_fp(fp) {}
+
+      void write(const void *p, std::size_t n) {
+        if (n && std::fwrite(p, 1, n, m_fp) != n) {
+          throw std::runtime_error(std::string("Failed to write cache: ") + std::strerror(errno));
+        }
+        m_pos += n;
+      }
+
+      void pad_to(std::uint64_t align) {
+        static const unsigned char zeros[kChunkAlign] = {};
+        write(zeros, static_cast<std::size_t>(align_up(m_pos, align) - m_pos));
+      }
+
+      [[nodiscard]] std::uint64_t pos() const noexcept { return m_pos; }
+
+    private:
+      FILE *m_fp;
+      std::uint64_t m_pos = 0;
+    };
+
+    // Appends @p n bytes to @p out at the next 8-byte boundary, returns the offset
+    std::uint64_t append_section(std::vector<unsigned char> &out, const void *p, std::size_t n) {
+      out.resize(static_cast<std::size_t>(align_up(out.size(), 8)));
+      std::uint64_t off = out.size();
+      const unsigned char *b = static_cast<const unsigned char *>(p);
+      out.insert(out.end(), b, b + n);
+      return off;
+    }
+
+    std::vector<unsigned char> encode_chunk(const ArrowArray &col, ColumnType type) {
+      const std::size_t n = static_cast<std::size_t>(col.length);
+      const std::size_t bitmap_bytes = (n + 7) / 8;
+      std::vector<unsigned char> out(sizeof(ChunkHeader));
+      ChunkHeader h{};
+      h.rows = static_cast<std::uint32_t>(n);
+      h.null_count = static_cast<std::uint32_t>(col.null_count);
+
+      h.validity_off = append_section(out, col.buffers[0], bitmap_bytes);
+      switch (type) {
+        case ColumnType::Int64:
+        case ColumnType::Float64:
+          h.values_off = append_section(out, col.buffers[1], n * 8);
+          break;
+        case ColumnType::Bool:
+          h.values_off = append_section(out, col.buffers[1], bitmap_bytes);
+          break;
+        case ColumnType::Utf8: {
+          const auto *offsets = static_cast<const std::int32_t *>(col.buffers[1]);
+          const auto *chars = static_cast<const char *>(col.buffers[2]);
+          std::unordered_map<std::string_view, std::uint32_t> dict;
+          std::vector<std::uint32_t> dict_offsets{0};
+          std::string dict_data;
+          std::vector<std::uint32_t> indices(n);
+          for (std::size_t i = 0; i < n; ++i) {
+            std::string_view v(chars + offsets[i], static_cast<std::size_t>(offsets[i + 1] - offsets[i]));
+            auto it = dict.find(v);
+            if (it == dict.end()) {
+              it = dict.emplace(v, static_cast<std::uint32_t>(dict.size())).first;
+              dict_data.append(v.data(), v.size());
+              dict_offsets.push_back(static_cast<std::uint32_t>(dict_data.size()));
+            }
+            indices[i] = it->second;
+          }
+          h.dict_size = static_cast<std::uint32_t>(dict.size());
+          h.values_off = append_section(out, indices.data(), n * sizeof(std::uint32_t));
+          h.dict_offsets_off = append_section(out, dict_offsets.data(),
+            dict_offsets.size() * sizeof(std::uint32_t));
+          h.dict_data_off = append_section(out, dict_data.data(), dict_data.size());
+          break;
+        }
+      }
+      out.resize(static_cast<std::size_t>(align_up(out.size(), 8)));
+      std::memcpy(out.data(), &h, sizeof(h));
+      return out;
+    }
+
+    bool read_header(const unsigned char *p, std::size_t size, FileHeader &h) noexcept {
+      if (size < sizeof(FileHeader)) return false;
+      std::memcpy(&h, p, sizeof(h));
+      return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+             h.byte_order == kByteOrder;
+    }
+
+    bool in_bounds(std::uint64_t off, std::uint64_t len, std::uint64_t size) noexcept {
+      return off <= size && len <= size - off;
+    }
+
+    bool chunk_sections_ok(const unsigned char *p, std::uint64_t size, ColumnType type) noexcept {
+      ChunkHeader h;
+      std::memcpy(&h, p, sizeof(h));
+      const std::uint64_t n = h.rows;
+      const std::uint64_t bitmap_bytes = (n + 7) / 8;
+      if (h.validity_off % 8 != 0 || h.values_off % 8 != 0 ||
+          !in_bounds(h.validity_off, bitmap_bytes, size)) {
+        return false;
+      }
+      switch (type) {
+        case ColumnType::Int64:
+        case ColumnType::Float64:
+          return in_bounds(h.values_off, n * 8, size);
+        case ColumnType::Bool:
+          return in_bounds(h.values_off, bitmap_bytes, size);
+        case ColumnType::Utf8: {
+          if (h.dict_offsets_off % 8 != 0 || !in_bounds(h.values_off, n * 4, size) ||
+              !in_bounds(h.dict_offsets_off, (std::uint64_t{h.dict_size} + 1) * 4, size)) {
+            return false;
+          }
+          // Only section bounds are checked here: touching every index would
+          // defeat loading without a pass over the data. verify() covers content.
+          const auto *offsets = reinterpret_cast<const std::uint32_t *>(p + h.dict_offsets_off);
+          return in_bounds(h.dict_data_off, offsets[h.dict_size], size);
+        }
+      }
+      return false;
+    }
+
+    void check_config(const FileHeader &h, const struct csv_parser &p, bool header_row) {
+      if (h.delim != p.delim_char || h.quote != p.quote_char ||
+          ((h.options ^ p.options) & (CSV_REPALL_NL | CSV_EMPTY_IS_NULL)) != 0 ||
+          ((h.flags & kHasHeader) != 0) != header_row) {
+        throw CsvError("CSV Cache Error: cache was built with a different parser configuration",
+                       CsvError::ErrorType::Einvalid);
+      }
+    }
+
+    /*
+     * Appends row groups to a cache being written, either parsed from the
+     * source or copied from an older cache. Source bytes that produced no
+     * rows (a header, blank lines) join the next group, or the last group
+     * at the end of the file, so the groups tile the source.
+     */
+    class GroupWriter {
+    public:
+      GroupWriter(CacheWriter &out, const std::vector<ColumnSpec> &columns, std::uint64_t seed,
+                  const unsigned char *source, std::size_t source_size)
+          : m_out(out), m_columns(columns), m_builder(columns), m_seed(seed),
+            m_source(source), m_source_size(source_size) {}
+
+      /// End of the source bytes covered by the groups written so far
+      [[nodiscard]] std::size_t covered() const noexcept { return m_covered; }
+
+      [[nodiscard]] std::uint64_t rows() const noexcept { return m_rows; }
+      [[nodiscard]] const std::vector<GroupEntry> &groups() const noexcept { return m_groups; }
+      [[nodiscard]] const std::vector<ChunkEntry> &chunks() const noexcept { return m_chunks; }
+
+      /**
+       * Parses [from, end) into groups of about @p group_rows row ends,
+       * evenly sized so a short region does not leave a small group. @p from
+       * and @p end are row boundaries, or @p end is the end of the file and
+       * @p at_eof finishes the parser there. Returns the number of groups
+       * written.
+       */
+      std::size_t parse(CsvParser &parser, const detail::StructTable &table, std::size_t from, std::size_t end,
+                        std::size_t group_rows, bool at_eof) {
+        std::size_t total = 0;
+        table.scan(detail::kRowNotBegun, m_source + from, end - from, [&](std::size_t) { ++total; });
+        const std::size_t n = std::max<std::size_t>(1, (total + group_rows / 2) / group_rows);
+        group_rows = std::max<std::size_t>(1, (total + n - 1) / n);
+
+        const std::size_t before = m_groups.size();
+        std::size_t pos = from;
+        while (pos < end) {
+          std::size_t stop = pos;
+          std::uint8_t state = detail::kRowNotBegun;
+          for (std::size_t rows = 0; stop < end && rows < group_rows; ++stop) {
+            const std::uint8_t t = table.next(state, m_source[stop]);
+            state = t & detail::StructTable::kStateMask;
+            if (t & detail::StructTable::kRowEnd) ++rows;
+          }
+          m_builder.parse(parser, m_source + pos, stop - pos);
+          if (stop == end && at_eof) m_builder.finish(parser);
+          pos = stop;
+          if (m_builder.rows() > 0) flush(pos);
+        }
+        if (from == end && at_eof) {
+          m_builder.finish(parser);
+          if (m_builder.rows() > 0) flush(end);
+        }
+        return m_groups.size() - before;
+      }
+
+      /// Copies group @p g of an older cache, whose bytes now end at @p end
+      void reuse(const GroupEntry &g, const ChunkEntry *chunks, const unsigned char *cache, std::size_t end) {
+        for (std::size_t c = 0; c < m_columns.size(); ++c) {
+          const unsigned char *p = cache + chunks[c].offset;
+          const std::size_t n = static_cast<std::size_t>(chunks[c].size);
+          m_out.pad_to(kChunkAlign);
+          m_chunks.push_back({m_out.pos(), n, detail::xxh64(p, n, m_seed)});
+          m_out.write(p, n);
+        }
+        const bool same_bytes = end - m_covered == g.source_size;
+        add_group(g.rows, end, same_bytes ? g.source_hash : hash(m_covered, end));
+      }
+
+      /// Adds bytes after the last group to it
+      void close() {
+        if (m_groups.empty() || m_covered == m_source_size) return;
+        GroupEntry &g = m_groups.back();
+        g.source_size = m_source_size - g.source_offset;
+        g.source_hash = hash(static_cast<std::size_t>(g.source_offset), m_source_size);
+        m_covered = m_source_size;
+      }
+
+    private:
+      CacheWriter &m_out;
+      const std::vector<ColumnSpec> &m_columns;
+      ColumnBuilder m_builder;
+      std::uint64_t m_seed;
+      const unsigned char *m_source;
+      std::size_t m_source_size;
+      std::size_t m_covered = 0;
+      std::uint64_t m_rows = 0;
+      std::vector<GroupEntry> m_groups;
+      std::vector<ChunkEntry> m_chunks;
+
+      std::uint64_t hash(std::size_t begin, std::size_t end) const noexcept {
+        return detail::xxh64(m_source + begin, end - begin);
+      }
+
+      void add_group(std::uint64_t rows, std::size_t end, std::uint64_t source_hash) {
+        m_groups.push_back({m_rows, rows, m_covered, end - m_covered, source_hash});
+        m_rows += rows;
+        m_covered = end;
+      }
+
+      void flush(std::size_t end) {
+        ArrowArray array;
+        ArrowSchema schema;
+        const std::uint64_t rows = m_builder.rows();
+        m_builder.export_arrow(&array, &schema);
+        try {
+          for (std::size_t c = 0; c < m_columns.size(); ++c) {
+            std::vector<unsigned char> chunk = encode_chunk(*array.children[c], m_columns[c].type);
+            m_out.pad_to(kChunkAlign);
+            m_chunks.push_back({m_out.pos(), chunk.size(), detail::xxh64(chunk.data(), chunk.size(), m_seed)});
+            m_out.write(chunk.data(), chunk.size());
+          }
+        } catch (...) {
+          array.release(&array);
+          schema.release(&schema);
+          throw;
+        }
+        array.release(&array);
+        schema.release(&schema);
+        add_group(rows, end, hash(m_covered, end));
+      }
+    };
+
+    // Writes the directory and the header, then renames @p tmp_path to @p cache_path
+    void finish_cache(std::unique_ptr<FILE, FileDeleter> &outfile, CacheWriter &out, FileHeader &header,
+                      const GroupWriter &groups, const std::string &tmp_path, const std::string &cache_path) {
+      out.pad_to(8);
+      header.directory_offset = out.pos();
+      out.write(groups.groups().data(), groups.groups().size() * sizeof(GroupEntry));
+      out.write(groups.chunks().data(), groups.chunks().size() * sizeof(ChunkEntry));
+
+      std::memcpy(header.magic, kMagic, sizeof(kMagic));
+      header.version = kVersion;
+      header.byte_order = kByteOrder;
+      header.rows = groups.rows();
+      header.row_groups = groups.groups().size();
+      header.file_size = out.pos();
+      if (std::fseek(outfile.get(), 0, SEEK_SET) != 0 ||
+          std::fwrite(&header, sizeof(header), 1, outfile.get()) != 1 ||
+          std::fclose(outfile.release()) != 0) {
+        throw std::runtime_error("Failed to write " + tmp_path);
+      }
+      if (std::rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Failed to rename " + tmp_path + ": " + std::strerror(errno));
+      }
+    }
+
+    void write_schema(CacheWriter &out, FileHeader &header, const std::vector<ColumnSpec> &columns) {
+      header.schema_offset = out.pos();
+      header.columns = columns.size();
+      for (const ColumnSpec &spec : columns) {
+        SchemaEntry e{static_cast<std::uint32_t>(spec.type), static_cast<std::uint32_t>(spec.name.size())};
+        out.write(&e, sizeof(e));
+        out.write(spec.name.data(), spec.name.size());
+        out.pad_to(8);
+      }
+    }
+
+  } // namespace
+
+  struct CsvCache::impl {
+    std::unique_ptr<detail::MappedFile> m_file;
+    FileHeader m_header{};
+    std::vector<ColumnSpec> m_specs;
+    const GroupEntry *m_groups = nullptr;
+    const ChunkEntry *m_chunks = nullptr;
+    std::uint64_t m_seed = 0;
+
+    [[nodiscard]] const ChunkEntry &entry(size_t group, size_t col) const {
+      if (group >= m_header.row_groups || col >= m_specs.size()) {
+        throw std::out_of_range("CsvCache: chunk index out of range");
+      }
+      return m_chunks[group * m_specs.size() + col];
+    }
+
+    // Maps @p cache_path and validates its structure, not its freshness
+    void load(const std::string &cache_path) {
+      auto invalid = [&](const char *why) {
+        return CsvError("CSV Cache Error: " + cache_path + ": " + why, CsvError::ErrorType::Einvalid);
+      };
+
+      m_file = std::make_unique<detail::MappedFile>(cache_path);
+      const unsigned char *base = m_file->data();
+      const std::uint64_t size = m_file->size();
+
+      if (!read_header(base, size, m_header) || m_header.file_size != size) {
+        throw invalid("not a cache file or truncated");
+      }
+      const FileHeader &h = m_header;
+
+      std::uint64_t pos = h.schema_offset;
+      for (std::uint64_t c = 0; c < h.columns; ++c) {
+        SchemaEntry e;
+        if (!in_bounds(pos, sizeof(e), size)) throw invalid("schema out of bounds");
+        std::memcpy(&e, base + pos, sizeof(e));
+        pos += sizeof(e);
+        if (!in_bounds(pos, e.name_len, size) || e.type > static_cast<std::uint32_t>(ColumnType::Utf8)) {
+          throw invalid("bad schema entry");
+        }
+        m_specs.push_back({std::string(reinterpret_cast<const char *>(base + pos), e.name_len),
+                           static_cast<ColumnType>(e.type)});
+        pos = align_up(pos + e.name_len, 8);
+      }
+
+      const std::uint64_t dir_bytes = h.row_groups * (sizeof(GroupEntry) + h.columns * sizeof(ChunkEntry));
+      if (h.directory_offset % 8 != 0 || !in_bounds(h.directory_offset, dir_bytes, size)) {
+        throw invalid("directory out of bounds");
+      }
+      m_groups = reinterpret_cast<const GroupEntry *>(base + h.directory_offset);
+      m_chunks = reinterpret_cast<const ChunkEntry *>(base + h.directory_offset +
+                                                      h.row_groups * sizeof(GroupEntry));
+      std::uint64_t source_pos = 0;
+      for (std::uint64_t g = 0; g < h.row_groups; ++g) {
+        if (m_groups[g].source_offset != source_pos || !in_bounds(source_pos, m_groups[g].source_size, h.source_size)) {
+          throw invalid("row group source range out of bounds");
+        }
+        source_pos += m_groups[g].source_size;
+      }
+      for (std::uint64_t i = 0; i < h.row_groups * h.columns; ++i) {
+        const ChunkEntry &e = m_chunks[i];
+        if (e.offset % kChunkAlign != 0 || e.size < sizeof(ChunkHeader) || !in_bounds(e.offset, e.size, size) ||
+            !chunk_sections_ok(base + e.offset, e.size, m_specs[i % h.columns].type)) {
+          throw invalid("chunk out of bounds");
+        }
+      }
+    }
+  };
+
+  CsvCache::CsvCache() : m_pimpl(std::make_unique<impl>()) {}
+  CsvCache::CsvCache(CsvCache&&) noexcept = default;
+  CsvCache& CsvCache::operator=(CsvCache&&) noexcept = default;
+  CsvCache::~CsvCache() = default;
+
+  void CsvCache::convert(const std::string &csv_path, const std::string &cache_path,
+                         const std::vector<ColumnSpec> &columns, CsvParser &parser,
+                         size_t row_group_rows) {
+    detail::FileStat st;
+    if (!detail::stat_file(csv_path, st)) {
+      throw std::runtime_error("Failed to stat " + csv_path + ": " + std::strerror(errno));
+    }
+    detail::MappedFile source(csv_path);
+    const std::string tmp_path = cache_path + ".tmp";
+    std::unique_ptr<FILE, FileDeleter> outfile(std::fopen(tmp_path.c_str(), "wb"));
+    if (!outfile) {
+      throw std::runtime_error("Failed to open " + tmp_path + ": " + std::strerror(errno));
+    }
+
+    // Chunk headers store row counts as uint32
+    if (row_group_rows == 0 || row_group_rows > std::numeric_limits<std::uint32_t>::max() / 2) {
+      row_group_rows = 65536;
+    }
+
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    CacheWriter out(outfile.get());
+    FileHeader header{};
+    out.write(&header, sizeof(header));
+    write_schema(out, header, columns);
+
+    // Groups are cut at row ends found by the structure table, so each one
+    // covers whole rows and a byte range refresh() can compare
+    GroupWriter groups(out, columns, checksum_seed(st), source.data(), source.size());
+    groups.parse(parser, detail::StructTable(cp), 0, source.size(), row_group_rows, true);
+    groups.close();
+
+    header.source_size = st.size;
+    header.source_mtime_ns = st.mtime_ns;
+    header.row_group_rows = row_group_rows;
+    header.delim = cp.delim_char;
+    header.quote = cp.quote_char;
+    header.options = cp.options;
+    header.flags = parser.get_header_row() ? kHasHeader : 0;
+    finish_cache(outfile, out, header, groups, tmp_path, cache_path);
+  }
+
+  CsvCache::RefreshStats CsvCache::refresh(const std::string &csv_path, const std::string &cache_path,
+                                           CsvParser &parser) {
+    CsvCache old;
+    impl &d = *old.m_pimpl;
+    d.load(cache_path);
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    check_config(d.m_header, cp, parser.get_header_row());
+
+    RefreshStats stats;
+    stats.row_groups = static_cast<size_t>(d.m_header.row_groups);
+    detail::FileStat st;
+    if (!detail::stat_file(csv_path, st)) {
+      throw std::runtime_error("Failed to stat " + csv_path + ": " + std::strerror(errno));
+    }
+    if (st.size == d.m_header.source_size && st.mtime_ns == d.m_header.source_mtime_ns) return stats;
+
+    detail::MappedFile source(csv_path);
+    const unsigned char *data = source.data();
+    const size_t size = source.size();
+    const std::string tmp_path = cache_path + ".tmp";
+    std::unique_ptr<FILE, FileDeleter> outfile(std::fopen(tmp_path.c_str(), "wb"));
+    if (!outfile) {
+      throw std::runtime_error("Failed to open " + tmp_path + ": " + std::strerror(errno));
+    }
+
+    CacheWriter out(outfile.get());
+    FileHeader header = d.m_header;
+    out.write(&header, sizeof(header));
+    write_schema(out, header, d.m_specs);
+
+    const detail::StructTable table(cp);
+    const size_t group_rows = static_cast<size_t>(d.m_header.row_group_rows);
+    GroupWriter groups(out, d.m_specs, checksum_seed(st), data, size);
+    detail::begin_random_rows(parser, data, size);
+    const size_t floor = parser.get_header_row() ? table.row_end(data, size) : 0;
+
+    // Bytes [dirty, next kept group) changed; they start at a row boundary
+    constexpr size_t kClean = std::numeric_limits<size_t>::max();
+    size_t dirty = kClean;
+    auto reparse = [&](size_t end, bool at_eof) {
+      const size_t from = dirty == 0 ? floor : dirty;
+      stats.reparsed_groups += groups.parse(parser, table, from < end ? from : end, end, group_rows, at_eof);
+      stats.reparsed_bytes += end - dirty;
+      dirty = kClean;
+    };
+
+    // An old group is kept if its bytes are found where they were, or moved
+    // by the size difference of the files (an edit that changed lengths)
+    const std::uint64_t old_size = d.m_header.source_size;
+    const std::int64_t tail_shift = static_cast<std::int64_t>(size) - static_cast<std::int64_t>(old_size);
+    std::int64_t shift = 0;
+    for (size_t g = 0; g < d.m_header.row_groups; ++g) {
+      const GroupEntry &e = d.m_groups[g];
+      const bool last = e.source_offset + e.source_size == old_size;  // may end in an unterminated row
+      bool keep = false;
+      size_t begin = 0;
+      for (std::int64_t s : {shift, tail_shift}) {
+        const std::int64_t b = static_cast<std::int64_t>(e.source_offset) + s;
+        const auto covered = static_cast<std::int64_t>(groups.covered());
+        if (b < covered || (dirty == kClean && b != covered)) continue;  // kept groups must be contiguous
+        begin = static_cast<size_t>(b);
+        if (begin > size || e.source_size > size - begin || (last && begin + e.source_size != size) ||
+            detail::xxh64(data + begin, static_cast<size_t>(e.source_size)) != e.source_hash) {
+          continue;
+        }
+        // The changed bytes before it must end exactly where it starts
+        if (dirty != kClean && dirty < begin &&
+            table.scan(detail::kRowNotBegun, data + dirty, begin - dirty, [](size_t) {}) != detail::kRowNotBegun) {
+          continue;
+        }
+        keep = true;
+        shift = s;
+        break;
+      }
+      if (!keep) {
+        if (dirty == kClean) dirty = groups.covered();
+        continue;
+      }
+      if (dirty != kClean) reparse(begin, false);
+      groups.reuse(e, d.m_chunks + g * d.m_specs.size(), d.m_file->data(),
+                   begin + static_cast<size_t>(e.source_size));
+    }
+    if (dirty == kClean && groups.covered() < size) dirty = groups.covered();
+    if (dirty != kClean) {
+      reparse(size, true);
+    } else {
+      parser.finish(nullptr, nullptr, nullptr);
+    }
+    groups.close();
+
+    header.source_size = st.size;
+    header.source_mtime_ns = st.mtime_ns;
+    finish_cache(outfile, out, header, groups, tmp_path, cache_path);
+    stats.row_groups = groups.groups().size();
+    return stats;
+  }
+
+  bool CsvCache::is_fresh(const std::string &cache_path, const std::string &source_path) noexcept {
+    detail::FileStat st;
+    if (!detail::stat_file(source_path, st)) return false;
+    std::unique_ptr<FILE, FileDeleter> fp(std::fopen(cache_path.c_str(), "rb"));
+    if (!fp) return false;
+    unsigned char buf[sizeof(FileHeader)];
+    FileHeader h;
+    if (std::fread(buf, 1, sizeof(buf), fp.get()) != sizeof(buf) ||
+        !read_header(buf, sizeof(buf), h)) {
+      return false;
+    }
+    return h.source_size == st.size && h.source_mtime_ns == st.mtime_ns;
+  }
+
+  CsvCache CsvCache::open(const std::string &cache_path, const std::string &source_path) {
+    detail::FileStat st;
+    if (!detail::stat_file(source_path, st)) {
+      throw std::runtime_error("Failed to stat " + source_path + ": " + std::strerror(errno));
+    }
+
+    CsvCache cache;
+    impl &d = *cache.m_pimpl;
+    d.load(cache_path);
+    if (d.m_header.source_size != st.size || d.m_header.source_mtime_ns != st.mtime_ns) {
+      throw CsvError("CSV Cache Error: " + cache_path + ": stale: source file changed since the cache was built",
+                     CsvError::ErrorType::Einvalid);
+    }
+    d.m_seed = checksum_seed(st);
+    return cache;
+  }
+
+  size_t CsvCache::rows() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.rows);
+  }
+
+  size_t CsvCache::columns() const noexcept {
+    return m_pimpl->m_specs.size();
+  }
+
+  size_t CsvCache::row_groups() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.row_groups);
+  }
+
+  const ColumnSpec &CsvCache::spec(size_t col) const {
+    return m_pimpl->m_specs.at(col);
+  }
+
+  size_t CsvCache::row_group_first_row(size_t group) const {
+    if (group >= m_pimpl->m_header.row_groups) {
+      throw std::out_of_range("CsvCache: row group out of range");
+    }
+    return static_cast<size_t>(m_pimpl->m_groups[group].first_row);
+  }
+
+  ColumnChunk CsvCache::chunk(size_t group, size_t col) const {
+    const ChunkEntry &e = m_pimpl->entry(group, col);
+    const unsigned char *p = m_pimpl->m_file->data() + e.offset;
+    ChunkHeader h;
+    std::memcpy(&h, p, sizeof(h));
+
+    // Chunk sections were bounds-checked in open()
+    ColumnChunk c;
+    c.type = m_pimpl->m_specs[col].type;
+    c.rows = h.rows;
+    c.null_count = h.null_count;
+    c.validity = reinterpret_cast<const std::uint8_t *>(p + h.validity_off);
+    c.values = p + h.values_off;
+    if (c.type == ColumnType::Utf8) {
+      c.dict_size = h.dict_size;
+      c.dict_offsets = reinterpret_cast<const std::uint32_t *>(p + h.dict_offsets_off);
+      c.dict_data = reinterpret_cast<const char *>(p + h.dict_data_off);
+    }
+    return c;
+  }
+
+  bool CsvCache::verify() const noexcept {
+    const impl &d = *m_pimpl;
+    for (std::uint64_t i = 0; i < d.m_header.row_groups * d.m_header.columns; ++i) {
+      const ChunkEntry &e = d.m_chunks[i];
+      if (detail::xxh64(d.m_file->data() + e.offset, e.size, d.m_seed) != e.checksum) return false;
+    }
+    return true;
+  }
+
+} // namespace csv
@@ -3,20 +3,271 @@
 
 #include "CsvParser.hpp"
 
-#include "csv.h"
+#include "Classify.hpp"
+#include "CsvParserImpl.hpp"
+#include "MappedFile.hpp"
+#include "RowIndex.hpp"
+#include "Structure.hpp"
+#include <algorithm>
+#include <utility>
+#include <cstring>
 #include <stdexcept>
 
 // CsvParser enforces non-null invariants internally.
 // The underlying libcsv API is therefore always called with valid arguments.
 
 namespace csv {
-  struct CsvParser::impl {
-    struct csv_parser m_parser{};
+  namespace {
 
-    ~impl() {
-      csv_free(&m_parser);
+    struct CellContext {
+      std::string value;
+      bool found = false;
+    };
+
+    void capture_cell(void *s, size_t len, void *ctx) {
+      auto *c = static_cast<CellContext *>(ctx);
+      if (c->found) return;
+      c->found = true;
+      if (s) c->value.assign(static_cast<const char *>(s), len);
+    }
+
+    void check_index(const RowIndex &index, const struct csv_parser &p) {
+      if (index.delimiter() != p.delim_char || index.quote() != p.quote_char ||
+          index.counts_blank_lines() != ((p.options & CSV_REPALL_NL) != 0)) {
+        throw CsvError("CSV Seek Error: index was built with a different parser configuration",
+                       CsvError::ErrorType::Einvalid);
+      }
+    }
+
+    void require_header(bool header_row, const HeaderMap &header) {
+      if (!header_row && header.empty()) {
+        throw CsvError("CSV Header Error: column names require set_header_row(true)",
+                       CsvError::ErrorType::Einvalid);
+      }
+    }
+
+    constexpr char kCheckpointMagic[8] = {'C', 'S', 'V', 'C', 'K', 'P', 'T', 'S'};
+    constexpr std::uint32_t kCheckpointVersion = 1;
+    constexpr std::uint32_t kByteOrder = 0x01020304;
+    constexpr std::uint8_t kHeaderRow = 0x01;
+    constexpr std::uint8_t kCaptureHeader = 0x02;
+    constexpr std::uint8_t kDropped = 0x04;
+    constexpr std::uint8_t kDeciding = 0x08;
+    constexpr std::uint8_t kRawEscaped = 0x10;
+
+    // Followed by the entry buffer bytes and the length-prefixed sections of put_state()
+    struct CheckpointHeader {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byte_order;
+      std::uint64_t offset;
+      std::uint64_t row;
+      std::uint64_t spaces;
+      std::uint64_t entry_pos;
+      std::uint64_t skip_rows;
+      std::uint64_t rejected;
+      std::uint64_t col;
+      std::int32_t pstate;
+      std::int32_t quoted;
+      std::int32_t status;
+      std::uint8_t delim;
+      std::uint8_t quote;
+      std::uint8_t options;
+      std::uint8_t flags;
+    };
+
+    [[noreturn]] void bad_checkpoint() {
+      throw CsvError("CSV Checkpoint Error: not a valid parser checkpoint", CsvError::ErrorType::Einvalid);
     }
-  };
+
+    void put_u64(std::string &out, std::uint64_t v) {
+      out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+
+    template <typename T>
+    void put_bytes(std::string &out, const std::vector<T> &v) {
+      static_assert(sizeof(T) == 1, "byte vectors only");
+      put_u64(out, v.size());
+      out.append(reinterpret_cast<const char *>(v.data()), v.size());
+    }
+
+    void put_strings(std::string &out, const std::vector<std::string> &v) {
+      put_u64(out, v.size());
+      for (const std::string &s : v) {
+        put_u64(out, s.size());
+        out += s;
+      }
+    }
+
+    /// Bounds-checked reader over a checkpoint; every failure is bad_checkpoint()
+    class CheckpointReader {
+    public:
+      explicit CheckpointReader(std::string_view in) noexcept : m_in(in) {}
+
+      std::string_view take(std::uint64_t n) {
+        if (n > m_in.size() - m_pos) bad_checkpoint();
+        const std::string_view out = m_in.substr(m_pos, static_cast<size_t>(n));
+        m_pos += static_cast<size_t>(n);
+        return out;
+      }
+
+      std::uint64_t u64() {
+        std::uint64_t v;
+        std::memcpy(&v, take(sizeof(v)).data(), sizeof(v));
+        return v;
+      }
+
+      template <typename T>
+      void bytes(std::vector<T> &v) {
+        const std::string_view s = take(u64());
+        v.assign(s.begin(), s.end());
+      }
+
+      void strings(std::vector<std::string> &v) {
+        const std::uint64_t n = u64();
+        if (n > m_in.size() - m_pos) bad_checkpoint();  // at least a length per string
+        v.clear();
+        for (std::uint64_t i = 0; i < n; ++i) v.emplace_back(take(u64()));
+      }
+
+      [[nodiscard]] bool done() const noexcept { return m_pos == m_in.size(); }
+
+    private:
+      std::string_view m_in;
+      size_t m_pos = 0;
+    };
+
+    // Columns tested by @p filter, as a mask comparable across parsers
+    std::vector<unsigned char> tested_columns(const RowFilter &filter) {
+      std::vector<unsigned char> mask;
+      if (filter.empty() || filter.last_column() == static_cast<size_t>(-1)) return mask;
+      mask.resize(filter.last_column() + 1);
+      for (size_t c = 0; c < mask.size(); ++c) mask[c] = filter.tests(c);
+      return mask;
+    }
+
+    // Engine::Auto: the first blocks are profiled together, then one in kMonitorInterval alone
+    constexpr std::uint64_t kSampleBlocks = 4;
+    constexpr std::uint64_t kMonitorInterval = 16;
+    constexpr std::size_t kSampleBytes = std::size_t{4} << 10;
+    constexpr std::uint64_t kDenseQuotes = 8;  // a quote in fewer bytes than this
+    constexpr std::uint64_t kShortField = 8;   // bytes per field, delimiter included
+
+    /// Counts byte classes over the first kSampleBytes of a block
+    void sample_block(const struct csv_parser &p, const unsigned char *s, size_t len,
+                      detail::EngineProfile &profile) noexcept {
+      const size_t n = std::min(len, kSampleBytes);
+      size_t i = 0;
+      for (; i + detail::kClassifyBlock <= n; i += detail::kClassifyBlock) {
+        const detail::Masks m = detail::classify(s + i, p.quote_char, p.delim_char);
+        profile.quotes += detail::popcount(m.quote);
+        profile.delims += detail::popcount(m.delim);
+        profile.terms += detail::popcount(m.term);
+      }
+      for (; i < n; ++i) {
+        profile.quotes += s[i] == p.quote_char;
+        profile.delims += s[i] == p.delim_char;
+        profile.terms += s[i] == CSV_CR || s[i] == CSV_LF;
+      }
+      profile.bytes += n;
+    }
+
+    /*
+     * Per-byte csv_parse() wins when fields are a few bytes long or quotes
+     * are dense: runs are then too short to pay for locating them. Quoted
+     * fields are fastest with memchr() to their closing quote (Runs), and
+     * unquoted ones with the structural masks, which find every delimiter
+     * and terminator of a 64-byte block at once (Simd).
+     */
+    CsvParser::Engine pick_engine(const detail::EngineProfile &profile) noexcept {
+      using Engine = CsvParser::Engine;
+      if (profile.bytes == 0) return Engine::Runs;
+      const std::uint64_t fields = profile.delims + profile.terms + 1;
+      if (profile.quotes * kDenseQuotes > profile.bytes || profile.bytes < fields * kShortField) {
+        return Engine::Libcsv;
+      }
+      return profile.quotes >= fields ? Engine::Runs : Engine::Simd;
+    }
+
+  } // namespace
+
+  CsvParser::Engine CsvParser::impl::effective_engine(Engine e) noexcept {
+    if (e == Engine::Libcsv && m_plan.active()) return Engine::Runs;
+    if (e == Engine::Simd) {
+      const int chars = m_parser.delim_char << 8 | m_parser.quote_char;
+      if (m_classes_space != m_parser.is_space || m_classes_term != m_parser.is_term || m_classes_chars != chars) {
+        m_default_classes = detail::default_classes(m_parser);
+        m_classes_space = m_parser.is_space;
+        m_classes_term = m_parser.is_term;
+        m_classes_chars = chars;
+      }
+      if (!m_default_classes) return Engine::Runs;
+    }
+    return e;
+  }
+
+  CsvParser::Engine CsvParser::impl::choose_engine(const unsigned char *s, size_t len) noexcept {
+    EngineStats &stats = m_engine_stats;
+    if (stats.blocks < kSampleBlocks || stats.blocks % kMonitorInterval == 0) {
+      if (stats.blocks >= kSampleBlocks) m_profile = detail::EngineProfile();  // monitoring: the latest sample decides
+      sample_block(m_parser, s, len, m_profile);
+      m_auto_choice = pick_engine(m_profile);
+      ++stats.sampled;
+    }
+    const Engine e = effective_engine(m_auto_choice);
+    if (stats.blocks > 0 && e != stats.active) ++stats.switches;
+    ++stats.blocks;
+    return e;
+  }
+
+  size_t CsvParser::impl::parse_with(Engine e, const void *s, size_t len,
+                                     detail::FieldCallback cb1, detail::RowCallback cb2, void *data) {
+    e = effective_engine(e);
+    m_engine_stats.active = e;
+    size_t result;
+    if (e == Engine::Libcsv) {
+      result = csv_parse(&m_parser, s, len, cb1, cb2, data);
+    } else {
+      const auto tokenize = e == Engine::Simd ? detail::plan_parse_structural : detail::plan_parse;
+      result = tokenize(m_parser, m_plan, s, len, cb1, cb2, data);
+      if (m_plan.header_ready) {
+        try {
+          take_header();
+        } catch (const CsvError &err) {
+          throw CsvError(err.what(), err.type, result);
+        }
+        result += tokenize(m_parser, m_plan, static_cast<const char *>(s) + result,
+                           len - result, cb1, cb2, data);
+      }
+    }
+    m_engine_stats.bytes[static_cast<int>(e)] += result;
+    return result;
+  }
+
+  void CsvParser::impl::take_header() {
+    std::vector<std::string> &names = m_plan.header_fields;
+    if (!names.empty() && names[0].compare(0, 3, "\xEF\xBB\xBF") == 0) names[0].erase(0, 3);
+    m_header = HeaderMap(names);
+    names.clear();
+    m_plan.header_ready = false;
+    resolve_names();
+  }
+
+  void CsvParser::impl::resolve_names() {
+    if (!m_header.empty() && !m_projection_names.empty()) {
+      std::vector<unsigned char> project;
+      for (const std::string &name : m_projection_names) {
+        const size_t c = m_header.index(name);
+        if (c >= project.size()) project.resize(c + 1, 0);
+        project[c] = 1;
+      }
+      m_plan.project = std::move(project);
+    }
+    if (!m_filter.has_names()) m_plan.filter = m_filter;
+    else if (!m_header.empty()) m_plan.filter = m_filter.resolve(m_header);
+    else m_plan.filter = RowFilter();  // until the header row is parsed
+    m_plan.begin_row();
+  }
 
   CsvParser::CsvParser()
       : m_pimpl(std::make_unique<impl>()) {
@@ -121,7 +372,26 @@ namespace csv {
                           void (*cb1)(void *, size_t, void *),
                           void (*cb2)(int c, void *),
                           void *data) {
-    size_t result = csv_parse(&m_pimpl->m_parser, s, len, cb1, cb2, data);
+    impl &m = *m_pimpl;
+    size_t result = 0;
+    if (m.m_engine != Engine::Auto || s == nullptr) {
+      result = m.parse_with(m.m_engine == Engine::Auto ? Engine::Runs : m.m_engine, s, len, cb1, cb2, data);
+    } else {
+      // Engines change at block boundaries only
+      const auto *us = static_cast<const unsigned char *>(s);
+      while (result < len) {
+        const size_t n = std::min(len - result, auto_block_size());
+        const Engine e = m.choose_engine(us + result, n);
+        size_t used;
+        try {
+          used = m.parse_with(e, us + result, n, cb1, cb2, data);
+        } catch (const CsvError &err) {
+          throw CsvError(err.what(), err.type, result + err.bytes_parsed);
+        }
+        result += used;
+        if (used < n) break;  // error
+      }
+    }
     int c_error = csv_error(&m_pimpl->m_parser);
     if (c_error != 0) {
       const char *errmsg = csv_strerror(c_error);
@@ -132,15 +402,368 @@ namespace csv {
   }
 
 
+  size_t CsvParser::parse_insitu(void *s, size_t len,
+                                 void (*cb1)(void *, size_t, void *),
+                                 void (*cb2)(int c, void *),
+                                 void *data) {
+    detail::RowPlan &plan = m_pimpl->m_plan;
+    size_t result = detail::plan_parse_insitu(m_pimpl->m_parser, plan, s, len, cb1, cb2, data);
+    if (plan.header_ready) {
+      try {
+        m_pimpl->take_header();
+      } catch (const CsvError &e) {
+        throw CsvError(e.what(), e.type, result);
+      }
+      result += detail::plan_parse_insitu(m_pimpl->m_parser, plan, static_cast<char *>(s) + result,
+                                          len - result, cb1, cb2, data);
+    }
+    int c_error = csv_error(&m_pimpl->m_parser);
+    if (c_error != 0) {
+      throw CsvError(std::string("CSV Parsing Error: ") + csv_strerror(c_error),
+        static_cast<CsvError::ErrorType>(c_error), result);
+    }
+    return result;
+  }
+
   void CsvParser::finish(  void (*cb1)(void *, size_t, void *),
                           void (*cb2)(int c, void *),
                           void *data) {
-    int result = csv_fini(&m_pimpl->m_parser, cb1, cb2, data);
+    int result;
+    if (m_pimpl->plan_engine()) {
+      result = detail::plan_finish(m_pimpl->m_parser, m_pimpl->m_plan, cb1, cb2, data);
+      if (m_pimpl->m_plan.header_ready) m_pimpl->take_header();
+      m_pimpl->m_plan.skip_rows = 0;
+      m_pimpl->m_plan.capture_header = m_pimpl->m_header_row;
+      m_pimpl->m_plan.begin_row();
+    } else {
+      result = csv_fini(&m_pimpl->m_parser, cb1, cb2, data);
+    }
     if (result != 0) {
       throw std::runtime_error(csv_strerror(csv_error(&m_pimpl->m_parser)));
     }
   }
 
+  size_t CsvParser::parse_raw(const void *s, size_t len, RawFieldCallback cb1,
+                              void (*cb2)(int c, void *),
+                              void *data) {
+    detail::RowPlan &plan = m_pimpl->m_plan;
+    size_t result = detail::raw_parse(m_pimpl->m_parser, plan, s, len, cb1, cb2, data);
+    if (plan.header_ready) {
+      try {
+        m_pimpl->take_header();
+      } catch (const CsvError &e) {
+        throw CsvError(e.what(), e.type, result);
+      }
+      result += detail::raw_parse(m_pimpl->m_parser, plan, static_cast<const char *>(s) + result,
+                                  len - result, cb1, cb2, data);
+    }
+    int c_error = csv_error(&m_pimpl->m_parser);
+    if (c_error != 0) {
+      throw CsvError(std::string("CSV Parsing Error: ") + csv_strerror(c_error),
+        static_cast<CsvError::ErrorType>(c_error), result);
+    }
+    return result;
+  }
+
+  void CsvParser::finish_raw(RawFieldCallback cb1, void (*cb2)(int c, void *), void *data) {
+    detail::RowPlan &plan = m_pimpl->m_plan;
+    const int result = detail::raw_finish(m_pimpl->m_parser, plan, cb1, cb2, data);
+    if (plan.header_ready) m_pimpl->take_header();
+    plan.skip_rows = 0;
+    plan.capture_header = m_pimpl->m_header_row;
+    plan.begin_row();
+    if (result != 0) {
+      throw std::runtime_error(csv_strerror(csv_error(&m_pimpl->m_parser)));
+    }
+  }
+
+  void CsvParser::set_header_row(bool enabled) {
+    m_pimpl->m_header_row = enabled;
+    m_pimpl->m_plan.capture_header = enabled;
+    m_pimpl->m_plan.header_fields.clear();
+    m_pimpl->m_plan.begin_row();
+  }
+
+  bool CsvParser::get_header_row() const noexcept {
+    return m_pimpl->m_header_row;
+  }
+
+  const HeaderMap &CsvParser::header() const noexcept {
+    return m_pimpl->m_header;
+  }
+
+  void CsvParser::set_projection(const std::vector<size_t> &columns) {
+    m_pimpl->m_projection_names.clear();
+    detail::RowPlan &plan = m_pimpl->m_plan;
+    plan.project.clear();
+    for (size_t c : columns) {
+      if (c >= plan.project.size()) plan.project.resize(c + 1, 0);
+      plan.project[c] = 1;
+    }
+    plan.begin_row();
+  }
+
+  void CsvParser::set_named_projection(const std::vector<std::string> &names) {
+    require_header(m_pimpl->m_header_row, m_pimpl->m_header);
+    if (!m_pimpl->m_header.empty()) {
+      for (const std::string &name : names) (void)m_pimpl->m_header.index(name);  // validate first
+    }
+    m_pimpl->m_projection_names = names;
+    m_pimpl->m_plan.project.clear();
+    m_pimpl->resolve_names();
+  }
+
+  void CsvParser::clear_projection() noexcept {
+    m_pimpl->m_projection_names.clear();
+    m_pimpl->m_plan.project.clear();
+    m_pimpl->m_plan.begin_row();
+  }
+
+  std::vector<size_t> CsvParser::get_projection() const {
+    std::vector<size_t> columns;
+    const detail::RowPlan &plan = m_pimpl->m_plan;
+    for (size_t c = 0; c < plan.project.size(); ++c) {
+      if (plan.project[c]) columns.push_back(c);
+    }
+    return columns;
+  }
+
+  void CsvParser::set_filter(RowFilter filter) {
+    if (filter.has_names()) {
+      require_header(m_pimpl->m_header_row, m_pimpl->m_header);
+      if (!m_pimpl->m_header.empty()) (void)filter.resolve(m_pimpl->m_header);
+    }
+    m_pimpl->m_filter = std::move(filter);
+    m_pimpl->m_plan.rejected = 0;
+    m_pimpl->resolve_names();
+  }
+
+  void CsvParser::clear_filter() noexcept {
+    m_pimpl->m_filter = RowFilter();
+    m_pimpl->m_plan.filter = RowFilter();
+    m_pimpl->m_plan.begin_row();
+  }
+
+  std::uint64_t CsvParser::rows_filtered() const noexcept {
+    return m_pimpl->m_plan.rejected;
+  }
+
+  std::uint64_t CsvParser::seek(const RowIndex &index, std::uint64_t row) {
+    struct csv_parser &p = m_pimpl->m_parser;
+    check_index(index, p);
+    if (m_pimpl->m_plan.capture_header) {
+      if (m_pimpl->names_pending()) {
+        throw CsvError("CSV Seek Error: column names used before the header row was parsed",
+                       CsvError::ErrorType::Einvalid);
+      }
+      m_pimpl->m_plan.capture_header = false;
+      m_pimpl->m_plan.header_fields.clear();
+    }
+    const RowIndex::Position pos = index.locate(row);
+    // Indexed offsets are row boundaries: restart from a clean state there
+    detail::reset_row_state(p);
+    m_pimpl->m_plan.skip_rows = row - pos.row;
+    m_pimpl->m_plan.begin_row();
+    return pos.offset;
+  }
+
+  void CsvParser::seek(const RowIndex &index, FILE *fp, std::uint64_t row) {
+    detail::seek_file(fp, seek(index, row));
+  }
+
+  std::string CsvParser::read_cell(const RowIndex &index, FILE *fp, std::uint64_t row, size_t col) {
+    struct csv_parser &p = m_pimpl->m_parser;
+    check_index(index, p);
+    const std::uint64_t begin = index.field_offset(row, col);
+    const std::uint64_t end = col + 1 < index.fields(row) ? index.field_offset(row, col + 1)
+                                                          : index.row_end(row);
+    std::vector<char> raw(static_cast<size_t>(end - begin));
+    detail::seek_file(fp, begin);
+    if (!raw.empty() && std::fread(raw.data(), 1, raw.size(), fp) != raw.size()) {
+      throw std::runtime_error("Failed to read cell: unexpected end of file");
+    }
+
+    // Later fields start right after a delimiter, i.e. in FIELD_NOT_BEGUN
+    detail::reset_row_state(p);
+    m_pimpl->m_plan.skip_rows = 0;
+    m_pimpl->m_plan.begin_row();
+    p.pstate = col > 0 ? detail::kPsFieldNotBegun : detail::kPsRowNotBegun;
+    CellContext cell;
+    size_t n = csv_parse(&p, raw.data(), raw.size(), capture_cell, nullptr, &cell);
+    const int c_error = csv_error(&p);
+    csv_fini(&p, cell.found ? nullptr : capture_cell, nullptr, &cell);
+    detail::reset_row_state(p);
+    if (c_error != 0) {
+      throw CsvError(std::string("CSV Parsing Error: ") + csv_strerror(c_error),
+        static_cast<CsvError::ErrorType>(c_error), n);
+    }
+    return std::move(cell.value);
+  }
+
+  std::string CsvParser::checkpoint(std::uint64_t offset, std::uint64_t row) const {
+    const struct csv_parser &p = m_pimpl->m_parser;
+    const detail::RowPlan &plan = m_pimpl->m_plan;
+    CheckpointHeader h{};
+    std::memcpy(h.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+    h.version = kCheckpointVersion;
+    h.byte_order = kByteOrder;
+    h.offset = offset;
+    h.row = row;
+    h.spaces = p.spaces;
+    h.entry_pos = p.entry_pos;
+    h.skip_rows = plan.skip_rows;
+    h.rejected = plan.rejected;
+    h.col = plan.col;
+    h.pstate = p.pstate;
+    h.quoted = p.quoted;
+    h.status = p.status;
+    h.delim = p.delim_char;
+    h.quote = p.quote_char;
+    h.options = p.options;
+    h.flags = static_cast<std::uint8_t>((m_pimpl->m_header_row ? kHeaderRow : 0) |
+                                        (plan.capture_header ? kCaptureHeader : 0) |
+                                        (plan.dropped ? kDropped : 0) | (plan.deciding ? kDeciding : 0) |
+                                        (plan.raw_escaped ? kRawEscaped : 0));
+
+    std::string out(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.append(reinterpret_cast<const char *>(p.entry_buf), p.entry_pos);
+    std::vector<std::string> names;
+    for (size_t c = 0; c < m_pimpl->m_header.size(); ++c) names.emplace_back(m_pimpl->m_header.name(c));
+    put_strings(out, names);
+    put_bytes(out, plan.project);
+    put_bytes(out, tested_columns(plan.filter));
+    put_strings(out, plan.header_fields);
+    put_bytes(out, plan.stage_chars);
+    put_bytes(out, plan.stage_null);
+    put_u64(out, plan.stage_begin.size());
+    for (size_t b : plan.stage_begin) put_u64(out, b);
+    return out;
+  }
+
+  CsvParser::ResumePoint CsvParser::restore(std::string_view state) {
+    CheckpointReader in(state);
+    CheckpointHeader h;
+    std::memcpy(&h, in.take(sizeof(h)).data(), sizeof(h));
+    if (std::memcmp(h.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) != 0 ||
+        h.version != kCheckpointVersion || h.byte_order != kByteOrder ||
+        h.pstate < detail::kPsRowNotBegun || h.pstate > detail::kPsFieldMightHaveEnded) {
+      bad_checkpoint();
+    }
+    // Only states csv_parse() can leave: quoting and spaces inside a field, a possible closing quote
+    // only in a quoted one, no pending error
+    const bool in_field = h.pstate == detail::kPsFieldBegun || h.pstate == detail::kPsFieldMightHaveEnded;
+    if ((h.quoted != 0 && h.quoted != 1) || (h.quoted != 0 && !in_field) ||
+        (h.quoted == 0 && h.pstate == detail::kPsFieldMightHaveEnded) || (h.spaces != 0 && !in_field) ||
+        h.status != CSV_SUCCESS) {
+      bad_checkpoint();
+    }
+    struct csv_parser &p = m_pimpl->m_parser;
+    if (h.delim != p.delim_char || h.quote != p.quote_char || h.options != p.options ||
+        ((h.flags & kHeaderRow) != 0) != m_pimpl->m_header_row) {
+      throw CsvError("CSV Checkpoint Error: checkpoint was taken with a different parser configuration",
+                     CsvError::ErrorType::Einvalid);
+    }
+
+    // Everything is read and checked before the parser is touched
+    const std::string_view entry = in.take(h.entry_pos);
+    std::vector<std::string> names;
+    std::vector<unsigned char> project;
+    std::vector<unsigned char> tested;
+    std::vector<std::string> header_fields;
+    std::vector<char> stage_chars;
+    std::vector<unsigned char> stage_null;
+    in.strings(names);
+    in.bytes(project);
+    in.bytes(tested);
+    in.strings(header_fields);
+    in.bytes(stage_chars);
+    in.bytes(stage_null);
+    if (in.u64() != stage_null.size() + 1) bad_checkpoint();
+    std::vector<size_t> stage_begin(stage_null.size() + 1);
+    for (size_t &b : stage_begin) b = static_cast<size_t>(in.u64());
+    if (!in.done() || stage_begin.front() != 0 || stage_begin.back() != stage_chars.size()) bad_checkpoint();
+    for (size_t i = 1; i < stage_begin.size(); ++i) {
+      if (stage_begin[i] <= stage_begin[i - 1]) bad_checkpoint();
+    }
+
+    // The header is rebuilt first: the projection and filter may name its columns
+    HeaderMap header(names);
+    std::vector<unsigned char> current = m_pimpl->m_projection_names.empty() ? m_pimpl->m_plan.project
+                                                                             : std::vector<unsigned char>();
+    if (!m_pimpl->m_projection_names.empty() && !header.empty()) {
+      for (const std::string &name : m_pimpl->m_projection_names) {
+        const size_t c = header.index(name);
+        if (c >= current.size()) current.resize(c + 1, 0);
+        current[c] = 1;
+      }
+    }
+    const RowFilter filter = m_pimpl->m_filter.has_names() && !header.empty() ? m_pimpl->m_filter.resolve(header)
+                                                                              : m_pimpl->m_plan.filter;
+    if (current != project || tested_columns(filter) != tested) {
+      throw CsvError("CSV Checkpoint Error: checkpoint was taken with a different projection or filter",
+                     CsvError::ErrorType::Einvalid);
+    }
+
+    // A kept field drops its trailing spaces, and a closing quote, from the buffered bytes on submit
+    const bool deciding = (h.flags & kDeciding) != 0;
+    const bool keeps = (h.flags & kCaptureHeader) != 0 ||
+                       ((h.flags & kDropped) == 0 &&
+                        (project.empty() || (h.col < project.size() && project[h.col]) ||
+                         (deciding && h.col < tested.size() && tested[h.col])));
+    if (keeps && (h.spaces > h.entry_pos || (h.pstate == detail::kPsFieldMightHaveEnded && h.spaces == h.entry_pos))) {
+      bad_checkpoint();
+    }
+
+    // One spare byte for Option::AppendNull; allocated even for an empty field, which finish() terminates
+    while (p.entry_size <= entry.size()) {
+      if (p.realloc_func == nullptr || detail::grow_entry_buffer(p) != 0) {
+        const int c_error = p.realloc_func == nullptr ? CSV_ENOMEM : csv_error(&p);
+        detail::reset_row_state(p);
+        throw std::runtime_error(csv_strerror(c_error));
+      }
+    }
+    m_pimpl->m_header = std::move(header);
+    m_pimpl->resolve_names();
+
+    detail::RowPlan &plan = m_pimpl->m_plan;
+    plan.skip_rows = h.skip_rows;
+    plan.rejected = h.rejected;
+    plan.capture_header = (h.flags & kCaptureHeader) != 0;
+    plan.header_ready = false;
+    plan.header_fields = std::move(header_fields);
+    plan.col = static_cast<size_t>(h.col);
+    plan.dropped = (h.flags & kDropped) != 0;
+    plan.deciding = (h.flags & kDeciding) != 0;
+    plan.raw_escaped = (h.flags & kRawEscaped) != 0;
+    plan.stage_chars = std::move(stage_chars);
+    plan.stage_begin = std::move(stage_begin);
+    plan.stage_null = std::move(stage_null);
+
+    if (!entry.empty()) std::memcpy(p.entry_buf, entry.data(), entry.size());
+    p.entry_pos = entry.size();
+    p.pstate = h.pstate;
+    p.quoted = h.quoted;
+    p.spaces = static_cast<size_t>(h.spaces);
+    p.status = h.status;
+    return {h.offset, h.row};
+  }
+
+  void detail::begin_random_rows(CsvParser &parser, const unsigned char *file, size_t size) {
+    auto &state = ParserAccess::state(parser);
+    reset_row_state(state.m_parser);
+    state.m_plan.skip_rows = 0;
+    state.m_plan.header_fields.clear();
+    state.m_plan.begin_row();
+    if (!state.m_header_row) return;
+    if (state.m_plan.capture_header) {
+      // Captures the header; no data row is parsed
+      const size_t end = StructTable(state.m_parser).row_end(file, size);
+      parser.parse(file, end, nullptr, nullptr, nullptr);
+      if (end == size) parser.finish(nullptr, nullptr, nullptr);  // header without terminator
+    }
+    state.m_plan.capture_header = false;
+  }
+
   void CsvParser::set_options(Options options) {
         csv_set_opts(&m_pimpl->m_parser, 
           convert_options_to_c_flags(options.begin(), options.end()));
@@ -164,4 +787,16 @@ namespace csv {
     return csv_get_buffer_size(&m_pimpl->m_parser);
   }
 
+  void CsvParser::set_engine(Engine engine) noexcept {
+    m_pimpl->m_engine = engine;
+  }
+
+  CsvParser::Engine CsvParser::get_engine() const noexcept {
+    return m_pimpl->m_engine;
+  }
+
+  const CsvParser::EngineStats &CsvParser::engine_stats() const noexcept {
+    return m_pimpl->m_engine_stats;
+  }
+
 } // namespace csv
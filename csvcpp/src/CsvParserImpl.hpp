@@ -0,0 +1,159 @@
+#ifndef CSV_PARSER_IMPL_HPP
+#define CSV_PARSER_IMPL_HPP
+
+#include "CsvParser.hpp"
+
+#include "Engine.hpp"
+#include "HeaderMap.hpp"
+#include "csv.h"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Internal: CsvParser state shared with the index and scanning modules.
+
+namespace csv {
+
+  namespace detail {
+
+    /// Byte classes counted over sampled input, for Engine::Auto
+    struct EngineProfile {
+      std::uint64_t bytes = 0;
+      std::uint64_t quotes = 0;
+      std::uint64_t delims = 0;
+      std::uint64_t terms = 0;
+    };
+
+  } // namespace detail
+
+  struct CsvParser::impl {
+    struct csv_parser m_parser{};
+    detail::RowPlan m_plan;  // projection, filter and seek skipping
+
+    // Engine selection (set_engine())
+    Engine m_engine = Engine::Libcsv;
+    EngineStats m_engine_stats;
+    detail::EngineProfile m_profile;  // Engine::Auto: the samples m_auto_choice is based on
+    Engine m_auto_choice = Engine::Runs;
+
+    // detail::default_classes(), cached for the functions and characters it was computed with
+    bool m_default_classes = false;
+    int (*m_classes_space)(unsigned char) = nullptr;
+    int (*m_classes_term)(unsigned char) = nullptr;
+    int m_classes_chars = -1;  // delim << 8 | quote
+
+    // Header row and the name-based settings resolved against it
+    bool m_header_row = false;
+    HeaderMap m_header;
+    std::vector<std::string> m_projection_names;
+    RowFilter m_filter;  // as given to set_filter(), possibly with names
+
+    /// Whether parse() and finish() go through the C++ tokenizer
+    [[nodiscard]] bool plan_engine() const noexcept {
+      return m_plan.active() || m_engine != Engine::Libcsv;
+    }
+
+    /// The engine @p e runs as under the current plan and character classes
+    [[nodiscard]] Engine effective_engine(Engine e) noexcept;
+
+    /// Engine::Auto's pick for the block at @p s, profiling it when due
+    Engine choose_engine(const unsigned char *s, std::size_t len) noexcept;
+
+    /// parse() on engine @p e, taking a header row that completes on the way
+    std::size_t parse_with(Engine e, const void *s, std::size_t len,
+                           detail::FieldCallback cb1, detail::RowCallback cb2, void *data);
+
+    /// Whether names are in use that no header has resolved yet
+    [[nodiscard]] bool names_pending() const noexcept {
+      return m_header.empty() && (!m_projection_names.empty() || m_filter.has_names());
+    }
+
+    /// Builds m_header from the captured row and resolves names against it
+    void take_header();
+
+    /// Applies the projection names and m_filter to m_plan
+    void resolve_names();
+
+    ~impl() {
+      csv_free(&m_parser);
+    }
+  };
+
+  namespace detail {
+
+    /// Discards any partial row; the next byte parsed starts a new row
+    inline void reset_row_state(struct csv_parser &p) noexcept {
+      p.pstate = kPsRowNotBegun;
+      p.quoted = 0;
+      p.spaces = 0;
+      p.entry_pos = 0;
+      p.status = 0;
+    }
+
+    /**
+     * @brief Readies @p parser for rows picked out of the mapped file @p file.
+     *
+     * Discards any partial row. With set_header_row(), a header not
+     * captured yet is parsed from the start of the file first; the parser
+     * is finished if the file holds nothing else.
+     */
+    void begin_random_rows(CsvParser &parser, const unsigned char *file, std::size_t size);
+
+    /**
+     * @brief Standalone csv_parser with the delimiter, quote, character
+     *        classes and options of another one, for internal passes that
+     *        must not disturb the caller's parser.
+     */
+    class ScratchParser {
+    public:
+      explicit ScratchParser(const struct csv_parser &cfg) {
+        if (csv_init(&m_parser, cfg.options) != 0) {
+          throw std::runtime_error("CSV Parser Initialization Failed");
+        }
+        csv_set_delim(&m_parser, cfg.delim_char);
+        csv_set_quote(&m_parser, cfg.quote_char);
+        csv_set_space_func(&m_parser, cfg.is_space);
+        csv_set_term_func(&m_parser, cfg.is_term);
+      }
+
+      ScratchParser(const ScratchParser&) = delete;
+      ScratchParser& operator=(const ScratchParser&) = delete;
+      ~ScratchParser() { csv_free(&m_parser); }
+
+      /**
+       * @brief Parses @p len bytes found at file offset @p offset as one document.
+       *
+       * @throws CsvError on parse errors, with bytes_parsed counted from the file start
+       */
+      void run(const void *p, std::size_t len, std::uint64_t offset,
+               void (*cb1)(void *, std::size_t, void *), void (*cb2)(int, void *), void *data) {
+        const std::size_t n = csv_parse(&m_parser, p, len, cb1, cb2, data);
+        int c_error = csv_error(&m_parser);
+        if (c_error == 0 && csv_fini(&m_parser, cb1, cb2, data) != 0) {
+          c_error = csv_error(&m_parser);
+        }
+        if (c_error != 0) {
+          reset_row_state(m_parser);
+          throw CsvError(std::string("CSV Parsing Error: ") + csv_strerror(c_error),
+                         static_cast<CsvError::ErrorType>(c_error), static_cast<std::size_t>(offset + n));
+        }
+      }
+
+    private:
+      struct csv_parser m_parser{};
+    };
+
+    /**
+     * @brief Grants library modules access to the underlying libcsv parser.
+     */
+    struct ParserAccess {
+      static struct csv_parser &get(CsvParser &p) noexcept { return p.m_pimpl->m_parser; }
+      static const struct csv_parser &get(const CsvParser &p) noexcept { return p.m_pimpl->m_parser; }
+      static CsvParser::impl &state(CsvParser &p) noexcept { return *p.m_pimpl; }
+    };
+
+  } // namespace detail
+} // namespace csv
+
+#endif // CSV_PARSER_IMPL_HPP
@@ -0,0 +1,733 @@
+#include "Engine.hpp"
+
+#include "Classify.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace csv {
+  namespace detail {
+
+    int grow_entry_buffer(struct csv_parser &p) noexcept {
+      if (p.realloc_func == nullptr) return 0;
+
+      size_t to_add = p.blk_size;
+      if (p.entry_size >= SIZE_MAX - to_add) to_add = SIZE_MAX - p.entry_size;
+      if (!to_add) {
+        p.status = CSV_ETOOBIG;
+        return -1;
+      }
+
+      void *vp;
+      while ((vp = p.realloc_func(p.entry_buf, p.entry_size + to_add)) == nullptr) {
+        to_add /= 2;
+        if (!to_add) {
+          p.status = CSV_ENOMEM;
+          return -1;
+        }
+      }
+      p.entry_buf = static_cast<unsigned char *>(vp);
+      p.entry_size += to_add;
+      return 0;
+    }
+
+    namespace {
+
+      /*
+       * Parser state held in locals for the duration of one call, written
+       * back by save(). Mirrors the SUBMIT_* macros of libcsv.c, with the
+       * plan deciding which fields are buffered and delivered.
+       *
+       * Field bytes are written at base, which is the entry buffer except
+       * for in-situ fields: those are compacted over the input itself,
+       * base being where the field starts. Unescaping only ever shrinks a
+       * field, so writes never overtake the byte being read.
+       */
+      struct Tokenizer {
+        struct csv_parser &p;
+        RowPlan &plan;
+        FieldCallback cb1;
+        RowCallback cb2;
+        void *data;
+        int quoted;
+        int pstate;
+        size_t spaces;
+        size_t entry_pos;
+        bool keep;
+        unsigned char *base;
+
+        Tokenizer(struct csv_parser &parser, RowPlan &pl, FieldCallback f, RowCallback r, void *d) noexcept
+            : p(parser), plan(pl), cb1(f), cb2(r), data(d), quoted(parser.quoted), pstate(parser.pstate),
+              spaces(parser.spaces), entry_pos(parser.entry_pos), keep(pl.keeps(pl.col)),
+              base(parser.entry_buf) {}
+
+        /// Writes the state back, moving an unfinished in-situ field to the entry buffer
+        void save() noexcept {
+          if (base != p.entry_buf && pstate != kPsRowNotBegun) {
+            // Room for the bytes and AppendNull; finish() needs a buffer even for an empty field
+            while (p.status == 0 && p.entry_size <= entry_pos) {
+              if (p.realloc_func == nullptr) p.status = CSV_ENOMEM;
+              else grow_entry_buffer(p);
+            }
+            if (p.status == 0 && entry_pos > 0) std::memcpy(p.entry_buf, base, entry_pos);
+            if (p.status != 0) entry_pos = 0;
+          }
+          base = p.entry_buf;
+          p.quoted = quoted, p.pstate = pstate, p.spaces = spaces, p.entry_pos = entry_pos;
+        }
+
+        void submit_char(unsigned char c) noexcept {
+          if (keep) base[entry_pos++] = c;
+        }
+
+        void deliver(void *s, size_t len) {
+          if (cb1) cb1(s, len, data);
+        }
+
+        void submit_field() {
+          if (keep) {
+            if (!quoted) entry_pos -= spaces;
+            if (p.options & CSV_APPEND_NULL) base[entry_pos] = '\0';
+            const bool is_null = (p.options & CSV_EMPTY_IS_NULL) && !quoted && entry_pos == 0;
+            void *s = is_null ? nullptr : base;
+            const size_t col = plan.col;
+
+            if (plan.capture_header) {
+              plan.header_fields.emplace_back(reinterpret_cast<const char *>(base), entry_pos);
+            } else if (plan.deciding && !plan.filter.matches(col, FieldView(static_cast<const char *>(s), entry_pos))) {
+              plan.dropped = true;
+            } else if (plan.deciding && col < plan.filter.last_column()) {
+              if (plan.delivers(col)) {
+                // Held back until the row passes every predicate
+                if (s) plan.stage_chars.insert(plan.stage_chars.end(), base, base + entry_pos);
+                plan.stage_chars.push_back('\0');
+                plan.stage_begin.push_back(plan.stage_chars.size());
+                plan.stage_null.push_back(s == nullptr);
+              }
+            } else {
+              if (plan.deciding) {
+                plan.deciding = false;
+                for (size_t i = 0; i < plan.stage_null.size(); ++i) {
+                  const size_t b = plan.stage_begin[i];
+                  deliver(plan.stage_null[i] ? nullptr : plan.stage_chars.data() + b,
+                          plan.stage_begin[i + 1] - b - 1);
+                }
+              }
+              if (plan.delivers(col)) deliver(s, entry_pos);
+            }
+          }
+          pstate = kPsFieldNotBegun;
+          entry_pos = 0, quoted = 0, spaces = 0;
+          keep = plan.keeps(++plan.col);
+        }
+
+        /// @return true when the row completed the header
+        bool submit_row(int c) {
+          if (plan.capture_header) {
+            if (plan.col > 0) {  // blank lines (RepAllNl) before the header are ignored
+              plan.capture_header = false;
+              plan.header_ready = true;
+            }
+          } else if (plan.skip_rows > 0) --plan.skip_rows;
+          else if (plan.dropped || plan.deciding) ++plan.rejected;
+          else if (cb2) cb2(c, data);
+          pstate = kPsRowNotBegun;
+          entry_pos = 0, quoted = 0, spaces = 0;
+          plan.begin_row();
+          keep = plan.keeps(0);
+          return plan.header_ready;
+        }
+      };
+
+      /*
+       * Finds where a run of plain field bytes ends: at the next quote
+       * inside quotes, at the next quote, delimiter or terminator
+       * otherwise. The structural variant is two-stage: the input is
+       * classified 64 bytes at a time into bit masks, and the tokenizer
+       * jumps straight between their set bits. It relies on the default
+       * space and terminator classes (detail::default_classes()).
+       */
+      struct RunScanner {
+        const unsigned char *us;
+        size_t len;
+        unsigned char delim;
+        unsigned char quote;
+        int (*is_term)(unsigned char);
+        bool structural;
+        size_t block = SIZE_MAX;  // offset of the classified block
+        std::uint64_t quotes = 0;
+        std::uint64_t specials = 0;
+
+        size_t next(size_t pos, bool quoted) noexcept {
+          if (structural) {
+            while (pos < len) {
+              const size_t b = pos - pos % kClassifyBlock;
+              if (b + kClassifyBlock > len) break;  // the tail is scanned below
+              if (b != block) {
+                const Masks m = classify(us + b, quote, delim);
+                quotes = m.quote;
+                specials = m.quote | m.delim | m.term;
+                block = b;
+              }
+              const std::uint64_t mask = (quoted ? quotes : specials) >> (pos - b);
+              if (mask) return pos + lowest_bit(mask);
+              pos = b + kClassifyBlock;
+            }
+          }
+          if (quoted) {
+            const void *q = std::memchr(us + pos, quote, len - pos);
+            return q ? static_cast<size_t>(static_cast<const unsigned char *>(q) - us) : len;
+          }
+          while (pos < len && us[pos] != delim && us[pos] != quote &&
+                 !(is_term ? is_term(us[pos]) != 0 : us[pos] == CSV_CR || us[pos] == CSV_LF)) {
+            ++pos;
+          }
+          return pos;
+        }
+      };
+
+      /// The tokenizer loop; in situ when the input is mutable (Byte is not const)
+      template <typename Byte>
+      size_t tokenize(struct csv_parser &p, RowPlan &plan, Byte *us, size_t len,
+                      FieldCallback cb1, RowCallback cb2, void *data, bool structural) {
+        constexpr bool kInSitu = !std::is_const<Byte>::value;
+        size_t pos = 0;
+
+        const unsigned char delim = p.delim_char;
+        const unsigned char quote = p.quote_char;
+        int (*const is_space)(unsigned char) = p.is_space;
+        int (*const is_term)(unsigned char) = p.is_term;
+        const bool append_null = (p.options & CSV_APPEND_NULL) != 0;
+        auto space = [&](unsigned char c) {
+          return is_space ? is_space(c) != 0 : c == CSV_SPACE || c == CSV_TAB;
+        };
+        auto term = [&](unsigned char c) {
+          return is_term ? is_term(c) != 0 : c == CSV_CR || c == CSV_LF;
+        };
+
+        Tokenizer t(p, plan, cb1, cb2, data);
+        RunScanner scan{us, len, delim, quote, is_term, structural};
+
+        if (!kInSitu && !p.entry_buf && pos < len) {
+          if (grow_entry_buffer(p) != 0) {
+            t.save();
+            return pos;
+          }
+          t.base = p.entry_buf;
+        }
+
+        while (pos < len) {
+          if (t.pstate == kPsFieldBegun) {
+            // Jump to the next byte that can change the state: only the quote inside quotes
+            const size_t end = scan.next(pos, t.quoted != 0);
+
+            // The bytes skipped are all plain characters: copied as one run when buffered
+            size_t run = end - pos;
+            bool full = false;
+            if (t.keep && run > 0) {
+              if (!kInSitu || t.base == p.entry_buf) {
+                // One reservation, growing as csv_parse() would byte by byte
+                const size_t reserve = append_null ? 1 : 0;
+                while (t.entry_pos + run + reserve > p.entry_size) {
+                  if (p.realloc_func == nullptr) p.status = CSV_ENOMEM;
+                  if (p.status != 0 || grow_entry_buffer(p) != 0) {
+                    // Stop at the byte csv_parse() fails on
+                    full = true;
+                    run = p.entry_size > t.entry_pos + reserve ? p.entry_size - t.entry_pos - reserve : 0;
+                    break;
+                  }
+                }
+                t.base = p.entry_buf;
+                if (run > 0) std::memcpy(t.base + t.entry_pos, us + pos, run);
+              } else if (t.base + t.entry_pos != us + pos) {
+                std::memmove(t.base + t.entry_pos, us + pos, run);  // compacting behind an escaped quote
+              }
+              t.entry_pos += run;
+            }
+            if (!t.quoted && run > 0) {
+              size_t trailing = 0;
+              while (trailing < run && space(us[pos + run - 1 - trailing])) ++trailing;
+              t.spaces = trailing == run ? t.spaces + run : trailing;
+            }
+            pos += run;
+            if (full) {
+              t.save();
+              return pos;
+            }
+            if (pos == len) break;
+          }
+          if (t.keep && (!kInSitu || t.base == p.entry_buf) &&
+              t.entry_pos + (append_null ? 1 : 0) >= p.entry_size) {
+            if (grow_entry_buffer(p) != 0) {
+              t.save();
+              return pos;
+            }
+            t.base = p.entry_buf;
+          }
+
+          const unsigned char c = us[pos++];
+
+          switch (t.pstate) {
+            case kPsRowNotBegun:
+            case kPsFieldNotBegun:
+              if (space(c) && c != delim) {
+                continue;
+              } else if (term(c)) {
+                if (t.pstate == kPsFieldNotBegun) {
+                  if constexpr (kInSitu) t.base = us + pos - 1;  // empty field; AppendNull replaces the terminator
+                  t.submit_field();
+                  if (t.submit_row(c)) {
+                    t.save();
+                    return pos;  // header complete
+                  }
+                } else if (p.options & CSV_REPALL_NL) {
+                  t.submit_row(c);
+                }
+                continue;
+              } else if (c == delim) {
+                if constexpr (kInSitu) t.base = us + pos - 1;
+                t.submit_field();
+                break;
+              } else if (c == quote) {
+                if constexpr (kInSitu) t.base = us + pos;
+                t.pstate = kPsFieldBegun;
+                t.quoted = 1;
+              } else {
+                if constexpr (kInSitu) t.base = us + pos - 1;
+                t.pstate = kPsFieldBegun;
+                t.quoted = 0;
+                t.submit_char(c);
+              }
+              break;
+            case kPsFieldBegun:
+              if (c == quote) {
+                if (t.quoted) {
+                  t.submit_char(c);
+                  t.pstate = kPsFieldMightHaveEnded;
+                } else {
+                  if (p.options & CSV_STRICT) {
+                    p.status = CSV_EPARSE;
+                    t.save();
+                    return pos - 1;
+                  }
+                  t.submit_char(c);
+                  t.spaces = 0;
+                }
+              } else if (c == delim) {
+                if (t.quoted) t.submit_char(c);
+                else t.submit_field();
+              } else if (term(c)) {
+                if (!t.quoted) {
+                  t.submit_field();
+                  if (t.submit_row(c)) {
+                    t.save();
+                    return pos;  // header complete
+                  }
+                } else {
+                  t.submit_char(c);
+                }
+              } else if (!t.quoted && space(c)) {
+                t.submit_char(c);
+                t.spaces++;
+              } else {
+                t.submit_char(c);
+                t.spaces = 0;
+              }
+              break;
+            case kPsFieldMightHaveEnded:
+              if (c == delim) {
+                if (t.keep) t.entry_pos -= t.spaces + 1;  // drop spaces and the closing quote
+                t.submit_field();
+              } else if (term(c)) {
+                if (t.keep) t.entry_pos -= t.spaces + 1;
+                t.submit_field();
+                if (t.submit_row(c)) {
+                  t.save();
+                  return pos;  // header complete
+                }
+              } else if (space(c)) {
+                t.submit_char(c);
+                t.spaces++;
+              } else if (c == quote) {
+                if (t.spaces) {
+                  if (p.options & CSV_STRICT) {
+                    p.status = CSV_EPARSE;
+                    t.save();
+                    return pos - 1;
+                  }
+                  t.spaces = 0;
+                  t.submit_char(c);
+                } else {
+                  t.pstate = kPsFieldBegun;  // escaped quote
+                }
+              } else {
+                if (p.options & CSV_STRICT) {
+                  p.status = CSV_EPARSE;
+                  t.save();
+                  return pos - 1;
+                }
+                t.pstate = kPsFieldBegun;
+                t.spaces = 0;
+                t.submit_char(c);
+              }
+              break;
+            default:
+              break;
+          }
+        }
+        t.save();
+        return pos;
+      }
+
+    } // namespace
+
+    size_t plan_parse(struct csv_parser &p, RowPlan &plan, const void *s, size_t len,
+                      FieldCallback cb1, RowCallback cb2, void *data) {
+      if (s == nullptr) return 0;
+      return tokenize(p, plan, static_cast<const unsigned char *>(s), len, cb1, cb2, data, false);
+    }
+
+    size_t plan_parse_structural(struct csv_parser &p, RowPlan &plan, const void *s, size_t len,
+                                 FieldCallback cb1, RowCallback cb2, void *data) {
+      if (s == nullptr) return 0;
+      return tokenize(p, plan, static_cast<const unsigned char *>(s), len, cb1, cb2, data, true);
+    }
+
+    size_t plan_parse_insitu(struct csv_parser &p, RowPlan &plan, void *s, size_t len,
+                             FieldCallback cb1, RowCallback cb2, void *data) {
+      if (s == nullptr) return 0;
+      return tokenize(p, plan, static_cast<unsigned char *>(s), len, cb1, cb2, data, false);
+    }
+
+    int plan_finish(struct csv_parser &p, RowPlan &plan, FieldCallback cb1, RowCallback cb2, void *data) {
+      if (p.pstate == kPsFieldBegun && p.quoted && (p.options & CSV_STRICT) && (p.options & CSV_STRICT_FINI)) {
+        p.status = CSV_EPARSE;
+        return -1;
+      }
+
+      Tokenizer t(p, plan, cb1, cb2, data);
+      switch (t.pstate) {
+        case kPsFieldMightHaveEnded:
+          if (t.keep) t.entry_pos -= t.spaces + 1;
+          t.submit_field();
+          t.submit_row(-1);
+          break;
+        case kPsFieldNotBegun:
+        case kPsFieldBegun:
+          t.submit_field();
+          t.submit_row(-1);
+          break;
+        default:
+          break;
+      }
+
+      p.spaces = 0, p.quoted = 0, p.entry_pos = 0, p.status = 0;
+      p.pstate = kPsRowNotBegun;
+      plan.begin_row();
+      return 0;
+    }
+
+    namespace {
+
+      const unsigned char kNoInput[1] = {0};
+
+      /*
+       * State of raw_parse() for one call. A field is delivered as its span
+       * of the input, from begin up to the delimiter; only a field that
+       * began in an earlier call has its raw bytes gathered in the entry
+       * buffer (p.entry_pos of them so far).
+       */
+      struct RawTokenizer {
+        struct csv_parser &p;
+        RowPlan &plan;
+        RawFieldCallback cb1;
+        RowCallback cb2;
+        void *data;
+        const unsigned char *in;
+        int quoted;
+        int pstate;
+        size_t spaces;
+        size_t begin = 0;
+        bool carried;
+        bool escaped;
+        bool keep;
+        std::string scratch;
+
+        RawTokenizer(struct csv_parser &parser, RowPlan &pl, const unsigned char *input,
+                     RawFieldCallback f, RowCallback r, void *d) noexcept
+            : p(parser), plan(pl), cb1(f), cb2(r), data(d), in(input), quoted(parser.quoted),
+              pstate(parser.pstate), spaces(parser.spaces),
+              carried(parser.pstate == kPsFieldBegun || parser.pstate == kPsFieldMightHaveEnded),
+              escaped(pl.raw_escaped), keep(pl.keeps(pl.col)) {}
+
+        bool space(unsigned char c) const noexcept {
+          return p.is_space ? p.is_space(c) != 0 : c == CSV_SPACE || c == CSV_TAB;
+        }
+
+        /// Appends to the entry buffer; false with p.status set when it cannot grow
+        bool append(const unsigned char *s, size_t n) noexcept {
+          while (p.entry_size - p.entry_pos < n) {
+            if (p.realloc_func == nullptr) p.status = CSV_ENOMEM;
+            else grow_entry_buffer(p);
+            if (p.status != 0) return false;
+          }
+          if (n > 0) std::memcpy(p.entry_buf + p.entry_pos, s, n);
+          p.entry_pos += n;
+          return true;
+        }
+
+        /// Moves the bytes of an unfinished field to the entry buffer and writes the state back
+        void save(size_t end) noexcept {
+          if (keep && (pstate == kPsFieldBegun || pstate == kPsFieldMightHaveEnded) && p.status == 0) {
+            if (carried) append(in, end);
+            else append(in + begin, end - begin);
+          }
+          p.quoted = quoted, p.pstate = pstate, p.spaces = spaces;
+          plan.raw_escaped = escaped;
+        }
+
+        void deliver(const RawField &f) {
+          if (cb1) cb1(f, data);
+        }
+
+        /// Submits the field ending at in[end]; false when the entry buffer cannot grow
+        bool submit_field(size_t end) {
+          if (keep) {
+            const unsigned char *raw = in + begin;
+            size_t n = end - begin;
+            if (carried) {
+              if (!append(in, end)) return false;
+              raw = p.entry_buf;
+              n = p.entry_pos;
+            }
+            // Unquoted fields start after the leading spaces, so this stops at their first byte
+            size_t trailing = spaces;
+            if (!quoted) {
+              trailing = 0;
+              while (trailing < n && space(raw[n - 1 - trailing])) ++trailing;
+            }
+            const bool is_null = (p.options & CSV_EMPTY_IS_NULL) && !quoted && n == 0;
+            const RawField f = is_null ? RawField()
+                                       : RawField(reinterpret_cast<const char *>(raw), n, quoted != 0,
+                                                  pstate == kPsFieldMightHaveEnded, trailing, escaped,
+                                                  static_cast<char>(p.quote_char), carried);
+            const size_t col = plan.col;
+
+            if (plan.capture_header) {
+              plan.header_fields.push_back(f.str());
+            } else if (plan.deciding && !plan.filter.matches(col, f.value(scratch))) {
+              plan.dropped = true;
+            } else if (plan.deciding && col < plan.filter.last_column()) {
+              if (plan.delivers(col)) {
+                // Held back, unescaped, until the row passes every predicate
+                const FieldView v = f.value(scratch);
+                if (!v.is_null()) plan.stage_chars.insert(plan.stage_chars.end(), v.data(), v.data() + v.size());
+                plan.stage_chars.push_back('\0');
+                plan.stage_begin.push_back(plan.stage_chars.size());
+                plan.stage_null.push_back(v.is_null());
+              }
+            } else {
+              if (plan.deciding) {
+                plan.deciding = false;
+                for (size_t i = 0; i < plan.stage_null.size(); ++i) {
+                  const size_t b = plan.stage_begin[i];
+                  deliver(plan.stage_null[i] ? RawField()
+                                             : RawField(plan.stage_chars.data() + b, plan.stage_begin[i + 1] - b - 1,
+                                                        false, false, 0, false,
+                                                        static_cast<char>(p.quote_char), true));
+                }
+              }
+              if (plan.delivers(col)) deliver(f);
+            }
+          }
+          pstate = kPsFieldNotBegun;
+          p.entry_pos = 0, quoted = 0, spaces = 0;
+          carried = escaped = false;
+          keep = plan.keeps(++plan.col);
+          return true;
+        }
+
+        /// @return true when the row completed the header
+        bool submit_row(int c) {
+          if (plan.capture_header) {
+            if (plan.col > 0) {  // blank lines (RepAllNl) before the header are ignored
+              plan.capture_header = false;
+              plan.header_ready = true;
+            }
+          } else if (plan.skip_rows > 0) --plan.skip_rows;
+          else if (plan.dropped || plan.deciding) ++plan.rejected;
+          else if (cb2) cb2(c, data);
+          pstate = kPsRowNotBegun;
+          p.entry_pos = 0, quoted = 0, spaces = 0;
+          plan.begin_row();
+          keep = plan.keeps(0);
+          return plan.header_ready;
+        }
+      };
+
+    } // namespace
+
+    size_t raw_parse(struct csv_parser &p, RowPlan &plan, const void *s, size_t len,
+                     RawFieldCallback cb1, RowCallback cb2, void *data) {
+      if (s == nullptr) return 0;
+
+      /*
+       * Only a carried field, always the first one of the call, can fail
+       * to join the entry buffer; nothing has been delivered or written back
+       * yet. Parse again just the bytes that fit, so save() stores them with
+       * the state reached there: like csv_parse(), stop at the first byte
+       * that cannot be kept.
+       */
+      auto out_of_memory = [&]() -> size_t {
+        const int status = p.status;
+        p.status = 0;
+        const size_t used = raw_parse(p, plan, s, p.entry_size - p.entry_pos, cb1, cb2, data);
+        p.status = status;
+        return used;
+      };
+
+      const auto *us = static_cast<const unsigned char *>(s);
+      size_t pos = 0;
+
+      const unsigned char delim = p.delim_char;
+      const unsigned char quote = p.quote_char;
+      int (*const is_term)(unsigned char) = p.is_term;
+      auto term = [&](unsigned char c) {
+        return is_term ? is_term(c) != 0 : c == CSV_CR || c == CSV_LF;
+      };
+
+      RawTokenizer t(p, plan, us, cb1, cb2, data);
+
+      while (pos < len) {
+        if (t.pstate == kPsFieldBegun) {
+          // Nothing is copied: jump to the next byte that can change the state
+          if (t.quoted) {
+            const void *q = std::memchr(us + pos, quote, len - pos);
+            if (!q) {
+              pos = len;
+              break;
+            }
+            pos = static_cast<size_t>(static_cast<const unsigned char *>(q) - us);
+          } else {
+            while (pos < len && us[pos] != delim && us[pos] != quote && !term(us[pos])) ++pos;
+            if (pos == len) break;
+          }
+        }
+
+        const unsigned char c = us[pos++];
+
+        switch (t.pstate) {
+          case kPsRowNotBegun:
+          case kPsFieldNotBegun:
+            if (t.space(c) && c != delim) {
+              continue;
+            } else if (term(c)) {
+              if (t.pstate == kPsFieldNotBegun) {
+                t.begin = pos - 1;
+                if (!t.submit_field(pos - 1)) return out_of_memory();
+                if (t.submit_row(c)) {
+                  t.save(pos);
+                  return pos;  // header complete
+                }
+              } else if (p.options & CSV_REPALL_NL) {
+                t.submit_row(c);
+              }
+              continue;
+            } else if (c == delim) {
+              t.begin = pos - 1;
+              if (!t.submit_field(pos - 1)) return out_of_memory();
+              break;
+            }
+            t.begin = pos - 1;
+            t.pstate = kPsFieldBegun;
+            t.quoted = c == quote;
+            break;
+          case kPsFieldBegun:
+            if (c == quote) {
+              if (t.quoted) {
+                t.pstate = kPsFieldMightHaveEnded;
+              } else if (p.options & CSV_STRICT) {
+                p.status = CSV_EPARSE;
+                t.save(pos - 1);
+                return pos - 1;
+              }
+            } else if (c == delim) {
+              if (!t.submit_field(pos - 1)) return out_of_memory();
+            } else {  // terminator
+              if (!t.submit_field(pos - 1)) return out_of_memory();
+              if (t.submit_row(c)) {
+                t.save(pos);
+                return pos;  // header complete
+              }
+            }
+            break;
+          case kPsFieldMightHaveEnded:
+            if (c == delim) {
+              if (!t.submit_field(pos - 1)) return out_of_memory();
+            } else if (term(c)) {
+              if (!t.submit_field(pos - 1)) return out_of_memory();
+              if (t.submit_row(c)) {
+                t.save(pos);
+                return pos;  // header complete
+              }
+            } else if (t.space(c)) {
+              t.spaces++;
+            } else if (c == quote) {
+              if (t.spaces) {
+                if (p.options & CSV_STRICT) {
+                  p.status = CSV_EPARSE;
+                  t.save(pos - 1);
+                  return pos - 1;
+                }
+                t.spaces = 0;
+              } else {
+                t.pstate = kPsFieldBegun;  // escaped quote
+                t.escaped = true;
+              }
+            } else {
+              if (p.options & CSV_STRICT) {
+                p.status = CSV_EPARSE;
+                t.save(pos - 1);
+                return pos - 1;
+              }
+              t.pstate = kPsFieldBegun;
+              t.spaces = 0;
+            }
+            break;
+          default:
+            break;
+        }
+      }
+      t.save(len);
+      return pos;
+    }
+
+    int raw_finish(struct csv_parser &p, RowPlan &plan, RawFieldCallback cb1, RowCallback cb2, void *data) {
+      if (p.pstate == kPsFieldBegun && p.quoted && (p.options & CSV_STRICT) && (p.options & CSV_STRICT_FINI)) {
+        p.status = CSV_EPARSE;
+        return -1;
+      }
+
+      // A field in progress is entirely in the entry buffer by now
+      RawTokenizer t(p, plan, kNoInput, cb1, cb2, data);
+      switch (t.pstate) {
+        case kPsFieldMightHaveEnded:
+        case kPsFieldNotBegun:
+        case kPsFieldBegun:
+          if (!t.submit_field(0)) return -1;
+          t.submit_row(-1);
+          break;
+        default:
+          break;
+      }
+
+      p.spaces = 0, p.quoted = 0, p.entry_pos = 0, p.status = 0;
+      p.pstate = kPsRowNotBegun;
+      plan.begin_row();
+      return 0;
+    }
+
+  } // namespace detail
+} // namespace csv
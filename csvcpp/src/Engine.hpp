@@ -0,0 +1,148 @@
+#ifndef CSV_ENGINE_HPP
+#define CSV_ENGINE_HPP
+
+#include "RawField.hpp"
+#include "RowFilter.hpp"
+#include "csv.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Internal: C++ port of csv_parse() for features that need to act inside
+// the tokenizer. It operates on the same struct csv_parser as libcsv, so
+// a parser can switch between both implementations at any row boundary.
+
+namespace csv {
+  namespace detail {
+
+    // libcsv parser states (libcsv.c)
+    enum : int {
+      kPsRowNotBegun = 0,
+      kPsFieldNotBegun = 1,
+      kPsFieldBegun = 2,
+      kPsFieldMightHaveEnded = 3
+    };
+
+    using FieldCallback = void (*)(void *, std::size_t, void *);
+    using RowCallback = void (*)(int, void *);
+
+    /**
+     * @brief Grows the entry buffer exactly like libcsv's csv_increase_buffer().
+     *
+     * @return 0 on success, -1 with p.status set on failure
+     */
+    int grow_entry_buffer(struct csv_parser &p) noexcept;
+
+    /**
+     * @brief What the tokenizer does with each field and row.
+     *
+     * Fields that are neither delivered nor tested are scanned for structure
+     * only: their bytes are never copied into the entry buffer. Rows being
+     * skipped after a seek, or rejected by the filter, deliver nothing.
+     * A header row is collected into header_fields instead of delivered;
+     * parsing stops right after it so the owner can resolve column names
+     * before the first data row.
+     */
+    struct RowPlan {
+      // Configuration
+      std::vector<unsigned char> project;  ///< project[col] != 0 to deliver; empty delivers all
+      RowFilter filter;
+      std::uint64_t skip_rows = 0;         ///< Rows to drop before delivering (seek)
+      std::uint64_t rejected = 0;          ///< Rows dropped by the filter so far
+      bool capture_header = false;         ///< Next non-blank row is the header
+      bool header_ready = false;           ///< Header row complete, not yet taken
+      std::vector<std::string> header_fields;
+
+      // Per-row state
+      std::size_t col = 0;
+      bool dropped = false;   // skipped or rejected: nothing more to deliver
+      bool deciding = false;  // predicate columns still ahead: stage fields
+      std::vector<char> stage_chars;
+      std::vector<std::size_t> stage_begin{0};
+      std::vector<unsigned char> stage_null;
+      bool raw_escaped = false;  // raw_parse(): the open field holds a doubled quote
+
+      [[nodiscard]] bool active() const noexcept {
+        return !project.empty() || !filter.empty() || skip_rows > 0 || capture_header;
+      }
+      [[nodiscard]] bool delivers(std::size_t c) const noexcept {
+        return project.empty() || (c < project.size() && project[c]);
+      }
+      [[nodiscard]] bool keeps(std::size_t c) const noexcept {
+        return capture_header || (!dropped && (delivers(c) || (deciding && filter.tests(c))));
+      }
+
+      /// Resets the per-row state; call at row boundaries
+      void begin_row() noexcept {
+        col = 0;
+        dropped = skip_rows > 0;
+        deciding = !filter.empty();
+        stage_chars.clear();
+        stage_begin.resize(1);
+        stage_null.clear();
+        raw_escaped = false;
+      }
+    };
+
+    /**
+     * @brief csv_parse() applying @p plan.
+     *
+     * Same contract as csv_parse(): returns the number of bytes consumed and
+     * sets p.status on errors. Also returns early, with plan.header_ready
+     * set, right after a header row.
+     */
+    std::size_t plan_parse(struct csv_parser &p, RowPlan &plan, const void *s, std::size_t len,
+                           FieldCallback cb1, RowCallback cb2, void *data);
+
+    /**
+     * @brief plan_parse() locating field runs with 64-byte structural bit
+     *        masks (SSE2 where available) instead of per-run scans.
+     *
+     * Same results as plan_parse(). Requires the default space and
+     * terminator classes; see default_classes() in Classify.hpp.
+     */
+    std::size_t plan_parse_structural(struct csv_parser &p, RowPlan &plan, const void *s, std::size_t len,
+                                      FieldCallback cb1, RowCallback cb2, void *data);
+
+    /**
+     * @brief plan_parse() over a mutable buffer, unescaping fields in place.
+     *
+     * Fields are compacted over the input and cb1 receives pointers into
+     * it; Option::AppendNull terminates them over the delimiter. A field
+     * still open at the end of @p s is copied to the entry buffer, so the
+     * parser state is the same as after plan_parse().
+     */
+    std::size_t plan_parse_insitu(struct csv_parser &p, RowPlan &plan, void *s, std::size_t len,
+                                  FieldCallback cb1, RowCallback cb2, void *data);
+
+    /**
+     * @brief csv_fini() applying @p plan.
+     *
+     * @return 0 on success, -1 with p.status set on failure
+     */
+    int plan_finish(struct csv_parser &p, RowPlan &plan, FieldCallback cb1, RowCallback cb2, void *data);
+
+    /**
+     * @brief plan_parse() delivering fields as RawField spans of @p s.
+     *
+     * Field bytes are never copied, except for a field cut by the end of
+     * @p s: its raw bytes are collected in the entry buffer and delivered
+     * from there. Fields held back by the filter, and header fields, are
+     * unescaped as they are tested. Option::AppendNull does not apply.
+     */
+    std::size_t raw_parse(struct csv_parser &p, RowPlan &plan, const void *s, std::size_t len,
+                          RawFieldCallback cb1, RowCallback cb2, void *data);
+
+    /**
+     * @brief plan_finish() for a document parsed with raw_parse().
+     *
+     * @return 0 on success, -1 with p.status set on failure
+     */
+    int raw_finish(struct csv_parser &p, RowPlan &plan, RawFieldCallback cb1, RowCallback cb2, void *data);
+
+  } // namespace detail
+} // namespace csv
+
+#endif // CSV_ENGINE_HPP
@@ -0,0 +1,66 @@
+#include "FieldArena.hpp"
+
+#include "RawField.hpp"
+
+#include <cstring>
+
+namespace csv {
+
+  namespace {
+
+    // Storage of empty copies, which must not read as NULL
+    char empty_field[1];
+
+  } // namespace
+
+  FieldArena::FieldArena(std::size_t block_size)
+      : m_block_size(block_size ? block_size : 1) {}
+
+  char *FieldArena::allocate(std::size_t size) {
+    if (size == 0) return empty_field;
+    m_used += size;
+    if (size > m_left) {
+      // Large fields get a block of their own and leave the current one open
+      if (size > m_block_size / 2) {
+        m_large.emplace_back(new char[size]);
+        return m_large.back().get();
+      }
+      m_blocks.emplace_back(new char[m_block_size]);
+      m_next = m_blocks.back().get();
+      m_left = m_block_size;
+    }
+    char *out = m_next;
+    m_next += size;
+    m_left -= size;
+    return out;
+  }
+
+  FieldView FieldArena::copy(const char *data, std::size_t size) {
+    char *out = allocate(size);
+    if (size > 0) std::memcpy(out, data, size);
+    return FieldView(out, size);
+  }
+
+  void FieldArena::clear() noexcept {
+    m_large.clear();
+    if (m_blocks.size() > 1) m_blocks.resize(1);
+    m_next = m_blocks.empty() ? nullptr : m_blocks.front().get();
+    m_left = m_blocks.empty() ? 0 : m_block_size;
+    m_used = 0;
+  }
+
+  FieldView FieldView::retain(FieldArena &arena) const {
+    return m_transient && m_data ? arena.copy(m_data, m_size) : FieldView(m_data, m_size);
+  }
+
+  FieldView RawField::retain(FieldArena &arena) const {
+    if (!m_data) return FieldView();
+    if (!m_transient && !m_escaped) {
+      const std::string_view s = span();
+      return FieldView(s.data(), s.size());
+    }
+    char *out = arena.allocate(span().size());
+    return FieldView(out, unescape(out));
+  }
+
+} // namespace csv
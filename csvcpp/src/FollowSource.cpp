@@ -0,0 +1,162 @@
+#include "FollowSource.hpp"
+
+#include "CsvParserImpl.hpp"
+#include "MappedFile.hpp"
+#include "Structure.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#  define CSV_HAVE_INOTIFY 1
+#  include <poll.h>
+#  include <sys/inotify.h>
+#  include <unistd.h>
+#endif
+
+namespace csv {
+  namespace {
+
+    // Bytes read per step; bounds memory together with the longest row
+    constexpr std::size_t kReadChunk = std::size_t{1} << 16;
+
+    // Size checks per second when inotify is unavailable
+    constexpr int kPollIntervalMs = 50;
+
+  } // namespace
+
+  struct FollowSource::impl {
+    std::string path;
+    FILE *fp = nullptr;
+    std::uint64_t read = 0;               // file bytes read so far
+    std::vector<unsigned char> carry;     // bytes of the row in progress
+    std::uint8_t state = detail::kRowNotBegun;
+    int inotify = -1;
+
+    ~impl() {
+      if (fp) std::fclose(fp);
+#if defined(CSV_HAVE_INOTIFY)
+      if (inotify >= 0) ::close(inotify);
+#endif
+    }
+
+    void restart() noexcept {
+      read = 0;
+      carry.clear();
+      state = detail::kRowNotBegun;
+    }
+
+    // Hands the complete rows in carry to the parser and keeps the rest
+    size_t flush(CsvParser &parser, size_t end, void (*cb1)(void *, size_t, void *),
+                 void (*cb2)(int, void *), void *data) {
+      struct Consume {
+        std::vector<unsigned char> &carry;
+        size_t n;
+        ~Consume() { carry.erase(carry.begin(), carry.begin() + static_cast<std::ptrdiff_t>(n)); }
+      } consume{carry, end};  // also on parse errors: rows are never delivered twice
+      parser.parse(carry.data(), end, cb1, cb2, data);
+      return end;
+    }
+  };
+
+  FollowSource::FollowSource(const std::string &path, std::uint64_t offset)
+      : m_pimpl(std::make_unique<impl>()) {
+    m_pimpl->path = path;
+    m_pimpl->fp = std::fopen(path.c_str(), "rb");
+    if (!m_pimpl->fp) {
+      throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+    m_pimpl->read = offset;
+#if defined(CSV_HAVE_INOTIFY)
+    m_pimpl->inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_pimpl->inotify >= 0 &&
+        ::inotify_add_watch(m_pimpl->inotify, path.c_str(),
+                            IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF) < 0) {
+      ::close(m_pimpl->inotify);
+      m_pimpl->inotify = -1;  // fall back to size polling
+    }
+#endif
+  }
+
+  FollowSource::FollowSource(FollowSource&&) noexcept = default;
+  FollowSource& FollowSource::operator=(FollowSource&&) noexcept = default;
+  FollowSource::~FollowSource() = default;
+
+  size_t FollowSource::poll(CsvParser &parser, void (*cb1)(void *, size_t, void *),
+                            void (*cb2)(int, void *), void *data) {
+    impl &s = *m_pimpl;
+    detail::FileStat st;
+    if (detail::stat_file(s.path, st) && st.size < s.read) s.restart();
+
+    const detail::StructTable table(detail::ParserAccess::get(parser));
+    detail::seek_file(s.fp, s.read);
+    size_t parsed = 0;
+    for (;;) {
+      const size_t scanned = s.carry.size();
+      s.carry.resize(scanned + kReadChunk);
+      const size_t n = std::fread(s.carry.data() + scanned, 1, kReadChunk, s.fp);
+      s.carry.resize(scanned + n);
+      if (n == 0) break;
+      s.read += n;
+
+      size_t end = 0;
+      s.state = table.scan(s.state, s.carry.data() + scanned, n, [&](size_t off) { end = scanned + off; });
+      if (end > 0) parsed += s.flush(parser, end, cb1, cb2, data);
+      if (n < kReadChunk) break;
+    }
+    if (std::ferror(s.fp)) {
+      std::clearerr(s.fp);
+      throw std::runtime_error("Failed to read " + s.path + ": " + std::strerror(errno));
+    }
+    std::clearerr(s.fp);
+    return parsed;
+  }
+
+  bool FollowSource::wait(int timeout_ms) {
+    impl &s = *m_pimpl;
+#if defined(CSV_HAVE_INOTIFY)
+    if (s.inotify >= 0) {
+      struct pollfd pfd {s.inotify, POLLIN, 0};
+      if (::poll(&pfd, 1, timeout_ms) <= 0) return false;
+      char events[4096];
+      while (::read(s.inotify, events, sizeof(events)) > 0) {
+      }
+      return true;
+    }
+#endif
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+      detail::FileStat st;
+      if (detail::stat_file(s.path, st) && st.size != s.read) return true;
+      if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs));
+    }
+  }
+
+  void FollowSource::finish(CsvParser &parser, void (*cb1)(void *, size_t, void *),
+                            void (*cb2)(int, void *), void *data) {
+    poll(parser, cb1, cb2, data);
+    impl &s = *m_pimpl;
+    if (!s.carry.empty()) s.flush(parser, s.carry.size(), cb1, cb2, data);
+    s.state = detail::kRowNotBegun;
+    parser.finish(cb1, cb2, data);
+  }
+
+  std::uint64_t FollowSource::offset() const noexcept {
+    return m_pimpl->read - m_pimpl->carry.size();
+  }
+
+  size_t FollowSource::pending() const noexcept {
+    return m_pimpl->carry.size();
+  }
+
+  bool FollowSource::uses_inotify() const noexcept {
+    return m_pimpl->inotify >= 0;
+  }
+
+} // namespace csv
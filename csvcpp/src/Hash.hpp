@@ -0,0 +1,106 @@
+#ifndef CSV_HASH_HPP
+#define CSV_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Internal XXH64 implementation used for chunk and block checksums.
+// Follows the reference algorithm, so values match other xxhash64 ports.
+
+namespace csv {
+  namespace detail {
+
+    constexpr std::uint64_t kXxPrime1 = 0x9E3779B185EBCA87ULL;
+    constexpr std::uint64_t kXxPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr std::uint64_t kXxPrime3 = 0x165667B19E3779F9ULL;
+    constexpr std::uint64_t kXxPrime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr std::uint64_t kXxPrime5 = 0x27D4EB2F165667C5ULL;
+
+    inline std::uint64_t rotl64(std::uint64_t x, int r) noexcept {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    inline std::uint64_t read64(const unsigned char *p) noexcept {
+      std::uint64_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    inline std::uint32_t read32(const unsigned char *p) noexcept {
+      std::uint32_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    inline std::uint64_t xxh64_round(std::uint64_t acc, std::uint64_t input) noexcept {
+      acc += input * kXxPrime2;
+      acc = rotl64(acc, 31);
+      return acc * kXxPrime1;
+    }
+
+    inline std::uint64_t xxh64_merge(std::uint64_t acc, std::uint64_t val) noexcept {
+      acc ^= xxh64_round(0, val);
+      return acc * kXxPrime1 + kXxPrime4;
+    }
+
+    /**
+     * @brief XXH64 of @p len bytes at @p data (little-endian hosts).
+     */
+    inline std::uint64_t xxh64(const void *data, std::size_t len, std::uint64_t seed = 0) noexcept {
+      const unsigned char *p = static_cast<const unsigned char *>(data);
+      const unsigned char *const end = p + len;
+      std::uint64_t h;
+
+      if (len >= 32) {
+        std::uint64_t v1 = seed + kXxPrime1 + kXxPrime2;
+        std::uint64_t v2 = seed + kXxPrime2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - kXxPrime1;
+        const unsigned char *const limit = end - 32;
+        do {
+          v1 = xxh64_round(v1, read64(p));
+          v2 = xxh64_round(v2, read64(p + 8));
+          v3 = xxh64_round(v3, read64(p + 16));
+          v4 = xxh64_round(v4, read64(p + 24));
+          p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+      } else {
+        h = seed + kXxPrime5;
+      }
+
+      h += static_cast<std::uint64_t>(len);
+
+      while (p + 8 <= end) {
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * kXxPrime1 + kXxPrime4;
+        p += 8;
+      }
+      if (p + 4 <= end) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * kXxPrime1;
+        h = rotl64(h, 23) * kXxPrime2 + kXxPrime3;
+        p += 4;
+      }
+      while (p < end) {
+        h ^= (*p) * kXxPrime5;
+        h = rotl64(h, 11) * kXxPrime1;
+        ++p;
+      }
+
+      h ^= h >> 33;
+      h *= kXxPrime2;
+      h ^= h >> 29;
+      h *= kXxPrime3;
+      h ^= h >> 32;
+      return h;
+    }
+
+  } // namespace detail
+} // namespace csv
+
+#endif // CSV_HASH_HPP
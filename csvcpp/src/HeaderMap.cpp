@@ -0,0 +1,62 @@
+#include "HeaderMap.hpp"
+
+#include "CsvParser.hpp"
+#include "Hash.hpp"
+
+#include <limits>
+
+namespace csv {
+
+  HeaderMap::HeaderMap(const std::vector<std::string> &names) {
+    size_t total = 0;
+    for (const std::string &n : names) total += n.size();
+    if (total > std::numeric_limits<std::uint32_t>::max() ||
+        names.size() >= std::numeric_limits<std::uint32_t>::max()) {
+      throw CsvError("CSV Header Error: header row too large", CsvError::ErrorType::Etoobig);
+    }
+
+    m_chars.reserve(total);
+    m_begin.reserve(names.size() + 1);
+    m_begin.push_back(0);
+    for (const std::string &n : names) {
+      m_chars += n;
+      m_begin.push_back(static_cast<std::uint32_t>(m_chars.size()));
+    }
+
+    // Power of two with at least twice as many slots as names
+    size_t slots = 8;
+    while (slots < 2 * names.size()) slots *= 2;
+    m_slots.assign(slots, 0);
+    const size_t mask = slots - 1;
+    for (size_t col = 0; col < names.size(); ++col) {
+      size_t s = static_cast<size_t>(detail::xxh64(names[col].data(), names[col].size())) & mask;
+      for (;; s = (s + 1) & mask) {
+        if (m_slots[s] == 0) {
+          m_slots[s] = static_cast<std::uint32_t>(col + 1);
+          break;
+        }
+        if (name(m_slots[s] - 1) == names[col]) break;  // duplicate: keep the first column
+      }
+    }
+  }
+
+  size_t HeaderMap::find(std::string_view n) const noexcept {
+    if (m_slots.empty()) return npos;
+    const size_t mask = m_slots.size() - 1;
+    for (size_t s = static_cast<size_t>(detail::xxh64(n.data(), n.size())) & mask;; s = (s + 1) & mask) {
+      const std::uint32_t v = m_slots[s];
+      if (v == 0) return npos;
+      if (name(v - 1) == n) return v - 1;
+    }
+  }
+
+  size_t HeaderMap::index(std::string_view n) const {
+    const size_t col = find(n);
+    if (col == npos) {
+      throw CsvError("CSV Header Error: no column named '" + std::string(n) + "'",
+                     CsvError::ErrorType::Einvalid);
+    }
+    return col;
+  }
+
+} // namespace csv
@@ -0,0 +1,419 @@
+#include "KeyIndex.hpp"
+
+#include "CsvParserImpl.hpp"
+#include "Hash.hpp"
+#include "HeaderMap.hpp"
+#include "MappedFile.hpp"
+#include "Structure.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+// Key index file layout (host byte order):
+//
+//   KeyHeader
+//   entries : KeyEntry[count], sorted by (hash, row)
+//
+// resume_offset is where the last terminated row ends (the start of an
+// unterminated final row); update() rescans from there once prefix_hash,
+// the XXH64 of every byte before it, still matches the source.
+// write_index() fills the entries behind a zeroed KeyHeader in a .tmp file
+// and renames it over the index only after the real header is in place;
+// read_header() accepts a file only if its size is exactly the header
+// plus count entries.
+
+namespace csv {
+  namespace {
+
+    constexpr char kMagic[8] = {'C', 'S', 'V', 'K', 'E', 'Y', 'I', 'X'};
+    constexpr std::uint32_t kVersion = 1;
+    constexpr std::uint32_t kByteOrder = 0x01020304;
+    constexpr std::uint8_t kHasHeader = 0x01;
+
+    struct KeyHeader {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byte_order;
+      std::uint64_t source_size;
+      std::int64_t source_mtime_ns;
+      std::uint64_t rows;
+      std::uint64_t column;
+      std::uint64_t count;
+      std::uint64_t entries_offset;
+      std::uint64_t resume_offset;
+      std::uint64_t resume_row;
+      std::uint64_t prefix_hash;
+      std::uint64_t file_size;
+      std::uint8_t delim;
+      std::uint8_t quote;
+      std::uint8_t options;
+      std::uint8_t flags;
+      std::uint8_t reserved[4];
+    };
+
+    struct KeyEntry {
+      std::uint64_t hash;
+      std::uint64_t row;
+      std::uint64_t begin;
+      std::uint64_t end;
+    };
+
+    bool operator<(const KeyEntry &a, const KeyEntry &b) noexcept {
+      return a.hash != b.hash ? a.hash < b.hash : a.row < b.row;
+    }
+
+    struct FileDeleter {
+      void operator()(FILE* f) const { if (f) std::fclose(f); }
+    };
+
+    bool read_header(const unsigned char *p, std::size_t size, KeyHeader &h) noexcept {
+      if (size < sizeof(KeyHeader)) return false;
+      std::memcpy(&h, p, sizeof(h));
+      return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+             h.byte_order == kByteOrder && h.file_size == size && h.entries_offset == sizeof(KeyHeader) &&
+             h.count <= (size - sizeof(KeyHeader)) / sizeof(KeyEntry) &&
+             h.file_size == sizeof(KeyHeader) + h.count * sizeof(KeyEntry);
+    }
+
+    void check_config(const KeyHeader &h, const struct csv_parser &p) {
+      if (h.delim != p.delim_char || h.quote != p.quote_char ||
+          ((h.options ^ p.options) & (CSV_REPALL_NL | CSV_EMPTY_IS_NULL)) != 0) {
+        throw CsvError("CSV Index Error: key index was built with a different parser configuration",
+                       CsvError::ErrorType::Einvalid);
+      }
+    }
+
+    // Hashing the whole indexed prefix costs a read of it, still far less than parsing it again
+    std::uint64_t prefix_hash(const unsigned char *data, std::uint64_t end) noexcept {
+      return detail::xxh64(data, static_cast<std::size_t>(end));
+    }
+
+    /*
+     * csv_parse() callbacks picking field `column` out of each row. While
+     * indexing, rows with a key are appended to `out`; while verifying,
+     * rows whose key equals `target` are counted.
+     */
+    struct KeyCollector {
+      std::size_t column = 0;
+      bool empty_is_null = false;
+      std::size_t col = 0;
+      std::uint64_t row = 0;
+      bool has_key = false;
+      std::uint64_t hash = 0;
+
+      // Indexing
+      std::vector<KeyEntry> *out = nullptr;
+      const std::vector<std::uint64_t> *starts = nullptr;  // row k starts at (*starts)[k]
+      std::uint64_t end = 0;
+      std::uint64_t first_row = 0;
+      std::uint64_t skip_rows = 0;  // header
+
+      // Verifying
+      std::string_view target;
+      bool equal = false;
+      std::uint64_t matches = 0;
+    };
+
+    void collect_field(void *s, std::size_t len, void *data) {
+      auto *c = static_cast<KeyCollector *>(data);
+      if (c->col++ != c->column || (!s && c->empty_is_null)) return;
+      const char *p = s ? static_cast<const char *>(s) : "";
+      c->has_key = true;
+      if (c->out) c->hash = detail::xxh64(p, len);
+      else c->equal = std::string_view(p, len) == c->target;
+    }
+
+    void collect_row(int, void *data) {
+      auto *c = static_cast<KeyCollector *>(data);
+      if (c->has_key) {
+        if (c->out) {
+          const std::size_t k = static_cast<std::size_t>(c->row);
+          if (c->row >= c->skip_rows && k < c->starts->size()) {
+            c->out->push_back({c->hash, c->first_row + k, (*c->starts)[k],
+                               k + 1 < c->starts->size() ? (*c->starts)[k + 1] : c->end});
+          }
+        } else if (c->equal) {
+          ++c->matches;
+        }
+      }
+      ++c->row;
+      c->col = 0;
+      c->has_key = false;
+      c->equal = false;
+    }
+
+    struct HeaderFields {
+      std::vector<std::string> names;
+    };
+
+    void header_field(void *s, std::size_t len, void *data) {
+      static_cast<HeaderFields *>(data)->names.emplace_back(s ? static_cast<const char *>(s) : "", len);
+    }
+
+    // Entries of the rows starting at @p from, a row boundary numbered @p first_row
+    struct KeyScan {
+      std::vector<KeyEntry> entries;
+      std::uint64_t rows = 0;
+      std::uint64_t resume_offset = 0;
+      std::uint64_t resume_row = 0;
+    };
+
+    KeyScan scan_keys(const struct csv_parser &cp, const unsigned char *data, std::size_t size,
+                      std::uint64_t from, std::uint64_t first_row, std::size_t column, bool has_header) {
+      const detail::StructTable table(cp);
+      std::vector<std::uint64_t> starts{from};
+      const std::uint8_t state = table.scan(detail::kRowNotBegun, data + from, static_cast<std::size_t>(size - from),
+                                            [&](std::size_t off) { starts.push_back(from + off); });
+      const bool pending = detail::StructTable::pending_row(state);
+      if (!pending) starts.pop_back();  // no row begins after the last terminator
+
+      KeyScan scan;
+      KeyCollector c;
+      c.column = column;
+      c.empty_is_null = (cp.options & CSV_EMPTY_IS_NULL) != 0;
+      c.out = &scan.entries;
+      c.starts = &starts;
+      c.end = size;
+      c.first_row = first_row;
+      c.skip_rows = has_header && first_row == 0 ? 1 : 0;
+      detail::ScratchParser(cp).run(data + from, static_cast<std::size_t>(size - from), from,
+                                    collect_field, collect_row, &c);
+      std::sort(scan.entries.begin(), scan.entries.end());
+
+      scan.rows = first_row + starts.size();
+      scan.resume_offset = pending ? starts.back() : size;
+      scan.resume_row = pending ? scan.rows - 1 : scan.rows;
+      return scan;
+    }
+
+    void write_index(const std::string &index_path, KeyHeader &header, const std::vector<KeyEntry> &entries) {
+      std::memcpy(header.magic, kMagic, sizeof(kMagic));
+      header.version = kVersion;
+      header.byte_order = kByteOrder;
+      header.count = entries.size();
+      header.entries_offset = sizeof(KeyHeader);
+      header.file_size = sizeof(KeyHeader) + entries.size() * sizeof(KeyEntry);
+
+      const std::string tmp_path = index_path + ".tmp";
+      std::unique_ptr<FILE, FileDeleter> outfile(std::fopen(tmp_path.c_str(), "wb"));
+      if (!outfile) {
+        throw std::runtime_error("Failed to open " + tmp_path + ": " + std::strerror(errno));
+      }
+      KeyHeader blank{};
+      if (std::fwrite(&blank, sizeof(blank), 1, outfile.get()) != 1 ||
+          (!entries.empty() &&
+           std::fwrite(entries.data(), sizeof(KeyEntry), entries.size(), outfile.get()) != entries.size()) ||
+          std::fseek(outfile.get(), 0, SEEK_SET) != 0 ||
+          std::fwrite(&header, sizeof(header), 1, outfile.get()) != 1 ||
+          std::fclose(outfile.release()) != 0) {
+        throw std::runtime_error("Failed to write " + tmp_path);
+      }
+      if (std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Failed to rename " + tmp_path + ": " + std::strerror(errno));
+      }
+    }
+
+    void build_index(const std::string &csv_path, const std::string &index_path,
+                     const struct csv_parser &cp, std::size_t column, bool has_header) {
+      detail::FileStat st;
+      if (!detail::stat_file(csv_path, st)) {
+        throw std::runtime_error("Failed to stat " + csv_path + ": " + std::strerror(errno));
+      }
+      detail::MappedFile source(csv_path);
+      const KeyScan scan = scan_keys(cp, source.data(), source.size(), 0, 0, column, has_header);
+
+      KeyHeader header{};
+      header.source_size = st.size;
+      header.source_mtime_ns = st.mtime_ns;
+      header.rows = scan.rows;
+      header.column = column;
+      header.resume_offset = scan.resume_offset;
+      header.resume_row = scan.resume_row;
+      header.prefix_hash = prefix_hash(source.data(), scan.resume_offset);
+      header.delim = cp.delim_char;
+      header.quote = cp.quote_char;
+      header.options = cp.options;
+      header.flags = has_header ? kHasHeader : 0;
+      write_index(index_path, header, scan.entries);
+    }
+
+  } // namespace
+
+  struct KeyIndex::impl {
+    std::unique_ptr<detail::MappedFile> m_file;
+    std::unique_ptr<detail::MappedFile> m_source;
+    KeyHeader m_header{};
+    const KeyEntry *m_entries = nullptr;
+  };
+
+  KeyIndex::KeyIndex() : m_pimpl(std::make_unique<impl>()) {}
+  KeyIndex::KeyIndex(KeyIndex&&) noexcept = default;
+  KeyIndex& KeyIndex::operator=(KeyIndex&&) noexcept = default;
+  KeyIndex::~KeyIndex() = default;
+
+  void KeyIndex::build(const std::string &csv_path, const std::string &index_path,
+                       const CsvParser &parser, size_t column) {
+    build_index(csv_path, index_path, detail::ParserAccess::get(parser), column, false);
+  }
+
+  void KeyIndex::build(const std::string &csv_path, const std::string &index_path,
+                       const CsvParser &parser, std::string_view column) {
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    size_t col;
+    {
+      detail::MappedFile source(csv_path);
+      const size_t end = detail::StructTable(cp).row_end(source.data(), source.size());
+      HeaderFields header;
+      detail::ScratchParser(cp).run(source.data(), static_cast<size_t>(end), 0, header_field, nullptr, &header);
+      if (!header.names.empty() && header.names[0].compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        header.names[0].erase(0, 3);  // UTF-8 byte order mark
+      }
+      col = HeaderMap(std::move(header.names)).index(column);
+    }
+    build_index(csv_path, index_path, cp, col, true);
+  }
+
+  bool KeyIndex::update(const std::string &csv_path, const std::string &index_path, const CsvParser &parser) {
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    KeyHeader h;
+    std::vector<KeyEntry> kept;
+    {
+      detail::MappedFile old(index_path);
+      if (!read_header(old.data(), old.size(), h)) {
+        throw CsvError("CSV Index Error: " + index_path + ": not a key index or truncated",
+                       CsvError::ErrorType::Einvalid);
+      }
+      check_config(h, cp);
+      const auto *entries = reinterpret_cast<const KeyEntry *>(old.data() + h.entries_offset);
+      std::copy_if(entries, entries + h.count, std::back_inserter(kept),
+                   [&](const KeyEntry &e) { return e.row < h.resume_row; });
+    }
+
+    detail::FileStat st;
+    if (!detail::stat_file(csv_path, st)) {
+      throw std::runtime_error("Failed to stat " + csv_path + ": " + std::strerror(errno));
+    }
+    if (st.size == h.source_size && st.mtime_ns == h.source_mtime_ns) return true;
+
+    const bool has_header = (h.flags & kHasHeader) != 0;
+    detail::MappedFile source(csv_path);
+    if (source.size() < h.resume_offset || prefix_hash(source.data(), h.resume_offset) != h.prefix_hash) {
+      build_index(csv_path, index_path, cp, static_cast<size_t>(h.column), has_header);
+      return false;
+    }
+
+    const KeyScan scan = scan_keys(cp, source.data(), source.size(), h.resume_offset, h.resume_row,
+                                   static_cast<size_t>(h.column), has_header);
+    std::vector<KeyEntry> entries;
+    entries.reserve(kept.size() + scan.entries.size());
+    std::merge(kept.begin(), kept.end(), scan.entries.begin(), scan.entries.end(), std::back_inserter(entries));
+
+    h.source_size = st.size;
+    h.source_mtime_ns = st.mtime_ns;
+    h.rows = scan.rows;
+    h.resume_offset = scan.resume_offset;
+    h.resume_row = scan.resume_row;
+    h.prefix_hash = prefix_hash(source.data(), scan.resume_offset);
+    write_index(index_path, h, entries);
+    return true;
+  }
+
+  KeyIndex KeyIndex::open(const std::string &index_path, const std::string &source_path) {
+    auto invalid = [&](const char *why) {
+      return CsvError("CSV Index Error: " + index_path + ": " + why, CsvError::ErrorType::Einvalid);
+    };
+
+    detail::FileStat st;
+    if (!detail::stat_file(source_path, st)) {
+      throw std::runtime_error("Failed to stat " + source_path + ": " + std::strerror(errno));
+    }
+
+    KeyIndex index;
+    impl &d = *index.m_pimpl;
+    d.m_file = std::make_unique<detail::MappedFile>(index_path);
+    if (!read_header(d.m_file->data(), d.m_file->size(), d.m_header)) {
+      throw invalid("not a key index or truncated");
+    }
+    if (d.m_header.source_size != st.size || d.m_header.source_mtime_ns != st.mtime_ns) {
+      throw invalid("stale: source file changed since the index was built");
+    }
+    d.m_source = std::make_unique<detail::MappedFile>(source_path);
+    if (d.m_source->size() != d.m_header.source_size) {
+      throw invalid("stale: source file changed since the index was built");
+    }
+    d.m_entries = reinterpret_cast<const KeyEntry *>(d.m_file->data() + d.m_header.entries_offset);
+    for (size_t i = 0; i < d.m_header.count; ++i) {
+      if (d.m_entries[i].begin > d.m_entries[i].end || d.m_entries[i].end > d.m_header.source_size) {
+        throw invalid("row range out of bounds");
+      }
+    }
+    return index;
+  }
+
+  std::uint64_t KeyIndex::rows() const noexcept {
+    return m_pimpl->m_header.rows;
+  }
+
+  size_t KeyIndex::size() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.count);
+  }
+
+  size_t KeyIndex::column() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.column);
+  }
+
+  bool KeyIndex::has_header() const noexcept {
+    return (m_pimpl->m_header.flags & kHasHeader) != 0;
+  }
+
+  std::vector<KeyIndex::Match> KeyIndex::find(const CsvParser &parser, std::string_view key) const {
+    const impl &d = *m_pimpl;
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    check_config(d.m_header, cp);
+
+    const std::uint64_t hash = detail::xxh64(key.data(), key.size());
+    const KeyEntry *first = d.m_entries;
+    const KeyEntry *last = d.m_entries + d.m_header.count;
+    first = std::lower_bound(first, last, hash, [](const KeyEntry &e, std::uint64_t h) { return e.hash < h; });
+    last = std::upper_bound(first, last, hash, [](std::uint64_t h, const KeyEntry &e) { return h < e.hash; });
+
+    std::vector<Match> out;
+    if (first == last) return out;
+    detail::ScratchParser scratch(cp);
+    KeyCollector c;
+    c.column = static_cast<size_t>(d.m_header.column);
+    c.empty_is_null = (cp.options & CSV_EMPTY_IS_NULL) != 0;
+    c.target = key;
+    for (const KeyEntry *e = first; e != last; ++e) {
+      c.matches = 0;
+      scratch.run(d.m_source->data() + e->begin, static_cast<size_t>(e->end - e->begin), e->begin,
+                  collect_field, collect_row, &c);
+      if (c.matches > 0) out.push_back({e->row, e->begin, e->end});
+    }
+    return out;
+  }
+
+  size_t KeyIndex::lookup(CsvParser &parser, std::string_view key,
+                          void (*cb1)(void *, size_t, void *),
+                          void (*cb2)(int, void *),
+                          void *data) const {
+    const std::vector<Match> matches = find(parser, key);
+    const unsigned char *bytes = m_pimpl->m_source->data();
+    detail::begin_random_rows(parser, bytes, m_pimpl->m_source->size());
+
+    size_t found = 0;
+    for (const Match &m : matches) {
+      if (m.row == 0 && parser.get_header_row()) continue;
+      parser.parse(bytes + m.begin, static_cast<size_t>(m.end - m.begin), cb1, cb2, data);
+      ++found;
+    }
+    parser.finish(cb1, cb2, data);
+    return found;
+  }
+
+} // namespace csv
@@ -0,0 +1,95 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define CSV_HAVE_MMAP 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+namespace csv {
+  namespace detail {
+
+    bool stat_file(const std::string &path, FileStat &out) noexcept {
+      struct stat st {};
+      if (::stat(path.c_str(), &st) != 0) return false;
+      out.size = static_cast<std::uint64_t>(st.st_size);
+#if defined(__APPLE__)
+      out.mtime_ns = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000LL +
+                     st.st_mtimespec.tv_nsec;
+#elif defined(__unix__)
+      out.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+                     st.st_mtim.tv_nsec;
+#else
+      out.mtime_ns = static_cast<std::int64_t>(st.st_mtime) * 1000000000LL;
+#endif
+      return true;
+    }
+
+    void seek_file(FILE *fp, std::uint64_t offset) {
+#if defined(__unix__) || defined(__APPLE__)
+      const int rc = fseeko(fp, static_cast<off_t>(offset), SEEK_SET);
+#elif defined(_WIN32)
+      const int rc = _fseeki64(fp, static_cast<__int64>(offset), SEEK_SET);
+#else
+      const int rc = std::fseek(fp, static_cast<long>(offset), SEEK_SET);
+#endif
+      if (rc != 0) {
+        throw std::runtime_error(std::string("Failed to seek: ") + std::strerror(errno));
+      }
+    }
+
+    MappedFile::MappedFile(const std::string &path) {
+#if defined(CSV_HAVE_MMAP)
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+      }
+      struct stat st {};
+      if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat " + path + ": " + std::strerror(errno));
+      }
+      m_size = static_cast<std::size_t>(st.st_size);
+      if (m_size > 0) {
+        void *p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+          ::close(fd);
+          throw std::runtime_error("Failed to map " + path + ": " + std::strerror(errno));
+        }
+        m_data = static_cast<const unsigned char *>(p);
+        m_mapped = true;
+      }
+      ::close(fd);
+#else
+      struct FileDeleter {
+        void operator()(FILE* f) const { if (f) std::fclose(f); }
+      };
+      std::unique_ptr<FILE, FileDeleter> fp(std::fopen(path.c_str(), "rb"));
+      if (!fp) {
+        throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+      }
+      unsigned char buf[65536];
+      while (std::size_t n = std::fread(buf, 1, sizeof(buf), fp.get())) {
+        m_fallback.insert(m_fallback.end(), buf, buf + n);
+      }
+      m_data = m_fallback.data();
+      m_size = m_fallback.size();
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+#if defined(CSV_HAVE_MMAP)
+      if (m_mapped) ::munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+    }
+
+  } // namespace detail
+} // namespace csv
@@ -0,0 +1,69 @@
+#ifndef CSV_MAPPED_FILE_HPP
+#define CSV_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Internal file helpers shared by the sidecar and cache formats.
+
+namespace csv {
+  namespace detail {
+
+    /**
+     * @brief Size and modification time used to detect stale derived files.
+     */
+    struct FileStat {
+      std::uint64_t size = 0;
+      std::int64_t mtime_ns = 0;
+
+      bool operator==(const FileStat &o) const noexcept {
+        return size == o.size && mtime_ns == o.mtime_ns;
+      }
+      bool operator!=(const FileStat &o) const noexcept { return !(*this == o); }
+    };
+
+    /**
+     * @brief Reads size and mtime of @p path.
+     *
+     * @return false if the file cannot be stat'ed
+     */
+    bool stat_file(const std::string &path, FileStat &out) noexcept;
+
+    /**
+     * @brief Positions @p fp at byte @p offset, beyond 2 GiB where supported.
+     *
+     * @throws std::runtime_error if @p fp cannot be repositioned
+     */
+    void seek_file(FILE *fp, std::uint64_t offset);
+
+    /**
+     * @brief Read-only view of a whole file.
+     *
+     * Uses mmap where available and falls back to reading the file into
+     * memory elsewhere. Throws std::runtime_error if the file cannot be opened.
+     */
+    class MappedFile {
+    public:
+      explicit MappedFile(const std::string &path);
+      ~MappedFile();
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      [[nodiscard]] const unsigned char *data() const noexcept { return m_data; }
+      [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+    private:
+      const unsigned char *m_data = nullptr;
+      std::size_t m_size = 0;
+      bool m_mapped = false;
+      std::vector<unsigned char> m_fallback;
+    };
+
+  } // namespace detail
+} // namespace csv
+
+#endif // CSV_MAPPED_FILE_HPP
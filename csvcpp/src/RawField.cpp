@@ -0,0 +1,82 @@
+#include "RawField.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace csv {
+  namespace {
+
+    unsigned lowest_bit(unsigned w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctz(w));
+#else
+      unsigned n = 0;
+      for (; !(w & 1); w >>= 1) ++n;
+      return n;
+#endif
+    }
+
+  } // namespace
+
+  /*
+   * csv_parse() keeps a quote inside a quoted field and drops the one
+   * right after it, so collapsing each pair left to right reproduces its
+   * value. Quote-free runs are copied 16 bytes at a time.
+   */
+  std::size_t RawField::unescape(char *out) const noexcept {
+    const std::string_view s = span();
+    if (!m_escaped) {
+      if (!s.empty()) std::memcpy(out, s.data(), s.size());
+      return s.size();
+    }
+
+    const char *p = s.data();
+    const char *const end = p + s.size();
+    char *o = out;
+#if defined(__SSE2__)
+    const __m128i q = _mm_set1_epi8(m_quote);
+    while (end - p >= 16) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)));
+      if (mask == 0) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o), v);
+        p += 16;
+        o += 16;
+        continue;
+      }
+      // Copies through the first quote and skips its twin
+      const unsigned n = lowest_bit(mask) + 1;
+      std::memcpy(o, p, n);
+      p += n;
+      o += n;
+      if (p < end && *p == m_quote) ++p;
+    }
+#endif
+    while (p < end) {
+      const char c = *p++;
+      *o++ = c;
+      if (c == m_quote && p < end && *p == m_quote) ++p;
+    }
+    return static_cast<std::size_t>(o - out);
+  }
+
+  std::string RawField::str() const {
+    std::string out(span().size(), '\0');
+    out.resize(unescape(&out[0]));
+    return out;
+  }
+
+  FieldView RawField::value(std::string &scratch) const {
+    if (!m_data) return FieldView();
+    if (!m_escaped) {
+      const std::string_view s = span();
+      return FieldView(s.data(), s.size());
+    }
+    scratch = str();
+    return FieldView(scratch.data(), scratch.size());
+  }
+
+} // namespace csv
@@ -0,0 +1,126 @@
+#include "RowBatch.hpp"
+
+#include <functional>
+
+namespace csv {
+
+  RowBatch::RowBatch(size_t capacity)
+      : m_capacity(capacity ? capacity : 1) {
+    m_row_begin.reserve(m_capacity + 1);
+  }
+
+  // Batches are delivered from the row callback, so no field is pending here
+  void RowBatch::clear() noexcept {
+    m_chars.clear();
+    m_field_begin.assign(1, 0);
+    m_row_begin.assign(1, 0);
+    m_validity.clear();
+    m_insitu = false;
+    m_views.clear();
+    m_owned.clear();
+  }
+
+  // Fields already copied stay in m_chars, which is not appended to again until clear()
+  void RowBatch::begin_insitu() {
+    if (m_insitu) return;
+    for (size_t i = 0; i + 1 < m_field_begin.size(); ++i) {
+      m_views.emplace_back(m_chars.data() + m_field_begin[i], m_field_begin[i + 1] - m_field_begin[i], true);
+    }
+    m_insitu = true;
+  }
+
+  FieldView RowBatch::own(const char *s, size_t len) {
+    m_owned.emplace_back(s, len);
+    return FieldView(m_owned.back().data(), len, true);
+  }
+
+  // Copies the pending fields that still point into the caller's buffer
+  void RowBatch::own_input() {
+    const std::less<const char *> before;
+    for (FieldView &v : m_views) {
+      if (v.data() && !before(v.data(), m_input) && before(v.data(), m_input + m_input_size)) {
+        v = own(v.data(), v.size());
+      }
+    }
+    m_input = nullptr;
+    m_input_size = 0;
+  }
+
+  std::vector<FieldView> RowBatch::retain(size_t row, FieldArena &arena) const {
+    std::vector<FieldView> out;
+    out.reserve(fields(row));
+    for (size_t c = 0; c < fields(row); ++c) out.push_back(field(row, c).retain(arena));
+    return out;
+  }
+
+  void RowBatch::on_field(void *s, size_t len, void *data) {
+    auto *b = static_cast<RowBatch *>(data);
+    if (b->m_insitu) {
+      b->m_views.push_back(s ? b->own(static_cast<const char *>(s), len) : FieldView());
+    } else {
+      if (s) {
+        const char *p = static_cast<const char *>(s);
+        b->m_chars.insert(b->m_chars.end(), p, p + len);
+      }
+      b->m_field_begin.push_back(b->m_chars.size());
+    }
+    b->m_validity.push_back(s != nullptr);
+  }
+
+  // A field cut by the end of the previous chunk comes from the parser's entry buffer
+  void RowBatch::on_field_insitu(void *s, size_t len, void *data) {
+    auto *b = static_cast<RowBatch *>(data);
+    const char *p = static_cast<const char *>(s);
+    const std::less<const char *> before;
+    if (!p) b->m_views.emplace_back();
+    else if (!before(p, b->m_input) && before(p, b->m_input + b->m_input_size)) b->m_views.emplace_back(p, len);
+    else b->m_views.push_back(b->own(p, len));
+    b->m_validity.push_back(s != nullptr);
+  }
+
+  void RowBatch::on_row(int, void *data) {
+    auto *b = static_cast<RowBatch *>(data);
+    const size_t nfields = b->field_count();
+    if (nfields == b->m_row_begin.back()) return;  // blank line reported under RepAllNl
+    b->m_row_begin.push_back(nfields);
+    if (b->rows() == b->m_capacity) {
+      if (b->m_cb) b->m_cb(*b, b->m_cb_data);
+      b->clear();
+      if (b->m_input) b->m_insitu = true;
+    }
+  }
+
+  size_t RowBatch::parse(CsvParser &parser, const void *s, size_t len,
+                         BatchCallback cb, void *data) {
+    m_cb = cb;
+    m_cb_data = data;
+    return parser.parse(s, len, on_field, on_row, this);
+  }
+
+  size_t RowBatch::parse_insitu(CsvParser &parser, void *s, size_t len,
+                                BatchCallback cb, void *data) {
+    m_cb = cb;
+    m_cb_data = data;
+    begin_insitu();
+    m_input = static_cast<const char *>(s);
+    m_input_size = len;
+    size_t n;
+    try {
+      n = parser.parse_insitu(s, len, on_field_insitu, on_row, this);
+    } catch (...) {
+      own_input();
+      throw;
+    }
+    own_input();
+    return n;
+  }
+
+  void RowBatch::finish(CsvParser &parser, BatchCallback cb, void *data) {
+    m_cb = cb;
+    m_cb_data = data;
+    parser.finish(on_field, on_row, this);
+    if (rows() > 0 && cb) cb(*this, data);
+    clear();
+  }
+
+} // namespace csv
@@ -0,0 +1,195 @@
+#include "RowCounter.hpp"
+
+#include "Classify.hpp"
+#include "CsvParserImpl.hpp"
+#include "Structure.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace csv {
+  namespace {
+
+    using detail::classify;
+    using detail::default_classes;
+    using detail::lowest_bit;
+    using detail::Masks;
+    using detail::popcount;
+
+    constexpr std::size_t kBlock = detail::kClassifyBlock;
+
+    unsigned highest_bit(std::uint64_t w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+      return 63u - static_cast<unsigned>(__builtin_clzll(w));
+#else
+      unsigned n = 0;
+      while (w >>= 1) ++n;
+      return n;
+#endif
+    }
+
+    // Bit i is the parity of the set bits at positions 0..i
+    std::uint64_t prefix_xor(std::uint64_t x) noexcept {
+      x ^= x << 1;
+      x ^= x << 2;
+      x ^= x << 4;
+      x ^= x << 8;
+      x ^= x << 16;
+      x ^= x << 32;
+      return x;
+    }
+
+  } // namespace
+
+  struct RowCounter::impl {
+    detail::StructTable table;
+    const unsigned char delim;
+    const unsigned char quote;
+    const bool simd;
+    const bool strict;
+    const bool strict_fini;
+    const bool repall;
+    const bool track;
+
+    std::uint8_t state = detail::kRowNotBegun;
+    std::size_t row_fields = 0;  // fields of the current row so far
+    RowCounts counts;
+
+    impl(const struct csv_parser &p, bool track_widths) noexcept
+        : table(p), delim(p.delim_char), quote(p.quote_char), simd(default_classes(p)),
+          strict((p.options & CSV_STRICT) != 0), strict_fini((p.options & CSV_STRICT_FINI) != 0),
+          repall((p.options & CSV_REPALL_NL) != 0), track(track_widths) {}
+
+    void record_row(std::size_t width) noexcept {
+      if (++counts.rows == 1 || width < counts.min_fields) counts.min_fields = width;
+      if (width > counts.max_fields) counts.max_fields = width;
+    }
+
+    void scalar(const unsigned char *p, std::size_t n, std::size_t base) {
+      for (std::size_t i = 0; i < n; ++i) {
+        const std::uint8_t t = table.next(state, p[i]);
+        if (strict && (t & detail::StructTable::kStrictError)) {
+          throw CsvError(std::string("CSV Parsing Error: ") + csv_strerror(CSV_EPARSE),
+                         CsvError::ErrorType::Eparse, base + i);
+        }
+        state = t & detail::StructTable::kStateMask;
+        if (t & detail::StructTable::kFieldEnd) {
+          ++counts.fields;
+          ++row_fields;
+        }
+        if (t & detail::StructTable::kRowEnd) {
+          record_row(row_fields);
+          row_fields = 0;
+        }
+      }
+    }
+
+    /*
+     * Counts one 64-byte block from its masks. Returns false, without
+     * counting anything, if a quote does not open at a field start or
+     * close right before a delimiter, terminator or escaped quote; libcsv
+     * then departs from plain quote parity and the block is counted
+     * byte by byte instead.
+     */
+    bool block(const unsigned char *p) noexcept {
+      using detail::kFieldNotBegun;
+      using detail::kFieldQuoted;
+      using detail::kMightHaveEnded;
+      using detail::kRowNotBegun;
+      constexpr std::uint64_t kTop = std::uint64_t{1} << 63;
+
+      const std::uint8_t s = state;
+      if (s == detail::kMightHaveEndedSpaces) return false;
+
+      const Masks m = classify(p, quote, delim);
+      const std::uint64_t inside = prefix_xor(m.quote) ^ (s == kFieldQuoted ? ~std::uint64_t{0} : 0);
+      const std::uint64_t opening = m.quote & inside;
+      const std::uint64_t closing = m.quote & ~inside;
+      const std::uint64_t delims = m.delim & ~inside;
+      const std::uint64_t terms = m.term & ~inside;
+      const std::uint64_t spaces = m.space & ~m.delim & ~inside;
+
+      const std::uint64_t field_start = ((delims | terms) << 1) | (s == kRowNotBegun || s == kFieldNotBegun);
+      const std::uint64_t after_closing = (closing << 1) | (s == kMightHaveEnded);
+      if (opening & ~(field_start | after_closing)) return false;
+      const std::uint64_t closes = m.delim | m.term | m.quote;
+      if (closing & ~(closes >> 1) & ~kTop) return false;
+      if (s == kMightHaveEnded && !(closes & 1)) return false;
+
+      // Terminators reached from the previous one (or a row boundary) through spaces only
+      const std::uint64_t from_row_start = (terms << 1) | (s == kRowNotBegun);
+      const std::uint64_t blank = ((spaces + from_row_start) & ~spaces) & terms;
+      const std::uint64_t field_rows = terms & ~blank;
+      const std::uint64_t rows = repall ? terms : field_rows;
+
+      counts.fields += popcount(delims) + popcount(field_rows);
+      if (track) {
+        std::uint64_t done = 0;
+        for (std::uint64_t r = rows; r; r &= r - 1) {
+          const unsigned b = lowest_bit(r);
+          const std::uint64_t upto = b == 63 ? ~std::uint64_t{0} : (std::uint64_t{2} << b) - 1;
+          record_row(row_fields + popcount(delims & upto & ~done) + ((field_rows >> b) & 1));
+          row_fields = 0;
+          done = upto;
+        }
+        row_fields += popcount(delims & ~done);
+      } else {
+        counts.rows += popcount(rows);
+      }
+
+      // The last non-space byte decides the state
+      const std::uint64_t significant = ~spaces;
+      if (inside & kTop) {
+        state = kFieldQuoted;
+      } else if (significant) {
+        const std::uint64_t bit = std::uint64_t{1} << highest_bit(significant);
+        if (terms & bit) state = kRowNotBegun;
+        else if (delims & bit) state = kFieldNotBegun;
+        else if (closing & bit) state = kMightHaveEnded;  // only possible at the last byte
+        else state = detail::kFieldUnquoted;
+      }
+      return true;
+    }
+  };
+
+  RowCounter::RowCounter(const CsvParser &parser, bool track_widths)
+      : m_pimpl(std::make_unique<impl>(detail::ParserAccess::get(parser), track_widths)) {}
+
+  RowCounter::RowCounter(RowCounter&&) noexcept = default;
+  RowCounter& RowCounter::operator=(RowCounter&&) noexcept = default;
+  RowCounter::~RowCounter() = default;
+
+  void RowCounter::count(const void *s, std::size_t len) {
+    if (s == nullptr) return;
+    impl &m = *m_pimpl;
+    const auto *p = static_cast<const unsigned char *>(s);
+    std::size_t i = 0;
+    if (m.simd) {
+      for (; i + kBlock <= len; i += kBlock) {
+        if (!m.block(p + i)) m.scalar(p + i, kBlock, i);
+      }
+    }
+    m.scalar(p + i, len - i, i);
+  }
+
+  RowCounts RowCounter::finish() {
+    impl &m = *m_pimpl;
+    if (m.state == detail::kFieldQuoted && m.strict && m.strict_fini) {
+      throw std::runtime_error(csv_strerror(CSV_EPARSE));
+    }
+    if (detail::StructTable::pending_row(m.state)) {
+      ++m.counts.fields;
+      m.record_row(m.row_fields + 1);
+    }
+    const RowCounts out = m.counts;
+    m.counts = RowCounts();
+    m.state = detail::kRowNotBegun;
+    m.row_fields = 0;
+    return out;
+  }
+
+  const RowCounts &RowCounter::counts() const noexcept {
+    return m_pimpl->counts;
+  }
+
+} // namespace csv
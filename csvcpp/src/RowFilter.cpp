@@ -0,0 +1,165 @@
+#include "RowFilter.hpp"
+
+#include "CsvBinding.hpp"
+#include "HeaderMap.hpp"
+#include "RowIndex.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace csv {
+
+  RowFilter::Predicate RowFilter::make(Predicate::Kind kind, std::string_view value) {
+    return Predicate{kind, std::string(value), {}};
+  }
+
+  RowFilter::Predicate RowFilter::make_in(std::vector<std::string> values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return Predicate{Predicate::Kind::In, {}, std::move(values)};
+  }
+
+  RowFilter::Predicate RowFilter::make_int(std::int64_t lo, std::int64_t hi) {
+    Predicate p{Predicate::Kind::IntRange, {}, {}};
+    p.int_lo = lo;
+    p.int_hi = hi;
+    return p;
+  }
+
+  RowFilter::Predicate RowFilter::make_float(double lo, double hi) {
+    Predicate p{Predicate::Kind::FloatRange, {}, {}};
+    p.float_lo = lo;
+    p.float_hi = hi;
+    return p;
+  }
+
+  RowFilter &RowFilter::add(size_t col, Predicate p) {
+    if (col >= m_columns.size()) m_columns.resize(col + 1);
+    m_columns[col].push_back(std::move(p));
+    m_last = m_last == kNone ? col : std::max(m_last, col);
+    return *this;
+  }
+
+  RowFilter &RowFilter::add(std::string_view column, Predicate p) {
+    m_named.emplace_back(std::string(column), std::move(p));
+    return *this;
+  }
+
+  RowFilter &RowFilter::equals(size_t col, std::string_view value) {
+    return add(col, make(Predicate::Kind::Equals, value));
+  }
+
+  RowFilter &RowFilter::prefix(size_t col, std::string_view value) {
+    return add(col, make(Predicate::Kind::Prefix, value));
+  }
+
+  RowFilter &RowFilter::in(size_t col, std::vector<std::string> values) {
+    return add(col, make_in(std::move(values)));
+  }
+
+  RowFilter &RowFilter::int_range(size_t col, std::int64_t lo, std::int64_t hi) {
+    return add(col, make_int(lo, hi));
+  }
+
+  RowFilter &RowFilter::float_range(size_t col, double lo, double hi) {
+    return add(col, make_float(lo, hi));
+  }
+
+  RowFilter &RowFilter::equals(std::string_view column, std::string_view value) {
+    return add(column, make(Predicate::Kind::Equals, value));
+  }
+
+  RowFilter &RowFilter::prefix(std::string_view column, std::string_view value) {
+    return add(column, make(Predicate::Kind::Prefix, value));
+  }
+
+  RowFilter &RowFilter::in(std::string_view column, std::vector<std::string> values) {
+    return add(column, make_in(std::move(values)));
+  }
+
+  RowFilter &RowFilter::int_range(std::string_view column, std::int64_t lo, std::int64_t hi) {
+    return add(column, make_int(lo, hi));
+  }
+
+  RowFilter &RowFilter::float_range(std::string_view column, double lo, double hi) {
+    return add(column, make_float(lo, hi));
+  }
+
+  RowFilter RowFilter::resolve(const HeaderMap &header) const {
+    RowFilter out;
+    out.m_columns = m_columns;
+    out.m_last = m_last;
+    for (const auto &[column, p] : m_named) out.add(header.index(column), p);
+    return out;
+  }
+
+  bool RowFilter::matches(size_t col, FieldView field) const noexcept {
+    if (!tests(col)) return true;
+    if (field.is_null()) return false;
+    const std::string_view v = field.view();
+    for (const Predicate &p : m_columns[col]) {
+      switch (p.kind) {
+        case Predicate::Kind::Equals:
+          if (v != p.value) return false;
+          break;
+        case Predicate::Kind::Prefix:
+          if (v.substr(0, p.value.size()) != p.value) return false;
+          break;
+        case Predicate::Kind::In: {
+          auto it = std::lower_bound(p.values.begin(), p.values.end(), v,
+            [](const std::string &a, std::string_view b) { return std::string_view(a) < b; });
+          if (it == p.values.end() || std::string_view(*it) != v) return false;
+          break;
+        }
+        case Predicate::Kind::IntRange: {
+          std::int64_t x = 0;
+          if (v.empty() || !FieldConverter<std::int64_t>::convert(v.data(), v.size(), x) ||
+              x < p.int_lo || x > p.int_hi) {
+            return false;
+          }
+          break;
+        }
+        case Predicate::Kind::FloatRange: {
+          double x = 0.0;
+          if (v.empty() || !FieldConverter<double>::convert(v.data(), v.size(), x) ||
+              !(x >= p.float_lo && x <= p.float_hi)) {
+            return false;
+          }
+          break;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool RowFilter::may_match(const RowIndex &index, size_t zone) const {
+    for (size_t col = 0; col < m_columns.size(); ++col) {
+      if (m_columns[col].empty()) continue;
+      const RowIndex::ColumnZone z = index.zone(zone, col);
+      for (const Predicate &p : m_columns[col]) {
+        bool possible = true;
+        switch (p.kind) {
+          case Predicate::Kind::Equals:
+            possible = z.may_equal(p.value);
+            break;
+          case Predicate::Kind::Prefix:
+            possible = z.may_start_with(p.value);
+            break;
+          case Predicate::Kind::In:
+            possible = std::any_of(p.values.begin(), p.values.end(),
+              [&](const std::string &v) { return z.may_equal(v); });
+            break;
+          case Predicate::Kind::IntRange:
+            possible = z.may_int_range(p.int_lo, p.int_hi);
+            break;
+          case Predicate::Kind::FloatRange:
+            possible = z.may_float_range(p.float_lo, p.float_hi);
+            break;
+        }
+        if (!possible) return false;
+      }
+    }
+    return true;
+  }
+
+} // namespace csv
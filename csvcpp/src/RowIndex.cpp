@@ -0,0 +1,810 @@
+#include "RowIndex.hpp"
+
+#include "CsvBinding.hpp"
+#include "CsvParserImpl.hpp"
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+#include "Structure.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Index file layout (host byte order):
+//
+//   IndexHeader
+//   offsets : u64[entries], offsets[k] = start of row k * stride
+//   records : u64[rows + 1], start of each row's field record in field data
+//   fields  : per row { u32 count | wide << 31, u16/u32 deltas[count - 1] },
+//             padded to 4 bytes; delta k is the distance from the start of
+//             field k to the start of field k + 1
+//   zones   : per block, per column { ZoneRecord, u64 bloom[bloom_words] },
+//             starting at the next multiple of 8
+//
+// The records and fields sections are only present with field offsets,
+// the zones section only with zone maps.
+// The header is written last, so a truncated file never passes validation.
+
+namespace csv {
+  namespace {
+
+    constexpr char kMagic[8] = {'C', 'S', 'V', 'I', 'N', 'D', 'E', 'X'};
+    constexpr std::uint32_t kVersion = 3;
+    constexpr std::uint32_t kByteOrder = 0x01020304;
+
+    // Smaller chunks are not worth a thread
+    constexpr std::size_t kMinChunk = std::size_t{1} << 16;
+
+    struct IndexHeader {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byte_order;
+      std::uint64_t source_size;
+      std::int64_t source_mtime_ns;
+      std::uint64_t rows;
+      std::uint64_t stride;
+      std::uint64_t entries;
+      std::uint64_t offsets_offset;
+      std::uint64_t records_offset;
+      std::uint64_t fields_offset;
+      std::uint64_t fields_size;
+      std::uint64_t file_size;
+      std::uint8_t delim;
+      std::uint8_t quote;
+      std::uint8_t options;
+      std::uint8_t reserved[5];
+      std::uint64_t zone_rows;
+      std::uint64_t zone_columns;
+      std::uint64_t bloom_words;
+      std::uint64_t zones_offset;
+    };
+
+    struct FileDeleter {
+      void operator()(FILE* f) const { if (f) std::fclose(f); }
+    };
+
+    bool read_header(const unsigned char *p, std::size_t size, IndexHeader &h) noexcept {
+      if (size < sizeof(IndexHeader)) return false;
+      std::memcpy(&h, p, sizeof(h));
+      return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+             h.byte_order == kByteOrder;
+    }
+
+    // Outcome of scanning a chunk from one hypothetical start state
+    struct ChunkSummary {
+      std::uint8_t end_state = detail::kRowNotBegun;
+      std::uint64_t rows = 0;
+    };
+
+    using Speculation = std::array<ChunkSummary, detail::kStructStates>;
+
+    /*
+     * Scans a chunk from every start state at once. Hypotheses that reach
+     * the same state share a lane from then on, so after the first few
+     * row terminators a chunk is usually down to one lane and runs at the
+     * speed of a plain scan.
+     */
+    Speculation speculate(const detail::StructTable &table, const unsigned char *p, std::size_t n) {
+      constexpr int H = detail::kStructStates;
+      std::uint8_t lane_state[H];
+      std::uint64_t lane_rows[H] = {};
+      int lane_of[H];
+      std::uint64_t base[H] = {};  // rows counted before joining the current lane
+      int lanes = H;
+      for (int h = 0; h < H; ++h) {
+        lane_state[h] = static_cast<std::uint8_t>(h);
+        lane_of[h] = h;
+      }
+
+      std::size_t i = 0;
+      for (; i < n && lanes > 1; ++i) {
+        for (int l = 0; l < lanes; ++l) {
+          const std::uint8_t t = table.next(lane_state[l], p[i]);
+          lane_state[l] = t & detail::StructTable::kStateMask;
+          lane_rows[l] += (t & detail::StructTable::kRowEnd) ? 1 : 0;
+        }
+        for (int a = 0; a < lanes; ++a) {
+          for (int b = a + 1; b < lanes; ++b) {
+            if (lane_state[a] != lane_state[b]) continue;
+            // Fold lane b into lane a, then move the last lane into slot b
+            for (int h = 0; h < H; ++h) {
+              if (lane_of[h] == b) {
+                base[h] += lane_rows[b] - lane_rows[a];
+                lane_of[h] = a;
+              }
+            }
+            --lanes;
+            if (b != lanes) {
+              lane_state[b] = lane_state[lanes];
+              lane_rows[b] = lane_rows[lanes];
+              for (int h = 0; h < H; ++h) {
+                if (lane_of[h] == lanes) lane_of[h] = b;
+              }
+            }
+            --b;
+          }
+        }
+      }
+      if (lanes == 1) {
+        lane_state[0] = table.scan(lane_state[0], p + i, n - i, [&](std::size_t) { ++lane_rows[0]; });
+      }
+
+      Speculation out;
+      for (int h = 0; h < H; ++h) {
+        out[h].end_state = lane_state[lane_of[h]];
+        out[h].rows = base[h] + lane_rows[lane_of[h]];
+      }
+      return out;
+    }
+
+    constexpr std::uint32_t kWideRecord = 0x80000000u;
+
+    // Appends the field record of a row starting at @p row_start whose
+    // delimiters are followed by the absolute offsets in @p delims
+    void encode_record(std::vector<unsigned char> &out, std::uint64_t row_start,
+                       const std::vector<std::uint64_t> &delims, bool has_fields) {
+      if (delims.size() >= kWideRecord - 1) {
+        throw std::runtime_error("RowIndex: too many fields in one row");
+      }
+      bool wide = false;
+      std::uint64_t prev = row_start;
+      for (std::uint64_t d : delims) {
+        if (d - prev > 0xFFFF) wide = true;
+        prev = d;
+      }
+      const std::uint32_t head = (has_fields ? static_cast<std::uint32_t>(delims.size() + 1) : 0) |
+                                 (wide ? kWideRecord : 0);
+      const std::size_t width = wide ? 4 : 2;
+      const std::size_t at = out.size();
+      out.resize(at + 4 + (delims.size() * width + 3) / 4 * 4);
+      std::memcpy(&out[at], &head, 4);
+      unsigned char *p = &out[at + 4];
+      prev = row_start;
+      for (std::uint64_t d : delims) {
+        if (wide) {
+          const auto v = static_cast<std::uint32_t>(d - prev);
+          std::memcpy(p, &v, 4);
+        } else {
+          const auto v = static_cast<std::uint16_t>(d - prev);
+          std::memcpy(p, &v, 2);
+        }
+        p += width;
+        prev = d;
+      }
+    }
+
+    // Field records of one chunk. Rows that started in an earlier chunk are
+    // completed from `head` during assembly; `tail` carries the unfinished
+    // row into the next chunk.
+    struct FieldChunk {
+      std::vector<std::uint64_t> head;
+      bool head_ends_row = false;
+      bool head_has_fields = false;
+      std::vector<unsigned char> records;
+      std::vector<std::uint64_t> record_begin;
+      std::vector<std::uint64_t> tail;
+    };
+
+    template <typename F>
+    void run_parallel(std::size_t n, F &&job) {
+      std::vector<std::thread> workers;
+      std::vector<std::exception_ptr> errors(n);
+      workers.reserve(n);
+      for (std::size_t i = 0; i < n; ++i) {
+        workers.emplace_back([&, i] {
+          try {
+            job(i);
+          } catch (...) {
+            errors[i] = std::current_exception();
+          }
+        });
+      }
+      for (std::thread &t : workers) t.join();
+      for (std::exception_ptr &e : errors) {
+        if (e) std::rethrow_exception(e);
+      }
+    }
+
+
+    // Bytes of the smallest and largest field kept as text bounds
+    constexpr std::size_t kZoneText = 16;
+    constexpr std::uint8_t kZoneHasText = 0x01;
+    constexpr std::uint8_t kZoneMaxExact = 0x02;
+    constexpr int kBloomProbes = 3;
+
+    struct ZoneRecord {
+      std::uint64_t nulls;
+      std::uint64_t ints;
+      std::int64_t int_min;
+      std::int64_t int_max;
+      std::uint64_t floats;
+      double float_min;
+      double float_max;
+      std::uint8_t text_min_len;
+      std::uint8_t text_max_len;
+      std::uint8_t flags;
+      std::uint8_t reserved[5];
+      char text_min[kZoneText];
+      char text_max[kZoneText];
+    };
+
+    // Calls @p f with each bloom bit of @p value (double hashing of one XXH64)
+    template <typename F>
+    void bloom_probes(std::string_view value, std::uint64_t bits, F &&f) {
+      const std::uint64_t h = detail::xxh64(value.data(), value.size());
+      const std::uint64_t h1 = h & 0xFFFFFFFFu;
+      const std::uint64_t h2 = (h >> 32) | 1;
+      for (int k = 0; k < kBloomProbes; ++k) f((h1 + static_cast<std::uint64_t>(k) * h2) % bits);
+    }
+
+    void update_text(ZoneRecord &r, const char *s, std::size_t len) noexcept {
+      const std::size_t n = std::min(len, kZoneText);
+      const std::string_view v(s, n);
+      const bool exact = len <= kZoneText;
+      if (!(r.flags & kZoneHasText)) {
+        std::memcpy(r.text_min, s, n);
+        std::memcpy(r.text_max, s, n);
+        r.text_min_len = r.text_max_len = static_cast<std::uint8_t>(n);
+        r.flags = kZoneHasText | (exact ? kZoneMaxExact : 0);
+        return;
+      }
+      if (v < std::string_view(r.text_min, r.text_min_len)) {
+        std::memcpy(r.text_min, s, n);
+        r.text_min_len = static_cast<std::uint8_t>(n);
+      }
+      const int c = v.compare(std::string_view(r.text_max, r.text_max_len));
+      if (c > 0) {
+        std::memcpy(r.text_max, s, n);
+        r.text_max_len = static_cast<std::uint8_t>(n);
+        r.flags = kZoneHasText | (exact ? kZoneMaxExact : 0);
+      } else if (c == 0 && !exact) {
+        r.flags &= static_cast<std::uint8_t>(~kZoneMaxExact);
+      }
+    }
+
+    // Statistics of one block, fed by csv_parse() callbacks
+    struct ZoneBuilder {
+      struct Column {
+        std::uint64_t fields = 0;  // fields present, NULL or not
+        ZoneRecord record{};
+        std::vector<std::uint64_t> bloom;
+      };
+
+      std::size_t bloom_words = 0;
+      std::uint64_t rows = 0;
+      std::size_t col = 0;
+      std::vector<Column> columns;
+
+      void field(const char *s, std::size_t len) {
+        if (col >= columns.size()) {
+          columns.resize(col + 1);
+          columns.back().bloom.assign(bloom_words, 0);
+        }
+        Column &c = columns[col++];
+        ZoneRecord &r = c.record;
+        ++c.fields;
+        if (!s || len == 0) ++r.nulls;
+        if (!s) return;
+        update_text(r, s, len);
+        if (bloom_words) {
+          bloom_probes(std::string_view(s, len), bloom_words * 64, [&](std::uint64_t bit) {
+            c.bloom[bit / 64] |= std::uint64_t{1} << (bit % 64);
+          });
+        }
+        if (len == 0) return;
+        std::int64_t i = 0;
+        if (FieldConverter<std::int64_t>::convert(s, len, i)) {
+          if (r.ints++ == 0) r.int_min = r.int_max = i;
+          r.int_min = std::min(r.int_min, i);
+          r.int_max = std::max(r.int_max, i);
+        }
+        double d = 0.0;
+        if (FieldConverter<double>::convert(s, len, d) && !std::isnan(d)) {
+          if (r.floats++ == 0) r.float_min = r.float_max = d;
+          r.float_min = std::min(r.float_min, d);
+          r.float_max = std::max(r.float_max, d);
+        }
+      }
+
+      void row() noexcept {
+        ++rows;
+        col = 0;
+      }
+
+      // Appends the records of @p width columns; missing fields count as NULL
+      void write(std::vector<unsigned char> &out, std::size_t width) const {
+        const std::vector<std::uint64_t> no_bloom(bloom_words, 0);
+        for (std::size_t k = 0; k < width; ++k) {
+          ZoneRecord r{};
+          const std::vector<std::uint64_t> *bloom = &no_bloom;
+          if (k < columns.size()) {
+            r = columns[k].record;
+            r.nulls += rows - columns[k].fields;
+            bloom = &columns[k].bloom;
+          } else {
+            r.nulls = rows;
+          }
+          const std::size_t at = out.size();
+          out.resize(at + sizeof(r) + bloom_words * sizeof(std::uint64_t));
+          std::memcpy(&out[at], &r, sizeof(r));
+          if (bloom_words) std::memcpy(&out[at + sizeof(r)], bloom->data(), bloom_words * sizeof(std::uint64_t));
+        }
+      }
+    };
+
+    void zone_field(void *s, std::size_t len, void *data) {
+      static_cast<ZoneBuilder *>(data)->field(static_cast<const char *>(s), len);
+    }
+
+    void zone_row(int, void *data) {
+      static_cast<ZoneBuilder *>(data)->row();
+    }
+
+  } // namespace
+
+  struct RowIndex::impl {
+    std::unique_ptr<detail::MappedFile> m_file;
+    IndexHeader m_header{};
+    const std::uint64_t *m_offsets = nullptr;
+    const std::uint64_t *m_records = nullptr;
+    const unsigned char *m_fields = nullptr;
+    const unsigned char *m_zones = nullptr;
+
+    std::size_t zone_count() const noexcept {
+      return static_cast<std::size_t>((m_header.rows + m_header.zone_rows - 1) / m_header.zone_rows);
+    }
+
+    void check_zone(std::size_t zone) const {
+      if (!m_zones) throw std::logic_error("RowIndex: built without zone maps");
+      if (zone >= zone_count()) throw std::out_of_range("RowIndex: zone out of range");
+    }
+
+    // Start of the field record of @p row, bounds checked
+    const unsigned char *record(std::uint64_t row, std::uint32_t &head) const {
+      if (!m_records) throw std::logic_error("RowIndex: built without field offsets");
+      if (row >= m_header.rows) throw std::out_of_range("RowIndex: row out of range");
+      const std::uint64_t at = m_records[row];
+      if (at > m_header.fields_size || m_header.fields_size - at < 4) {
+        throw CsvError("CSV Index Error: corrupt field record", CsvError::ErrorType::Einvalid);
+      }
+      std::memcpy(&head, m_fields + at, 4);
+      const std::uint64_t n = head & ~kWideRecord;
+      const std::uint64_t need = 4 + (n ? n - 1 : 0) * ((head & kWideRecord) ? 4 : 2);
+      if (m_header.fields_size - at < need) {
+        throw CsvError("CSV Index Error: corrupt field record", CsvError::ErrorType::Einvalid);
+      }
+      return m_fields + at + 4;
+    }
+  };
+
+  RowIndex::RowIndex() : m_pimpl(std::make_unique<impl>()) {}
+  RowIndex::RowIndex(RowIndex&&) noexcept = default;
+  RowIndex& RowIndex::operator=(RowIndex&&) noexcept = default;
+  RowIndex::~RowIndex() = default;
+
+  void RowIndex::build(const std::string &csv_path, const std::string &index_path,
+                       const CsvParser &parser, const IndexOptions &options) {
+    detail::FileStat st;
+    if (!detail::stat_file(csv_path, st)) {
+      throw std::runtime_error("Failed to stat " + csv_path + ": " + std::strerror(errno));
+    }
+    detail::MappedFile source(csv_path);
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    const detail::StructTable table(cp);
+    const bool with_fields = options.field_offsets;
+    const std::uint64_t stride = with_fields || options.stride == 0 ? 1 : options.stride;
+
+    const unsigned char *data = source.data();
+    const std::size_t size = source.size();
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t nchunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, size / kMinChunk));
+    std::vector<std::size_t> bounds(nchunks + 1);
+    for (std::size_t i = 0; i <= nchunks; ++i) bounds[i] = size / nchunks * i;
+    bounds[nchunks] = size;
+
+    // Pass 1: speculative summaries, chained into true start states
+    std::vector<std::uint8_t> start(nchunks, detail::kRowNotBegun);
+    std::vector<std::uint64_t> first_row(nchunks, 0);
+    if (nchunks > 1) {
+      std::vector<Speculation> spec(nchunks);
+      run_parallel(nchunks - 1, [&](std::size_t i) {
+        spec[i] = speculate(table, data + bounds[i], bounds[i + 1] - bounds[i]);
+      });
+      for (std::size_t i = 1; i < nchunks; ++i) {
+        const ChunkSummary &prev = spec[i - 1][start[i - 1]];
+        start[i] = prev.end_state;
+        first_row[i] = first_row[i - 1] + prev.rows;
+      }
+    }
+
+    // Pass 2: record offsets of every stride-th row start (and field starts)
+    std::vector<std::vector<std::uint64_t>> found(nchunks);
+    std::vector<FieldChunk> field_chunks(with_fields ? nchunks : 0);
+    std::vector<std::uint8_t> end_state(nchunks);
+    std::vector<std::uint64_t> end_row(nchunks);
+    run_parallel(nchunks, [&](std::size_t i) {
+      std::uint64_t row = first_row[i];
+      const std::uint64_t begin = bounds[i];
+      const std::size_t len = bounds[i + 1] - begin;
+      std::vector<std::uint64_t> &out = found[i];
+      if (!with_fields) {
+        end_state[i] = table.scan(start[i], data + begin, len, [&](std::size_t off) {
+          if (++row % stride == 0) out.push_back(begin + off);
+        });
+      } else {
+        FieldChunk &fc = field_chunks[i];
+        std::vector<std::uint64_t> delims;
+        std::uint64_t row_start = 0;
+        end_state[i] = table.scan_fields(start[i], data + begin, len,
+          [&](std::size_t off) { delims.push_back(begin + off); },
+          [&](std::size_t off, bool has_fields) {
+            if (row == first_row[i]) {
+              fc.head.swap(delims);
+              fc.head_ends_row = true;
+              fc.head_has_fields = has_fields;
+            } else {
+              fc.record_begin.push_back(fc.records.size());
+              encode_record(fc.records, row_start, delims, has_fields);
+            }
+            delims.clear();
+            row_start = begin + off;
+            ++row;
+            out.push_back(row_start);
+          });
+        (fc.head_ends_row ? fc.tail : fc.head).swap(delims);
+      }
+      end_row[i] = row;
+    });
+
+    std::uint64_t rows = end_row.back();
+    const bool last_pending = detail::StructTable::pending_row(end_state.back());
+    if (last_pending) ++rows;  // completed by csv_fini()
+
+    std::vector<std::uint64_t> offsets;
+    offsets.reserve(static_cast<std::size_t>((rows + stride - 1) / stride));
+    if (rows > 0) offsets.push_back(0);
+    for (const auto &chunk : found) {
+      for (std::uint64_t off : chunk) {
+        if (offsets.size() * stride >= rows) break;  // start of a row that never begins
+        offsets.push_back(off);
+      }
+    }
+
+    // Stitch rows spanning chunk boundaries into one record stream
+    std::vector<std::uint64_t> records;
+    std::vector<unsigned char> fields;
+    if (with_fields) {
+      records.reserve(static_cast<std::size_t>(rows + 1));
+      std::vector<std::uint64_t> pending;
+      for (FieldChunk &fc : field_chunks) {
+        pending.insert(pending.end(), fc.head.begin(), fc.head.end());
+        if (!fc.head_ends_row) continue;
+        records.push_back(fields.size());
+        encode_record(fields, offsets[records.size() - 1], pending, fc.head_has_fields);
+        for (std::uint64_t b : fc.record_begin) records.push_back(fields.size() + b);
+        fields.insert(fields.end(), fc.records.begin(), fc.records.end());
+        pending.swap(fc.tail);
+        std::vector<unsigned char>().swap(fc.records);  // release chunk memory early
+      }
+      if (last_pending) {
+        records.push_back(fields.size());
+        encode_record(fields, offsets[records.size() - 1], pending, true);
+      }
+      records.push_back(fields.size());
+    }
+
+    // Zone maps: every block starts at an indexed row, so blocks are parsed independently
+    const std::uint64_t zone_rows = options.zone_rows ? (options.zone_rows + stride - 1) / stride * stride : 0;
+    const std::size_t bloom_words = (options.bloom_bits + 63) / 64;
+    const std::size_t nzones = zone_rows ? static_cast<std::size_t>((rows + zone_rows - 1) / zone_rows) : 0;
+    std::vector<ZoneBuilder> zone_builders(nzones);
+    if (nzones > 0) {
+      const std::size_t workers = std::min<std::size_t>(threads, nzones);
+      run_parallel(workers, [&](std::size_t w) {
+        detail::ScratchParser zp(cp);
+        for (std::size_t z = w; z < nzones; z += workers) {
+          const std::uint64_t begin = offsets[static_cast<std::size_t>(z * zone_rows / stride)];
+          const std::uint64_t end = z + 1 < nzones ? offsets[static_cast<std::size_t>((z + 1) * zone_rows / stride)] : size;
+          zone_builders[z].bloom_words = bloom_words;
+          zp.run(data + begin, static_cast<std::size_t>(end - begin), begin, zone_field, zone_row, &zone_builders[z]);
+        }
+      });
+    }
+    std::size_t zone_columns = 0;
+    for (const ZoneBuilder &zb : zone_builders) zone_columns = std::max(zone_columns, zb.columns.size());
+    std::vector<unsigned char> zones;
+    for (const ZoneBuilder &zb : zone_builders) zb.write(zones, zone_columns);
+    std::vector<ZoneBuilder>().swap(zone_builders);
+
+    IndexHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.source_size = st.size;
+    header.source_mtime_ns = st.mtime_ns;
+    header.rows = rows;
+    header.stride = stride;
+    header.entries = offsets.size();
+    header.offsets_offset = sizeof(IndexHeader);
+    header.records_offset = header.offsets_offset + offsets.size() * sizeof(std::uint64_t);
+    header.fields_offset = header.records_offset + records.size() * sizeof(std::uint64_t);
+    header.fields_size = fields.size();
+    header.delim = cp.delim_char;
+    header.quote = cp.quote_char;
+    header.options = cp.options;
+    header.zone_rows = zone_rows;
+    header.zone_columns = zone_columns;
+    header.bloom_words = bloom_words;
+    header.zones_offset = (header.fields_offset + fields.size() + 7) / 8 * 8;
+    header.file_size = header.zones_offset + zones.size();
+
+    const std::string tmp_path = index_path + ".tmp";
+    std::unique_ptr<FILE, FileDeleter> outfile(std::fopen(tmp_path.c_str(), "wb"));
+    if (!outfile) {
+      throw std::runtime_error("Failed to open " + tmp_path + ": " + std::strerror(errno));
+    }
+    auto write_all = [&](const void *p, std::size_t n) {
+      return n == 0 || std::fwrite(p, 1, n, outfile.get()) == n;
+    };
+    IndexHeader blank{};
+    const unsigned char padding[8] = {};
+    if (!write_all(&blank, sizeof(blank)) ||
+        !write_all(offsets.data(), offsets.size() * sizeof(std::uint64_t)) ||
+        !write_all(records.data(), records.size() * sizeof(std::uint64_t)) ||
+        !write_all(fields.data(), fields.size()) ||
+        !write_all(padding, header.zones_offset - header.fields_offset - fields.size()) ||
+        !write_all(zones.data(), zones.size()) ||
+        std::fseek(outfile.get(), 0, SEEK_SET) != 0 ||
+        std::fwrite(&header, sizeof(header), 1, outfile.get()) != 1 ||
+        std::fclose(outfile.release()) != 0) {
+      throw std::runtime_error("Failed to write " + tmp_path);
+    }
+    if (std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+      std::remove(tmp_path.c_str());
+      throw std::runtime_error("Failed to rename " + tmp_path + ": " + std::strerror(errno));
+    }
+  }
+
+  bool RowIndex::is_fresh(const std::string &index_path, const std::string &source_path) noexcept {
+    detail::FileStat st;
+    if (!detail::stat_file(source_path, st)) return false;
+    std::unique_ptr<FILE, FileDeleter> fp(std::fopen(index_path.c_str(), "rb"));
+    if (!fp) return false;
+    unsigned char buf[sizeof(IndexHeader)];
+    IndexHeader h;
+    if (std::fread(buf, 1, sizeof(buf), fp.get()) != sizeof(buf) ||
+        !read_header(buf, sizeof(buf), h)) {
+      return false;
+    }
+    return h.source_size == st.size && h.source_mtime_ns == st.mtime_ns;
+  }
+
+  RowIndex RowIndex::open(const std::string &index_path, const std::string &source_path) {
+    auto invalid = [&](const char *why) {
+      return CsvError("CSV Index Error: " + index_path + ": " + why, CsvError::ErrorType::Einvalid);
+    };
+
+    detail::FileStat st;
+    if (!detail::stat_file(source_path, st)) {
+      throw std::runtime_error("Failed to stat " + source_path + ": " + std::strerror(errno));
+    }
+
+    RowIndex index;
+    impl &d = *index.m_pimpl;
+    d.m_file = std::make_unique<detail::MappedFile>(index_path);
+    const unsigned char *base = d.m_file->data();
+    const std::uint64_t size = d.m_file->size();
+
+    if (!read_header(base, size, d.m_header) || d.m_header.file_size != size) {
+      throw invalid("not an index file or truncated");
+    }
+    const IndexHeader &h = d.m_header;
+    if (h.source_size != st.size || h.source_mtime_ns != st.mtime_ns) {
+      throw invalid("stale: source file changed since the index was built");
+    }
+    if (h.stride == 0 || h.entries != (h.rows + h.stride - 1) / h.stride ||
+        h.offsets_offset % 8 != 0 || h.offsets_offset > size ||
+        h.entries > (size - h.offsets_offset) / sizeof(std::uint64_t)) {
+      throw invalid("offsets out of bounds");
+    }
+    d.m_offsets = reinterpret_cast<const std::uint64_t *>(base + h.offsets_offset);
+    if (h.records_offset != h.offsets_offset + h.entries * sizeof(std::uint64_t) ||
+        h.fields_offset < h.records_offset || h.fields_offset > size || h.fields_size > size - h.fields_offset) {
+      throw invalid("field offsets out of bounds");
+    }
+    if (h.fields_offset > h.records_offset) {
+      // Field offsets are only recorded with stride 1, one record per row
+      if (h.stride != 1 || h.fields_offset - h.records_offset != (h.rows + 1) * sizeof(std::uint64_t)) {
+        throw invalid("bad field offset directory");
+      }
+      d.m_records = reinterpret_cast<const std::uint64_t *>(base + h.records_offset);
+      d.m_fields = base + h.fields_offset;
+      if (d.m_records[h.rows] != h.fields_size) throw invalid("bad field offset directory");
+    }
+    if (h.zones_offset % 8 != 0 || h.zones_offset < h.fields_offset + h.fields_size ||
+        h.zones_offset - (h.fields_offset + h.fields_size) >= 8 || h.zones_offset > size) {
+      throw invalid("zone maps out of bounds");
+    }
+    if (h.zone_rows != 0) {
+      const std::uint64_t zones = (h.rows + h.zone_rows - 1) / h.zone_rows;
+      const std::uint64_t record = sizeof(ZoneRecord) + h.bloom_words * sizeof(std::uint64_t);
+      if (h.zone_rows % h.stride != 0 || h.bloom_words > size || h.zone_columns > size ||
+          (h.zone_columns != 0 && zones > size / h.zone_columns) ||
+          (size - h.zones_offset) / record != zones * h.zone_columns ||
+          (size - h.zones_offset) % record != 0) {
+        throw invalid("bad zone map directory");
+      }
+      d.m_zones = base + h.zones_offset;
+    } else if (h.zones_offset != size) {
+      throw invalid("bad zone map directory");
+    }
+    return index;
+  }
+
+  std::uint64_t RowIndex::rows() const noexcept {
+    return m_pimpl->m_header.rows;
+  }
+
+  size_t RowIndex::stride() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.stride);
+  }
+
+  size_t RowIndex::entries() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.entries);
+  }
+
+  RowIndex::Position RowIndex::locate(std::uint64_t row) const {
+    if (row >= m_pimpl->m_header.rows) {
+      throw std::out_of_range("RowIndex: row out of range");
+    }
+    const std::uint64_t k = row / m_pimpl->m_header.stride;
+    return {k * m_pimpl->m_header.stride, m_pimpl->m_offsets[k]};
+  }
+
+  bool RowIndex::has_field_offsets() const noexcept {
+    return m_pimpl->m_records != nullptr;
+  }
+
+  size_t RowIndex::fields(std::uint64_t row) const {
+    std::uint32_t head;
+    m_pimpl->record(row, head);
+    return head & ~kWideRecord;
+  }
+
+  std::uint64_t RowIndex::field_offset(std::uint64_t row, size_t col) const {
+    std::uint32_t head;
+    const unsigned char *p = m_pimpl->record(row, head);
+    if (col >= (head & ~kWideRecord)) {
+      throw std::out_of_range("RowIndex: column out of range");
+    }
+    std::uint64_t off = m_pimpl->m_offsets[row];
+    if (head & kWideRecord) {
+      for (size_t k = 0; k < col; ++k) {
+        std::uint32_t v;
+        std::memcpy(&v, p + 4 * k, 4);
+        off += v;
+      }
+    } else {
+      for (size_t k = 0; k < col; ++k) {
+        std::uint16_t v;
+        std::memcpy(&v, p + 2 * k, 2);
+        off += v;
+      }
+    }
+    return off;
+  }
+
+  std::uint64_t RowIndex::row_end(std::uint64_t row) const {
+    const IndexHeader &h = m_pimpl->m_header;
+    if (h.stride != 1) throw std::logic_error("RowIndex: row ends need an index of every row");
+    if (row >= h.rows) throw std::out_of_range("RowIndex: row out of range");
+    return row + 1 < h.rows ? m_pimpl->m_offsets[row + 1] : h.source_size;
+  }
+
+  unsigned char RowIndex::delimiter() const noexcept {
+    return m_pimpl->m_header.delim;
+  }
+
+  unsigned char RowIndex::quote() const noexcept {
+    return m_pimpl->m_header.quote;
+  }
+
+  bool RowIndex::counts_blank_lines() const noexcept {
+    return (m_pimpl->m_header.options & CSV_REPALL_NL) != 0;
+  }
+
+  bool RowIndex::has_zone_maps() const noexcept {
+    return m_pimpl->m_zones != nullptr;
+  }
+
+  size_t RowIndex::zone_rows() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.zone_rows);
+  }
+
+  size_t RowIndex::zones() const noexcept {
+    return m_pimpl->m_zones ? m_pimpl->zone_count() : 0;
+  }
+
+  size_t RowIndex::zone_columns() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.zone_columns);
+  }
+
+  RowIndex::ZoneSpan RowIndex::zone_span(size_t zone) const {
+    const impl &d = *m_pimpl;
+    d.check_zone(zone);
+    const IndexHeader &h = d.m_header;
+    const std::uint64_t first = zone * h.zone_rows;
+    const std::uint64_t next = first + h.zone_rows;
+    ZoneSpan span;
+    span.row = first;
+    span.rows = std::min(next, h.rows) - first;
+    span.begin = d.m_offsets[first / h.stride];
+    span.end = next < h.rows ? d.m_offsets[next / h.stride] : h.source_size;
+    return span;
+  }
+
+  RowIndex::ColumnZone RowIndex::zone(size_t zone, size_t col) const {
+    const impl &d = *m_pimpl;
+    d.check_zone(zone);
+    const IndexHeader &h = d.m_header;
+    ColumnZone out;
+    if (col >= h.zone_columns) {
+      out.nulls = zone_span(zone).rows;
+      return out;
+    }
+    const std::size_t record = sizeof(ZoneRecord) + h.bloom_words * sizeof(std::uint64_t);
+    const unsigned char *p = d.m_zones + (zone * h.zone_columns + col) * record;
+    const auto *r = reinterpret_cast<const ZoneRecord *>(p);  // 8-byte aligned in the mapping
+    out.nulls = r->nulls;
+    out.ints = r->ints;
+    out.int_min = r->int_min;
+    out.int_max = r->int_max;
+    out.floats = r->floats;
+    out.float_min = r->float_min;
+    out.float_max = r->float_max;
+    out.has_text = (r->flags & kZoneHasText) != 0;
+    out.text_min = std::string_view(r->text_min, std::min<std::size_t>(r->text_min_len, kZoneText));
+    out.text_max = std::string_view(r->text_max, std::min<std::size_t>(r->text_max_len, kZoneText));
+    out.text_max_exact = (r->flags & kZoneMaxExact) != 0;
+    out.bloom = h.bloom_words ? p + sizeof(ZoneRecord) : nullptr;
+    out.bloom_bits = static_cast<size_t>(h.bloom_words * 64);
+    return out;
+  }
+
+  bool RowIndex::ColumnZone::may_equal(std::string_view value) const noexcept {
+    if (!has_text || value < text_min) return false;
+    if (value.substr(0, text_max_exact ? value.size() : text_max.size()) > text_max) return false;
+    if (bloom) {
+      bool hit = true;
+      bloom_probes(value, bloom_bits, [&](std::uint64_t bit) {
+        hit = hit && (detail::read64(bloom + bit / 64 * 8) >> (bit % 64) & 1);
+      });
+      return hit;
+    }
+    return true;
+  }
+
+  bool RowIndex::ColumnZone::may_start_with(std::string_view prefix) const noexcept {
+    if (!has_text) return false;
+    // Bounds truncated to a common length still order the candidates
+    const std::size_t lo = std::min(prefix.size(), text_min.size());
+    const std::size_t hi = std::min(prefix.size(), text_max.size());
+    return text_min.substr(0, lo) <= prefix.substr(0, lo) && prefix.substr(0, hi) <= text_max.substr(0, hi);
+  }
+
+  bool RowIndex::ColumnZone::may_int_range(std::int64_t lo, std::int64_t hi) const noexcept {
+    return ints > 0 && int_min <= hi && int_max >= lo;
+  }
+
+  bool RowIndex::ColumnZone::may_float_range(double lo, double hi) const noexcept {
+    return floats > 0 && float_min <= hi && float_max >= lo;
+  }
+
+} // namespace csv
@@ -0,0 +1,235 @@
+#include "RowSampler.hpp"
+
+#include "CsvParserImpl.hpp"
+#include "MappedFile.hpp"
+#include "Structure.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <unordered_set>
+
+namespace csv {
+  namespace {
+
+    // How far the parser states may disagree before the heuristic decides
+    constexpr std::size_t kSyncWindow = std::size_t{8} << 10;
+
+    constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+    struct Slice {
+      std::uint64_t begin;
+      std::uint64_t end;
+    };
+
+    void check_index(const RowIndex &index, const struct csv_parser &p) {
+      if (index.delimiter() != p.delim_char || index.quote() != p.quote_char ||
+          index.counts_blank_lines() != ((p.options & CSV_REPALL_NL) != 0)) {
+        throw CsvError("CSV Sample Error: index was built with a different parser configuration",
+                       CsvError::ErrorType::Einvalid);
+      }
+    }
+
+    /*
+     * Offset of the first row start after byte `from`, or kNone. Every
+     * parser state is a hypothesis for the state before `from`; once they
+     * all agree, the true state is known. Otherwise the hypothesis that
+     * met the fewest bytes CSV_STRICT would reject wins, lower states
+     * (outside quotes) first.
+     */
+    size_t next_row_start(const detail::StructTable &table, const unsigned char *data, size_t size, size_t from) {
+      constexpr int H = detail::kStructStates;
+      std::uint8_t state[H];
+      size_t errors[H] = {};
+      size_t first_end[H];
+      for (int s = 0; s < H; ++s) {
+        state[s] = static_cast<std::uint8_t>(s);
+        first_end[s] = kNone;
+      }
+
+      const size_t limit = size - from > kSyncWindow ? from + kSyncWindow : size;
+      for (size_t i = from; i < limit; ++i) {
+        bool agree = true;
+        for (int s = 0; s < H; ++s) {
+          const std::uint8_t t = table.next(state[s], data[i]);
+          state[s] = t & detail::StructTable::kStateMask;
+          if (t & detail::StructTable::kStrictError) ++errors[s];
+          if ((t & detail::StructTable::kRowEnd) && first_end[s] == kNone) first_end[s] = i + 1;
+          agree = agree && state[s] == state[0];
+        }
+        if (!agree) continue;
+        // A terminator all hypotheses agree on is a row boundary
+        if (state[0] == detail::kRowNotBegun) return i + 1 < size ? i + 1 : kNone;
+        std::uint8_t s = state[0];
+        for (size_t j = i + 1; j < size; ++j) {
+          const std::uint8_t t = table.next(s, data[j]);
+          s = t & detail::StructTable::kStateMask;
+          if (t & detail::StructTable::kRowEnd) return j + 1 < size ? j + 1 : kNone;
+        }
+        return kNone;
+      }
+
+      int best = 0;
+      for (int s = 1; s < H; ++s) {
+        if (errors[s] < errors[best]) best = s;
+      }
+      return first_end[best] < size ? first_end[best] : kNone;
+    }
+
+    // The row starting at `start`; false if only blank lines follow
+    bool row_at(const detail::StructTable &table, const unsigned char *data, size_t size, size_t start, Slice &out) {
+      std::uint8_t state = detail::kRowNotBegun;
+      for (size_t i = start; i < size; ++i) {
+        const std::uint8_t t = table.next(state, data[i]);
+        state = t & detail::StructTable::kStateMask;
+        if (t & detail::StructTable::kRowEnd) {
+          out = {start, i + 1};
+          return true;
+        }
+      }
+      out = {start, size};
+      return detail::StructTable::pending_row(state);
+    }
+
+    std::vector<Slice> index_sample(const detail::StructTable &table, const unsigned char *data, size_t size,
+                                    const RowIndex &index, std::uint64_t first, std::uint64_t rows,
+                                    std::mt19937_64 &rng) {
+      const std::uint64_t population = index.rows() > first ? index.rows() - first : 0;
+      const std::uint64_t k = rows < population ? rows : population;
+
+      // Floyd's algorithm: k distinct draws from [0, population)
+      std::unordered_set<std::uint64_t> chosen;
+      chosen.reserve(static_cast<size_t>(k));
+      for (std::uint64_t j = population - k; j < population; ++j) {
+        const std::uint64_t t = std::uniform_int_distribution<std::uint64_t>(0, j)(rng);
+        if (!chosen.insert(t).second) chosen.insert(j);
+      }
+      std::vector<std::uint64_t> picked(chosen.begin(), chosen.end());
+      std::sort(picked.begin(), picked.end());
+
+      // Walks from the indexed row, or on from the previous sample when closer
+      std::vector<Slice> out;
+      out.reserve(picked.size());
+      bool walking = false;
+      std::uint64_t cursor_row = 0;
+      std::uint64_t cursor = 0;
+      for (std::uint64_t r : picked) {
+        const std::uint64_t row = first + r;
+        const RowIndex::Position pos = index.locate(row);
+        if (!walking || cursor_row < pos.row || cursor_row > row) {
+          walking = true;
+          cursor_row = pos.row;
+          cursor = pos.offset;
+        }
+        for (; cursor_row < row && cursor < size; ++cursor_row) {
+          cursor += table.row_end(data + cursor, static_cast<size_t>(size - cursor));
+        }
+        if (cursor >= size) {
+          throw CsvError("CSV Sample Error: index does not match the sampled file", CsvError::ErrorType::Einvalid);
+        }
+        const std::uint64_t end = cursor + table.row_end(data + cursor, static_cast<size_t>(size - cursor));
+        out.push_back({cursor, end});
+        cursor_row = row + 1;
+        cursor = end;
+      }
+      return out;
+    }
+
+    std::vector<Slice> block_sample(const detail::StructTable &table, const unsigned char *data, size_t size,
+                                    size_t floor, std::uint64_t rows, std::mt19937_64 &rng) {
+      std::vector<Slice> out;
+      if (floor >= size || rows == 0) return out;
+
+      // A draw in a row picks the next one; draws in the last row wrap to the first
+      std::uniform_int_distribution<size_t> offset(floor, size - 1);
+      std::unordered_set<std::uint64_t> starts;
+      for (std::uint64_t attempts = 4 * rows + 16; starts.size() < rows && attempts > 0; --attempts) {
+        const size_t o = offset(rng);
+        const size_t start = o == floor ? floor : next_row_start(table, data, size, o - 1);
+        Slice row;
+        if ((start == kNone || !row_at(table, data, size, start, row)) && !row_at(table, data, size, floor, row)) {
+          continue;
+        }
+        if (starts.insert(row.begin).second) out.push_back(row);
+      }
+      std::sort(out.begin(), out.end(), [](const Slice &a, const Slice &b) { return a.begin < b.begin; });
+      return out;
+    }
+
+    std::vector<std::uint64_t> begins(const std::vector<Slice> &slices) {
+      std::vector<std::uint64_t> out;
+      out.reserve(slices.size());
+      for (const Slice &s : slices) out.push_back(s.begin);
+      return out;
+    }
+
+  } // namespace
+
+  struct RowSampler::impl {
+    detail::MappedFile file;
+    std::mt19937_64 rng;
+
+    impl(const std::string &path, std::uint64_t seed) : file(path), rng(seed) {}
+
+    size_t header_end(const CsvParser &parser, const detail::StructTable &table) const noexcept {
+      return parser.get_header_row() ? table.row_end(file.data(), file.size()) : 0;
+    }
+
+    std::uint64_t parse(CsvParser &parser, const std::vector<Slice> &slices,
+                        void (*cb1)(void *, size_t, void *), void (*cb2)(int, void *), void *data) const {
+      detail::begin_random_rows(parser, file.data(), file.size());
+      for (const Slice &s : slices) {
+        parser.parse(file.data() + s.begin, static_cast<size_t>(s.end - s.begin), cb1, cb2, data);
+      }
+      parser.finish(cb1, cb2, data);
+      return slices.size();
+    }
+  };
+
+  RowSampler::RowSampler(const std::string &path, std::uint64_t seed)
+      : m_pimpl(std::make_unique<impl>(path, seed)) {}
+  RowSampler::RowSampler(RowSampler&&) noexcept = default;
+  RowSampler& RowSampler::operator=(RowSampler&&) noexcept = default;
+  RowSampler::~RowSampler() = default;
+
+  std::uint64_t RowSampler::size() const noexcept {
+    return m_pimpl->file.size();
+  }
+
+  std::vector<std::uint64_t> RowSampler::locate(const CsvParser &parser, const RowIndex &index, std::uint64_t rows) {
+    const struct csv_parser &p = detail::ParserAccess::get(parser);
+    check_index(index, p);
+    const detail::StructTable table(p);
+    return begins(index_sample(table, m_pimpl->file.data(), m_pimpl->file.size(), index,
+                               parser.get_header_row() ? 1 : 0, rows, m_pimpl->rng));
+  }
+
+  std::vector<std::uint64_t> RowSampler::locate(const CsvParser &parser, std::uint64_t rows) {
+    const detail::StructTable table(detail::ParserAccess::get(parser));
+    return begins(block_sample(table, m_pimpl->file.data(), m_pimpl->file.size(),
+                               m_pimpl->header_end(parser, table), rows, m_pimpl->rng));
+  }
+
+  std::uint64_t RowSampler::read(CsvParser &parser, const RowIndex &index, std::uint64_t rows,
+                                 void (*cb1)(void *, size_t, void *),
+                                 void (*cb2)(int, void *),
+                                 void *data) {
+    const struct csv_parser &p = detail::ParserAccess::get(parser);
+    check_index(index, p);
+    const detail::StructTable table(p);
+    const std::vector<Slice> slices = index_sample(table, m_pimpl->file.data(), m_pimpl->file.size(), index,
+                                                   parser.get_header_row() ? 1 : 0, rows, m_pimpl->rng);
+    return m_pimpl->parse(parser, slices, cb1, cb2, data);
+  }
+
+  std::uint64_t RowSampler::read(CsvParser &parser, std::uint64_t rows,
+                                 void (*cb1)(void *, size_t, void *),
+                                 void (*cb2)(int, void *),
+                                 void *data) {
+    const detail::StructTable table(detail::ParserAccess::get(parser));
+    const std::vector<Slice> slices = block_sample(table, m_pimpl->file.data(), m_pimpl->file.size(),
+                                                   m_pimpl->header_end(parser, table), rows, m_pimpl->rng);
+    return m_pimpl->parse(parser, slices, cb1, cb2, data);
+  }
+
+} // namespace csv
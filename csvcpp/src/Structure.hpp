@@ -0,0 +1,151 @@
+#ifndef CSV_STRUCTURE_HPP
+#define CSV_STRUCTURE_HPP
+
+#include "csv.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Internal: byte-level model of where csv_parse() ends rows, without
+// buffering field contents. Used to index and scan files quickly.
+
+namespace csv {
+  namespace detail {
+
+    /**
+     * @brief Row-structure states of csv_parse().
+     *
+     * libcsv's FIELD_BEGUN is split on `quoted` and FIELD_MIGHT_HAVE_ENDED
+     * on whether spaces followed the closing quote; those are the only
+     * parts of its state that change how later bytes are classified.
+     */
+    enum StructState : std::uint8_t {
+      kRowNotBegun = 0,
+      kFieldNotBegun,
+      kFieldUnquoted,
+      kFieldQuoted,
+      kMightHaveEnded,
+      kMightHaveEndedSpaces,
+      kStructStates
+    };
+
+    /**
+     * @brief Transition table equivalent to csv_parse() for one parser setup.
+     *
+     * Each entry holds the next state, with kRowEnd set when csv_parse()
+     * would submit a row on that byte and kFieldEnd when it would submit a
+     * field (a delimiter, or a terminator closing a row that has fields).
+     * Bytes that would fail a parse under CSV_STRICT carry kStrictError and
+     * otherwise follow the permissive transition.
+     */
+    class StructTable {
+    public:
+      static constexpr std::uint8_t kRowEnd = 0x80;
+      static constexpr std::uint8_t kFieldEnd = 0x40;
+      static constexpr std::uint8_t kStrictError = 0x20;
+      static constexpr std::uint8_t kStateMask = 0x0F;
+
+      explicit StructTable(const struct csv_parser &p) noexcept {
+        for (int c = 0; c < 256; ++c) {
+          const auto uc = static_cast<unsigned char>(c);
+          const bool space = (p.is_space ? p.is_space(uc) : uc == CSV_SPACE || uc == CSV_TAB) != 0;
+          const bool term = (p.is_term ? p.is_term(uc) : uc == CSV_CR || uc == CSV_LF) != 0;
+          const bool delim = uc == p.delim_char;
+          const bool quote = uc == p.quote_char;
+          const bool repall = (p.options & CSV_REPALL_NL) != 0;
+
+          // Branch order mirrors csv_parse() for each state
+          for (int s : {kRowNotBegun, kFieldNotBegun}) {
+            std::uint8_t &t = m_next[s][c];
+            if (space && !delim) t = static_cast<std::uint8_t>(s);
+            else if (term) t = s == kFieldNotBegun ? kRowNotBegun | kRowEnd | kFieldEnd
+                                                   : kRowNotBegun | (repall ? kRowEnd : 0);
+            else if (delim) t = kFieldNotBegun | kFieldEnd;
+            else if (quote) t = kFieldQuoted;
+            else t = kFieldUnquoted;
+          }
+
+          std::uint8_t &u = m_next[kFieldUnquoted][c];
+          if (quote) u = kFieldUnquoted | kStrictError;
+          else if (delim) u = kFieldNotBegun | kFieldEnd;
+          else if (term) u = kRowNotBegun | kRowEnd | kFieldEnd;
+          else u = kFieldUnquoted;
+
+          m_next[kFieldQuoted][c] = quote ? kMightHaveEnded : kFieldQuoted;
+
+          for (int s : {kMightHaveEnded, kMightHaveEndedSpaces}) {
+            std::uint8_t &t = m_next[s][c];
+            if (delim) t = kFieldNotBegun | kFieldEnd;
+            else if (term) t = kRowNotBegun | kRowEnd | kFieldEnd;
+            else if (space) t = kMightHaveEndedSpaces;
+            else if (quote) t = s == kMightHaveEndedSpaces ? kMightHaveEnded | kStrictError : kFieldQuoted;
+            else t = kFieldQuoted | kStrictError;
+          }
+        }
+      }
+
+      [[nodiscard]] std::uint8_t next(std::uint8_t state, unsigned char c) const noexcept {
+        return m_next[state][c];
+      }
+
+      /// Whether csv_fini() submits a row when parsing stops in @p state
+      [[nodiscard]] static constexpr bool pending_row(std::uint8_t state) noexcept {
+        return state != kRowNotBegun;
+      }
+
+      /**
+       * @brief Runs the automaton over [p, p + n) from @p state.
+       *
+       * Calls @p on_row_end(offset_after_terminator) for every row end and
+       * returns the final state.
+       */
+      template <typename F>
+      std::uint8_t scan(std::uint8_t state, const unsigned char *p, std::size_t n, F &&on_row_end) const {
+        for (std::size_t i = 0; i < n; ++i) {
+          const std::uint8_t t = m_next[state][p[i]];
+          state = t & kStateMask;
+          if (t & kRowEnd) on_row_end(i + 1);
+        }
+        return state;
+      }
+
+      /**
+       * @brief Offset just past the end of the row starting at @p p, or @p n
+       *        if it has no terminator.
+       */
+      [[nodiscard]] std::size_t row_end(const unsigned char *p, std::size_t n) const noexcept {
+        std::uint8_t state = kRowNotBegun;
+        for (std::size_t i = 0; i < n; ++i) {
+          const std::uint8_t t = m_next[state][p[i]];
+          state = t & kStateMask;
+          if (t & kRowEnd) return i + 1;
+        }
+        return n;
+      }
+
+      /**
+       * @brief Like scan(), also reporting delimiters that end a field.
+       *
+       * Calls @p on_delim(offset_after_delimiter) and
+       * @p on_row_end(offset_after_terminator, row_has_fields).
+       */
+      template <typename D, typename R>
+      std::uint8_t scan_fields(std::uint8_t state, const unsigned char *p, std::size_t n,
+                               D &&on_delim, R &&on_row_end) const {
+        for (std::size_t i = 0; i < n; ++i) {
+          const std::uint8_t t = m_next[state][p[i]];
+          state = t & kStateMask;
+          if (t & kRowEnd) on_row_end(i + 1, (t & kFieldEnd) != 0);
+          else if (t & kFieldEnd) on_delim(i + 1);
+        }
+        return state;
+      }
+
+    private:
+      std::uint8_t m_next[kStructStates][256] = {};
+    };
+
+  } // namespace detail
+} // namespace csv
+
+#endif // CSV_STRUCTURE_HPP
@@ -0,0 +1,197 @@
+#include "TailReader.hpp"
+
+#include "CsvParserImpl.hpp"
+#include "MappedFile.hpp"
+#include "Structure.hpp"
+
+#include <vector>
+
+namespace csv {
+  namespace {
+
+    // How far before the tail the forward verification starts
+    constexpr std::size_t kVerifyBytes = std::size_t{1} << 16;
+
+    struct Tail {
+      std::uint64_t offset;
+      std::uint64_t rows;
+    };
+
+    bool is_term(const struct csv_parser &p, unsigned char c) noexcept {
+      return p.is_term ? p.is_term(c) != 0 : c == CSV_CR || c == CSV_LF;
+    }
+
+    /*
+     * Walks backwards from the end of the file, counting quote characters.
+     * Line starts behind an even number of quotes are row boundaries if
+     * quotes are balanced. The walk keeps its position, so a tail that
+     * turns out too short is extended rather than rescanned.
+     */
+    class BackwardWalk {
+    public:
+      BackwardWalk(const unsigned char *data, size_t size, size_t floor, const struct csv_parser &p) noexcept
+          : m_data(data), m_size(size), m_floor(floor), m_pos(size), m_last(size), m_p(p) {}
+
+      /// Moves back until @p lines line starts were passed in total; returns the last one
+      size_t lines(std::uint64_t lines) noexcept {
+        while (m_found < lines && m_pos > m_floor) step();
+        return m_found < lines ? m_floor : m_last;
+      }
+
+      /// Moves back at least @p bytes further, to the next line start
+      size_t bytes(size_t bytes) noexcept {
+        const size_t target = m_pos - m_floor > bytes ? m_pos - bytes : m_floor;
+        while (m_pos > target) step();
+        const std::uint64_t found = m_found;
+        while (m_found == found && m_pos > m_floor) step();
+        return m_found == found ? m_floor : m_last;
+      }
+
+    private:
+      const unsigned char *m_data;
+      size_t m_size;
+      size_t m_floor;
+      size_t m_pos;       // bytes [m_pos, m_size) were visited
+      size_t m_last;      // last line start passed
+      std::uint64_t m_found = 0;
+      std::uint64_t m_quotes = 0;
+      const struct csv_parser &m_p;
+
+      void step() noexcept {
+        const unsigned char c = m_data[--m_pos];
+        if (c == m_p.quote_char) {
+          ++m_quotes;
+        } else if (is_term(m_p, c) && (m_quotes & 1) == 0 && m_pos + 1 < m_size &&
+                   !is_term(m_p, m_data[m_pos + 1])) {
+          ++m_found;
+          m_last = m_pos + 1;
+        }
+      }
+    };
+
+    /// Offset just past the first row that has fields, or @p size
+    size_t header_end(const detail::StructTable &table, const unsigned char *data, size_t size) noexcept {
+      std::uint8_t state = detail::kRowNotBegun;
+      for (size_t i = 0; i < size; ++i) {
+        const std::uint8_t t = table.next(state, data[i]);
+        state = t & detail::StructTable::kStateMask;
+        if ((t & detail::StructTable::kRowEnd) && (t & detail::StructTable::kFieldEnd)) return i + 1;
+      }
+      return size;
+    }
+
+    /*
+     * Scans forward from the row boundary `from` and takes the last `rows`
+     * rows starting at or after `first`. Returns false if `first` is not
+     * reached between rows or the file ends inside a quoted field, i.e. if
+     * the quote parity assumed by BackwardWalk does not hold.
+     */
+    bool scan_tail(const detail::StructTable &table, const unsigned char *data, size_t size,
+                   size_t from, size_t first, std::uint64_t rows, Tail &out) {
+      bool consistent = table.scan(detail::kRowNotBegun, data + from, first - from, [](size_t) {}) ==
+                        detail::kRowNotBegun;
+
+      // Ring of the last rows + 1 row boundaries
+      std::vector<std::uint64_t> ring(static_cast<size_t>(rows) + 1);
+      std::uint64_t pushed = 0;
+      auto push = [&](std::uint64_t off) { ring[static_cast<size_t>(pushed++ % ring.size())] = off; };
+      push(first);
+      const std::uint8_t state =
+        table.scan(detail::kRowNotBegun, data + first, size - first, [&](size_t off) { push(first + off); });
+      if (state == detail::kFieldQuoted) consistent = false;
+
+      // Without a pending row the last boundary is the end of the file
+      const bool pending = detail::StructTable::pending_row(state);
+      const std::uint64_t found = pending ? pushed : pushed - 1;
+      const std::uint64_t k = found < rows ? found : rows;
+      out.rows = k;
+      out.offset = k == 0 ? size : ring[static_cast<size_t>((pushed - k - (pending ? 0 : 1)) % ring.size())];
+      return consistent;
+    }
+
+    Tail find_tail(const unsigned char *data, size_t size, size_t floor,
+                   const struct csv_parser &p, std::uint64_t rows) {
+      Tail tail{size, 0};
+      if (rows == 0 || floor >= size) return tail;
+      if (rows > size - floor) rows = size - floor;  // every row takes at least one byte
+
+      const detail::StructTable table(p);
+      BackwardWalk walk(data, size, floor, p);
+      std::uint64_t want = rows;
+      for (;;) {
+        const size_t first = walk.lines(want);
+        if (first == floor) break;
+
+        BackwardWalk verify = walk;
+        const size_t from = verify.bytes(kVerifyBytes);
+        if (!scan_tail(table, data, size, from, first, rows, tail)) break;
+        if (tail.rows == rows) return tail;
+        // Some lines were not rows (spaces only, or blank without RepAllNl)
+        want += rows - tail.rows;
+      }
+
+      // Exact: the floor is a known row boundary
+      scan_tail(table, data, size, floor, floor, rows, tail);
+      return tail;
+    }
+
+  } // namespace
+
+  struct TailReader::impl {
+    detail::MappedFile file;
+
+    explicit impl(const std::string &path) : file(path) {}
+  };
+
+  TailReader::TailReader(const std::string &path) : m_pimpl(std::make_unique<impl>(path)) {}
+  TailReader::TailReader(TailReader&&) noexcept = default;
+  TailReader& TailReader::operator=(TailReader&&) noexcept = default;
+  TailReader::~TailReader() = default;
+
+  std::uint64_t TailReader::size() const noexcept {
+    return m_pimpl->file.size();
+  }
+
+  std::uint64_t TailReader::locate(const CsvParser &parser, std::uint64_t rows) const {
+    const struct csv_parser &p = detail::ParserAccess::get(parser);
+    const unsigned char *data = m_pimpl->file.data();
+    const size_t size = m_pimpl->file.size();
+    const size_t floor = parser.get_header_row() ? header_end(detail::StructTable(p), data, size) : 0;
+    return find_tail(data, size, floor, p, rows).offset;
+  }
+
+  std::uint64_t TailReader::read(CsvParser &parser, std::uint64_t rows,
+                                 void (*cb1)(void *, size_t, void *),
+                                 void (*cb2)(int, void *),
+                                 void *data) const {
+    auto &state = detail::ParserAccess::state(parser);
+    struct csv_parser &p = state.m_parser;
+    const unsigned char *bytes = m_pimpl->file.data();
+    const size_t size = m_pimpl->file.size();
+
+    detail::reset_row_state(p);
+    state.m_plan.skip_rows = 0;
+    state.m_plan.header_fields.clear();
+    state.m_plan.begin_row();
+
+    size_t floor = 0;
+    if (parser.get_header_row()) {
+      floor = header_end(detail::StructTable(p), bytes, size);
+      if (state.m_plan.capture_header) {
+        // Captures the header; no data row is parsed
+        parser.parse(bytes, floor, nullptr, nullptr, nullptr);
+        if (floor == size) {
+          parser.finish(nullptr, nullptr, nullptr);  // header without terminator
+          return 0;
+        }
+      }
+      state.m_plan.capture_header = false;
+    }
+
+    const Tail tail = find_tail(bytes, size, floor, p, rows);
+    parser.parse(bytes + tail.offset, size - tail.offset, cb1, cb2, data);
+    parser.finish(cb1, cb2, data);
+    return tail.rows;
+  }
+
+} // namespace csv
@@ -0,0 +1,465 @@
+#include "TextIndex.hpp"
+
+#include "CsvParserImpl.hpp"
+#include "MappedFile.hpp"
+#include "Structure.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+
+// Text index file layout (host byte order):
+//
+//   TextHeader
+//   columns  : std::uint64_t[column_count], the indexed columns ascending
+//              (none when every column is indexed)
+//   dict     : TextEntry[tokens], sorted by token bytes
+//   blob     : token bytes, in dictionary order
+//   postings : per token, `count` LEB128 varints in dictionary order; the
+//              first is a row start offset, the rest deltas to the previous
+//
+// Sections go out in the order above behind a zeroed TextHeader, which is
+// patched in once postings are flushed; read_header() then requires every
+// section offset to follow from the previous one and the postings to end
+// exactly at the end of the file.
+
+namespace csv {
+  namespace {
+
+    constexpr char kMagic[8] = {'C', 'S', 'V', 'T', 'E', 'X', 'T', 'X'};
+    constexpr std::uint32_t kVersion = 2;
+    constexpr std::uint32_t kByteOrder = 0x01020304;
+    constexpr std::uint8_t kCaseSensitive = 0x01;
+    constexpr std::uint8_t kHasHeader = 0x02;
+
+    struct TextHeader {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byte_order;
+      std::uint64_t source_size;
+      std::int64_t source_mtime_ns;
+      std::uint64_t rows;
+      std::uint64_t column_count;
+      std::uint64_t tokens;
+      std::uint64_t dict_offset;
+      std::uint64_t blob_offset;
+      std::uint64_t blob_size;
+      std::uint64_t postings_offset;
+      std::uint64_t postings_size;
+      std::uint64_t file_size;
+      std::uint8_t delim;
+      std::uint8_t quote;
+      std::uint8_t options;
+      std::uint8_t flags;
+      std::uint8_t reserved[4];
+    };
+
+    struct TextEntry {
+      std::uint64_t token_offset;     // into blob
+      std::uint64_t postings_offset;  // into postings
+      std::uint32_t token_len;
+      std::uint32_t count;            // rows holding the token
+    };
+
+    struct FileDeleter {
+      void operator()(FILE* f) const { if (f) std::fclose(f); }
+    };
+
+    bool is_token_byte(unsigned char c) noexcept {
+      return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+    }
+
+    unsigned char fold(unsigned char c, bool case_sensitive) noexcept {
+      return !case_sensitive && c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+    }
+
+    // Calls @p on_token(std::string_view) for every token of [p, p + n), reusing @p buf
+    template <typename F>
+    void for_each_token(const unsigned char *p, std::size_t n, bool case_sensitive, std::string &buf, F &&on_token) {
+      std::size_t i = 0;
+      while (i < n) {
+        while (i < n && !is_token_byte(p[i])) ++i;
+        if (i == n) break;
+        buf.clear();
+        while (i < n && is_token_byte(p[i])) buf += static_cast<char>(fold(p[i++], case_sensitive));
+        on_token(std::string_view(buf));
+      }
+    }
+
+    void put_varint(std::string &out, std::uint64_t v) {
+      while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+      }
+      out += static_cast<char>(v);
+    }
+
+    bool get_varint(const unsigned char *&p, const unsigned char *end, std::uint64_t &v) noexcept {
+      v = 0;
+      for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        const unsigned char b = *p++;
+        v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+      }
+      return false;
+    }
+
+    bool read_header(const unsigned char *p, std::size_t size, TextHeader &h) noexcept {
+      if (size < sizeof(TextHeader)) return false;
+      std::memcpy(&h, p, sizeof(h));
+      return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+             h.byte_order == kByteOrder && h.file_size == size &&
+             h.column_count <= (size - sizeof(TextHeader)) / sizeof(std::uint64_t) &&
+             h.dict_offset == sizeof(TextHeader) + h.column_count * sizeof(std::uint64_t) &&
+             h.tokens <= (size - h.dict_offset) / sizeof(TextEntry) &&
+             h.blob_offset == h.dict_offset + h.tokens * sizeof(TextEntry) &&
+             h.blob_size <= size - h.blob_offset &&
+             h.postings_offset == h.blob_offset + h.blob_size &&
+             h.postings_size == size - h.postings_offset;
+    }
+
+    void check_config(const TextHeader &h, const struct csv_parser &p) {
+      if (h.delim != p.delim_char || h.quote != p.quote_char || ((h.options ^ p.options) & CSV_REPALL_NL) != 0) {
+        throw CsvError("CSV Index Error: text index was built with a different parser configuration",
+                       CsvError::ErrorType::Einvalid);
+      }
+    }
+
+    struct Postings {
+      std::string bytes;
+      std::uint64_t last = 0;
+      std::uint32_t count = 0;
+    };
+
+    /*
+     * csv_parse() callbacks tokenizing the selected fields of each row and
+     * appending the row's start offset to the postings of every token, once.
+     */
+    struct TokenCollector {
+      std::unordered_map<std::string, Postings> postings;
+      std::vector<bool> selected;  // empty selects every column
+      bool case_sensitive = false;
+      const std::vector<std::uint64_t> *starts = nullptr;  // row k starts at (*starts)[k]
+      std::uint64_t skip_rows = 0;  // header
+      std::size_t col = 0;
+      std::uint64_t row = 0;
+      std::string token;
+    };
+
+    void collect_field(void *s, std::size_t len, void *data) {
+      auto *c = static_cast<TokenCollector *>(data);
+      const std::size_t col = c->col++;
+      if (!s || c->row < c->skip_rows || c->row >= c->starts->size()) return;
+      if (!c->selected.empty() && (col >= c->selected.size() || !c->selected[col])) return;
+      const std::uint64_t offset = (*c->starts)[static_cast<std::size_t>(c->row)];
+      for_each_token(static_cast<const unsigned char *>(s), len, c->case_sensitive, c->token,
+                     [&](std::string_view token) {
+        Postings &p = c->postings[std::string(token)];
+        if (p.count > 0 && p.last == offset) return;  // already listed for this row
+        put_varint(p.bytes, p.count > 0 ? offset - p.last : offset);
+        p.last = offset;
+        ++p.count;
+      });
+    }
+
+    void collect_row(int, void *data) {
+      auto *c = static_cast<TokenCollector *>(data);
+      ++c->row;
+      c->col = 0;
+    }
+
+    void write_index(const std::string &index_path, TextHeader &header, const std::vector<std::uint64_t> &columns,
+                     const std::vector<TextEntry> &dict, const std::string &blob, const std::string &postings) {
+      std::memcpy(header.magic, kMagic, sizeof(kMagic));
+      header.version = kVersion;
+      header.byte_order = kByteOrder;
+      header.column_count = columns.size();
+      header.tokens = dict.size();
+      header.dict_offset = sizeof(TextHeader) + columns.size() * sizeof(std::uint64_t);
+      header.blob_offset = header.dict_offset + dict.size() * sizeof(TextEntry);
+      header.blob_size = blob.size();
+      header.postings_offset = header.blob_offset + blob.size();
+      header.postings_size = postings.size();
+      header.file_size = header.postings_offset + postings.size();
+
+      const std::string tmp_path = index_path + ".tmp";
+      std::unique_ptr<FILE, FileDeleter> outfile(std::fopen(tmp_path.c_str(), "wb"));
+      if (!outfile) {
+        throw std::runtime_error("Failed to open " + tmp_path + ": " + std::strerror(errno));
+      }
+      TextHeader blank{};
+      if (std::fwrite(&blank, sizeof(blank), 1, outfile.get()) != 1 ||
+          (!columns.empty() &&
+           std::fwrite(columns.data(), sizeof(std::uint64_t), columns.size(), outfile.get()) != columns.size()) ||
+          (!dict.empty() && std::fwrite(dict.data(), sizeof(TextEntry), dict.size(), outfile.get()) != dict.size()) ||
+          std::fwrite(blob.data(), 1, blob.size(), outfile.get()) != blob.size() ||
+          std::fwrite(postings.data(), 1, postings.size(), outfile.get()) != postings.size() ||
+          std::fseek(outfile.get(), 0, SEEK_SET) != 0 ||
+          std::fwrite(&header, sizeof(header), 1, outfile.get()) != 1 ||
+          std::fclose(outfile.release()) != 0) {
+        throw std::runtime_error("Failed to write " + tmp_path);
+      }
+      if (std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Failed to rename " + tmp_path + ": " + std::strerror(errno));
+      }
+    }
+
+  } // namespace
+
+  struct TextIndex::impl {
+    std::unique_ptr<detail::MappedFile> m_file;
+    std::unique_ptr<detail::MappedFile> m_source;
+    TextHeader m_header{};
+    std::vector<std::size_t> m_columns;
+    const TextEntry *m_dict = nullptr;
+    const unsigned char *m_blob = nullptr;
+    const unsigned char *m_postings = nullptr;
+
+    std::string_view token_of(const TextEntry &e) const noexcept {
+      return {reinterpret_cast<const char *>(m_blob + e.token_offset), e.token_len};
+    }
+
+    const TextEntry *lookup(std::string_view token) const noexcept {
+      const TextEntry *first = m_dict;
+      const TextEntry *last = m_dict + m_header.tokens;
+      const TextEntry *e = std::lower_bound(first, last, token,
+                                            [this](const TextEntry &a, std::string_view t) { return token_of(a) < t; });
+      return e != last && token_of(*e) == token ? e : nullptr;
+    }
+
+    std::vector<std::uint64_t> decode(const TextEntry &e) const {
+      const TextEntry *next = &e + 1;
+      const unsigned char *p = m_postings + e.postings_offset;
+      const unsigned char *end = m_postings + (next != m_dict + m_header.tokens ? next->postings_offset
+                                                                                 : m_header.postings_size);
+      std::vector<std::uint64_t> rows;
+      rows.reserve(e.count);
+      std::uint64_t offset = 0;
+      for (std::uint32_t i = 0; i < e.count; ++i) {
+        std::uint64_t delta;
+        if (!get_varint(p, end, delta)) {
+          throw CsvError("CSV Index Error: text index postings truncated", CsvError::ErrorType::Einvalid);
+        }
+        offset += delta;
+        rows.push_back(offset);
+      }
+      return rows;
+    }
+  };
+
+  TextIndex::TextIndex() : m_pimpl(std::make_unique<impl>()) {}
+  TextIndex::TextIndex(TextIndex&&) noexcept = default;
+  TextIndex& TextIndex::operator=(TextIndex&&) noexcept = default;
+  TextIndex::~TextIndex() = default;
+
+  std::vector<std::string> TextIndex::tokenize(std::string_view text, bool case_sensitive) {
+    std::vector<std::string> out;
+    std::string buf;
+    for_each_token(reinterpret_cast<const unsigned char *>(text.data()), text.size(), case_sensitive, buf,
+                   [&](std::string_view token) { out.emplace_back(token); });
+    return out;
+  }
+
+  void TextIndex::build(const std::string &csv_path, const std::string &index_path,
+                        const CsvParser &parser, const TextIndexOptions &options) {
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    detail::FileStat st;
+    if (!detail::stat_file(csv_path, st)) {
+      throw std::runtime_error("Failed to stat " + csv_path + ": " + std::strerror(errno));
+    }
+    detail::MappedFile source(csv_path);
+    const unsigned char *data = source.data();
+    const size_t size = source.size();
+
+    std::vector<std::uint64_t> starts{0};
+    const std::uint8_t state = detail::StructTable(cp).scan(detail::kRowNotBegun, data, size,
+                                                            [&](size_t off) { starts.push_back(off); });
+    if (!detail::StructTable::pending_row(state)) starts.pop_back();  // no row begins after the last terminator
+
+    TokenCollector c;
+    for (size_t col : options.columns) {
+      if (col >= c.selected.size()) c.selected.resize(col + 1);
+      c.selected[col] = true;
+    }
+    c.case_sensitive = options.case_sensitive;
+    c.starts = &starts;
+    c.skip_rows = options.header_row ? 1 : 0;
+    detail::ScratchParser(cp).run(data, size, 0, collect_field, collect_row, &c);
+
+    std::vector<std::pair<const std::string, Postings> *> sorted;
+    sorted.reserve(c.postings.size());
+    for (auto &kv : c.postings) sorted.push_back(&kv);
+    std::sort(sorted.begin(), sorted.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+
+    std::vector<TextEntry> dict;
+    dict.reserve(sorted.size());
+    std::string blob;
+    std::string postings;
+    for (const auto *kv : sorted) {
+      dict.push_back({blob.size(), postings.size(), static_cast<std::uint32_t>(kv->first.size()), kv->second.count});
+      blob += kv->first;
+      postings += kv->second.bytes;
+    }
+
+    TextHeader header{};
+    header.source_size = st.size;
+    header.source_mtime_ns = st.mtime_ns;
+    header.rows = starts.size();
+    header.delim = cp.delim_char;
+    header.quote = cp.quote_char;
+    header.options = cp.options;
+    header.flags = static_cast<std::uint8_t>((options.case_sensitive ? kCaseSensitive : 0) |
+                                             (options.header_row ? kHasHeader : 0));
+    std::vector<std::uint64_t> columns;
+    for (size_t col = 0; col < c.selected.size(); ++col) {
+      if (c.selected[col]) columns.push_back(col);
+    }
+    write_index(index_path, header, columns, dict, blob, postings);
+  }
+
+  bool TextIndex::is_fresh(const std::string &index_path, const std::string &source_path) noexcept {
+    detail::FileStat st;
+    if (!detail::stat_file(source_path, st)) return false;
+    std::unique_ptr<FILE, FileDeleter> fp(std::fopen(index_path.c_str(), "rb"));
+    if (!fp || std::fseek(fp.get(), 0, SEEK_END) != 0) return false;
+    const long size = std::ftell(fp.get());
+    unsigned char buf[sizeof(TextHeader)];
+    TextHeader h;
+    if (size < 0 || std::fseek(fp.get(), 0, SEEK_SET) != 0 ||
+        std::fread(buf, 1, sizeof(buf), fp.get()) != sizeof(buf) ||
+        !read_header(buf, static_cast<size_t>(size), h)) {
+      return false;
+    }
+    return h.source_size == st.size && h.source_mtime_ns == st.mtime_ns;
+  }
+
+  TextIndex TextIndex::open(const std::string &index_path, const std::string &source_path) {
+    auto invalid = [&](const char *why) {
+      return CsvError("CSV Index Error: " + index_path + ": " + why, CsvError::ErrorType::Einvalid);
+    };
+
+    detail::FileStat st;
+    if (!detail::stat_file(source_path, st)) {
+      throw std::runtime_error("Failed to stat " + source_path + ": " + std::strerror(errno));
+    }
+
+    TextIndex index;
+    impl &d = *index.m_pimpl;
+    d.m_file = std::make_unique<detail::MappedFile>(index_path);
+    if (!read_header(d.m_file->data(), d.m_file->size(), d.m_header)) {
+      throw invalid("not a text index or truncated");
+    }
+    for (size_t i = 0; i < d.m_header.column_count; ++i) {
+      std::uint64_t col;
+      std::memcpy(&col, d.m_file->data() + sizeof(TextHeader) + i * sizeof(col), sizeof(col));
+      if (!d.m_columns.empty() && col <= d.m_columns.back()) {
+        throw invalid("indexed columns not ascending");
+      }
+      d.m_columns.push_back(static_cast<size_t>(col));
+    }
+    if (d.m_header.source_size != st.size || d.m_header.source_mtime_ns != st.mtime_ns) {
+      throw invalid("stale: source file changed since the index was built");
+    }
+    d.m_source = std::make_unique<detail::MappedFile>(source_path);
+    if (d.m_source->size() != d.m_header.source_size) {
+      throw invalid("stale: source file changed since the index was built");
+    }
+    d.m_dict = reinterpret_cast<const TextEntry *>(d.m_file->data() + d.m_header.dict_offset);
+    d.m_blob = d.m_file->data() + d.m_header.blob_offset;
+    d.m_postings = d.m_file->data() + d.m_header.postings_offset;
+    std::uint64_t postings = 0;
+    for (size_t i = 0; i < d.m_header.tokens; ++i) {
+      const TextEntry &e = d.m_dict[i];
+      if (e.token_offset > d.m_header.blob_size || e.token_len > d.m_header.blob_size - e.token_offset ||
+          e.postings_offset < postings || e.postings_offset > d.m_header.postings_size) {
+        throw invalid("dictionary entry out of bounds");
+      }
+      postings = e.postings_offset;
+    }
+    return index;
+  }
+
+  std::uint64_t TextIndex::rows() const noexcept {
+    return m_pimpl->m_header.rows;
+  }
+
+  size_t TextIndex::tokens() const noexcept {
+    return static_cast<size_t>(m_pimpl->m_header.tokens);
+  }
+
+  bool TextIndex::case_sensitive() const noexcept {
+    return (m_pimpl->m_header.flags & kCaseSensitive) != 0;
+  }
+
+  const std::vector<size_t> &TextIndex::columns() const noexcept {
+    return m_pimpl->m_columns;
+  }
+
+  bool TextIndex::header_row() const noexcept {
+    return (m_pimpl->m_header.flags & kHasHeader) != 0;
+  }
+
+  bool TextIndex::built_with(const TextIndexOptions &options) const {
+    std::vector<size_t> requested = options.columns;
+    std::sort(requested.begin(), requested.end());
+    requested.erase(std::unique(requested.begin(), requested.end()), requested.end());
+    return requested == columns() && options.header_row == header_row() &&
+           options.case_sensitive == case_sensitive();
+  }
+
+  std::vector<std::uint64_t> TextIndex::find(std::string_view query) const {
+    const impl &d = *m_pimpl;
+    std::vector<std::string> tokens = tokenize(query, case_sensitive());
+    std::vector<const TextEntry *> entries;
+    for (const std::string &t : tokens) {
+      const TextEntry *e = d.lookup(t);
+      if (!e) return {};
+      entries.push_back(e);
+    }
+    if (entries.empty()) return {};
+
+    // Intersect starting from the rarest token so the candidate list only shrinks
+    std::sort(entries.begin(), entries.end(), [](const TextEntry *a, const TextEntry *b) {
+      return a->count != b->count ? a->count < b->count : a < b;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    std::vector<std::uint64_t> rows = d.decode(*entries[0]);
+    for (size_t i = 1; i < entries.size() && !rows.empty(); ++i) {
+      const std::vector<std::uint64_t> other = d.decode(*entries[i]);
+      std::vector<std::uint64_t> both;
+      std::set_intersection(rows.begin(), rows.end(), other.begin(), other.end(), std::back_inserter(both));
+      rows.swap(both);
+    }
+    return rows;
+  }
+
+  size_t TextIndex::lookup(CsvParser &parser, std::string_view query,
+                           void (*cb1)(void *, size_t, void *),
+                           void (*cb2)(int, void *),
+                           void *data) const {
+    const struct csv_parser &cp = detail::ParserAccess::get(parser);
+    check_config(m_pimpl->m_header, cp);
+    const std::vector<std::uint64_t> rows = find(query);
+    const unsigned char *bytes = m_pimpl->m_source->data();
+    const size_t size = m_pimpl->m_source->size();
+    detail::begin_random_rows(parser, bytes, size);
+
+    const detail::StructTable table(cp);
+    size_t found = 0;
+    for (std::uint64_t offset : rows) {
+      if (offset == 0 && parser.get_header_row()) continue;
+      if (offset >= size) break;
+      const size_t begin = static_cast<size_t>(offset);
+      parser.parse(bytes + begin, table.row_end(bytes + begin, size - begin), cb1, cb2, data);
+      ++found;
+    }
+    parser.finish(cb1, cb2, data);
+    return found;
+  }
+
+} // namespace csv
@@ -0,0 +1,171 @@
+/*
+csvgrep - prints the rows of a CSV file whose fields contain every word
+          of a query, scanning the file or answering from a .csvtxt
+          token index
+*/
+
+#include "CsvParser.hpp"
+#include "TextIndex.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace csv;
+
+struct FileDeleter {
+  void operator()(FILE* f) const { if (f) std::fclose(f); }
+};
+
+/* Writes each row back out as CSV */
+struct Printer {
+  bool first = true;
+  size_t rows = 0;
+};
+
+static void print_field (void *s, size_t len, void *data) {
+  Printer *pr = static_cast<Printer *>(data);
+  if (!pr->first) fputc(',', stdout);
+  CsvParser::fwrite(stdout, s, len);
+  pr->first = false;
+}
+
+static void print_row (int, void *data) {
+  Printer *pr = static_cast<Printer *>(data);
+  fputc('\n', stdout);
+  pr->first = true;
+  ++pr->rows;
+}
+
+/* Buffers a row, then prints it if its selected fields hold every query token */
+struct Scan {
+  std::vector<std::string> query;
+  std::vector<size_t> columns;
+  bool case_sensitive = false;
+  std::vector<std::string> fields;
+  std::vector<bool> nulls;
+  std::vector<std::string> found;
+  Printer printer;
+};
+
+static void scan_field (void *s, size_t len, void *data) {
+  Scan *sc = static_cast<Scan *>(data);
+  sc->fields.emplace_back(s ? static_cast<const char *>(s) : "", len);
+  sc->nulls.push_back(s == nullptr);
+}
+
+static void scan_row (int c, void *data) {
+  Scan *sc = static_cast<Scan *>(data);
+  sc->found.clear();
+  for (size_t i = 0; i < sc->fields.size(); i++) {
+    if (!sc->columns.empty() && std::find(sc->columns.begin(), sc->columns.end(), i) == sc->columns.end())
+      continue;
+    for (std::string &t : TextIndex::tokenize(sc->fields[i], sc->case_sensitive))
+      sc->found.push_back(std::move(t));
+  }
+  bool match = !sc->query.empty();
+  for (const std::string &t : sc->query) {
+    if (std::find(sc->found.begin(), sc->found.end(), t) == sc->found.end()) {
+      match = false;
+      break;
+    }
+  }
+  if (match) {
+    for (size_t i = 0; i < sc->fields.size(); i++)
+      print_field(sc->nulls[i] ? nullptr : &sc->fields[i][0], sc->fields[i].size(), &sc->printer);
+    print_row(c, &sc->printer);
+  }
+  sc->fields.clear();
+  sc->nulls.clear();
+}
+
+static void usage (void) {
+  std::fprintf(stderr,
+               "Usage: csvgrep [-s] [-H] [-c column]... [--index | --reindex] query file\n"
+               "  -s         case-sensitive words\n"
+               "  -H         the first row is a header and is not searched\n"
+               "  -c column  search only this column (0-based), repeatable\n"
+               "  --index    answer from file.csvtxt, building it when missing, stale or\n"
+               "             built with other -s, -H or -c settings\n"
+               "  --reindex  rebuild file.csvtxt first\n");
+}
+
+int
+main (int argc, char *argv[])
+{
+  TextIndexOptions options;
+  bool use_index = false;
+  bool reindex = false;
+  int i;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-s") == 0) {
+      options.case_sensitive = true;
+    } else if (strcmp(argv[i], "-H") == 0) {
+      options.header_row = true;
+    } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      options.columns.push_back(std::strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--index") == 0) {
+      use_index = true;
+    } else if (strcmp(argv[i], "--reindex") == 0) {
+      use_index = reindex = true;
+    } else {
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+  if (argc - i != 2) {
+    usage();
+    return EXIT_FAILURE;
+  }
+  const char *query = argv[i];
+  const std::string path = argv[i + 1];
+
+  try {
+    CsvParser p;
+    p.set_header_row(options.header_row);
+
+    if (use_index) {
+      const std::string index_path = path + ".csvtxt";
+      if (reindex || !TextIndex::is_fresh(index_path, path))
+        TextIndex::build(path, index_path, p, options);
+      TextIndex index = TextIndex::open(index_path, path);
+      if (!index.built_with(options)) {
+        /* Built for other columns, header or case: its answers would differ from a scan */
+        TextIndex::build(path, index_path, p, options);
+        index = TextIndex::open(index_path, path);
+      }
+      Printer printer;
+      index.lookup(p, query, print_field, print_row, &printer);
+      return printer.rows > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::unique_ptr<FILE, FileDeleter> infile(fopen(path.c_str(), "rb"));
+    if (!infile) {
+      std::fprintf(stderr, "Failed to open %s: %s\n", path.c_str(), strerror(errno));
+      return EXIT_FAILURE;
+    }
+    Scan sc;
+    sc.query = TextIndex::tokenize(query, options.case_sensitive);
+    sc.columns = options.columns;
+    sc.case_sensitive = options.case_sensitive;
+    char buf[65536];
+    while (size_t n = fread(buf, 1, sizeof(buf), infile.get())) {
+      p.parse(buf, n, scan_field, scan_row, &sc);
+    }
+    p.finish(scan_field, scan_row, &sc);
+    if (ferror(infile.get())) {
+      std::fprintf(stderr, "Error reading from %s\n", path.c_str());
+      return EXIT_FAILURE;
+    }
+    return sc.printer.rows > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "Exception: %s\n", e.what());
+    return EXIT_FAILURE;
+  }
+}
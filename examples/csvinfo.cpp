@@ -4,6 +4,7 @@ csvinfo - reads CSV data from input file(s) and reports the number
 */
 
 #include "CsvParser.hpp"
+#include "RowCounter.hpp"
 #include <cstdlib>
 #include <cstdio>
 #include <cerrno>
@@ -15,21 +16,6 @@ struct FileDeleter {
   void operator()(FILE* f) const { if (f) std::fclose(f); }
 };
 
-struct counts {
-  long unsigned fields = 0;
-  long unsigned rows = 0;
-};
-
-void cb1 (void *s, size_t len, void *data) { 
-  auto *d = static_cast<counts*>(data);
-  ++d->fields;
-}
-
-void cb2 (int c, void *data) { 
-  auto *d = static_cast<counts*>(data);
-  ++d->rows;
-}
-
 static int is_space(unsigned char c) {
   if (c == CsvParser::CommonDelimiter::Space || 
       c == CsvParser::CommonDelimiter::Tab) 
@@ -56,7 +42,7 @@ main (int argc, char *argv[])
   try {
     std::unique_ptr<FILE, FileDeleter> infile(nullptr);
     CsvParser p;
-    char buf[1024];
+    char buf[65536];
 
     p.set_space_func(is_space);
     p.set_term_func(is_term);
@@ -73,20 +59,21 @@ main (int argc, char *argv[])
         continue;
       }
 
-      counts c;
+      RowCounter counter(p);
 
       while (std::size_t bytes_read = std::fread(buf, 1, sizeof(buf), infile.get())) {
-        p.parse(buf, bytes_read, cb1, cb2, &c);
+        counter.count(buf, bytes_read);
       }
 
-      p.finish(cb1, cb2, &c);
+      RowCounts c = counter.finish();
 
       if (ferror(infile.get())) {
         std::fprintf(stderr, "Error while reading file %s\n", *argv);
         continue;
       }
 
-      std::printf("%s: %lu fields, %lu rows\n", *argv, c.fields, c.rows);
+      std::printf("%s: %lu fields, %lu rows\n", *argv,
+                  static_cast<long unsigned>(c.fields), static_cast<long unsigned>(c.rows));
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,63 @@
+#include "RowBatch.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Batch test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+struct seen {
+  size_t batches = 0;
+  size_t rows = 0;
+  size_t nulls = 0;
+};
+
+static void
+on_batch (const csv::RowBatch &b, void *data)
+{
+  auto *s = static_cast<seen *>(data);
+  s->batches++;
+  s->rows += b.rows();
+  s->nulls += b.validity().null_count();
+
+  if (s->batches == 1) {
+    /* a,,"",d -> field 1 is NULL, field 2 is an empty quoted string */
+    if (b.fields(0) != 4 || !b.field(0, 1).is_null() || b.field(0, 2).is_null() ||
+        b.field(0, 3).view() != "d")
+      fail("validity", "row 0 mismatch");
+    if (b.null_count(0) != 1 || b.validity().test(b.field_index(0, 1)))
+      fail("validity", "row 0 bitmap mismatch");
+    if (reinterpret_cast<uintptr_t>(b.validity().words()) % 64 != 0)
+      fail("validity", "bitmap storage not 64-byte aligned");
+  }
+}
+
+static void
+test_validity (void)
+{
+  const char data[] = "a,,\"\",d\n,,\nx,y\n";
+  csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+  csv::RowBatch batch(2);
+  seen s;
+
+  for (size_t i = 0; i < sizeof(data) - 1; i++)
+    batch.parse(p, data + i, 1, on_batch, &s);
+  batch.finish(p, on_batch, &s);
+
+  if (s.batches != 2 || s.rows != 3)
+    fail("validity", "unexpected batch split");
+  if (s.nulls != 4)
+    fail("validity", "unexpected null count");
+}
+
+int main (void) {
+  test_validity();
+
+  puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include "CsvBinding.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Trade {
+  long ts = 0;
+  double px = 0.0;
+  int qty = -1;
+  std::string venue;
+};
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Binding test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+static void
+test_vector (void)
+{
+  const char data[] = "1,10.5,3,XNAS\n2,\"11.25\",,XLON\n3,12,7";
+  auto binding = csv::bind<Trade>(&Trade::ts, &Trade::px, &Trade::qty, &Trade::venue);
+  std::vector<Trade> trades;
+
+  /* Feed one byte at a time so fields straddle parse() calls */
+  csv::CsvParser p;
+  auto reader = binding.reader(trades);
+  for (size_t i = 0; i < sizeof(data) - 1; i++)
+    reader.parse(p, data + i, 1);
+  reader.finish(p);
+
+  if (trades.size() != 3 || reader.rows() != 3)
+    fail("vector", "unexpected row count");
+  if (trades[0].ts != 1 || trades[0].px != 10.5 || trades[0].qty != 3 || trades[0].venue != "XNAS")
+    fail("vector", "row 0 mismatch");
+  if (trades[1].ts != 2 || trades[1].px != 11.25 || trades[1].qty != -1 || trades[1].venue != "XLON")
+    fail("vector", "row 1 mismatch");
+  if (trades[2].ts != 3 || trades[2].px != 12 || trades[2].qty != 7 || !trades[2].venue.empty())
+    fail("vector", "row 2 mismatch");
+}
+
+static void
+test_range (void)
+{
+  const char data[] = "1,1.5\n2,2.5\n3,3.5\n";
+  auto binding = csv::bind<Trade>(&Trade::ts, &Trade::px);
+  Trade out[2];
+
+  csv::CsvParser p;
+  auto reader = binding.reader(out, 2);
+  reader.parse(p, data, sizeof(data) - 1);
+  reader.finish(p);
+
+  if (reader.rows() != 2 || reader.dropped() != 1)
+    fail("range", "unexpected row count");
+  if (out[1].ts != 2 || out[1].px != 2.5)
+    fail("range", "row 1 mismatch");
+}
+
+static void
+test_convert_error (void)
+{
+  const char data[] = "1,abc\n";
+  auto binding = csv::bind<Trade>(&Trade::ts, &Trade::px);
+  std::vector<Trade> trades;
+
+  csv::CsvParser p;
+  auto reader = binding.reader(trades);
+  try {
+    reader.parse(p, data, sizeof(data) - 1);
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Econvert)
+      fail("convert_error", "wrong error type");
+    return;
+  }
+  fail("convert_error", "expected conversion error");
+}
+
+/* An explicit '+' is accepted, but not in front of a '-' */
+static void
+test_sign (void)
+{
+  long l = 0;
+  double d = 0.0;
+  if (!csv::FieldConverter<long>::convert("+5", 2, l) || l != 5)
+    fail("sign", "\"+5\" rejected");
+  if (!csv::FieldConverter<double>::convert("+1.5", 4, d) || d != 1.5)
+    fail("sign", "\"+1.5\" rejected");
+  if (csv::FieldConverter<long>::convert("+-5", 3, l))
+    fail("sign", "\"+-5\" accepted");
+  if (csv::FieldConverter<double>::convert("+-1.5", 5, d))
+    fail("sign", "\"+-1.5\" accepted");
+  if (csv::FieldConverter<long>::convert("+", 1, l) || csv::FieldConverter<double>::convert("+", 1, d))
+    fail("sign", "lone '+' accepted");
+}
+
+int main (void) {
+  test_vector();
+  test_range();
+  test_convert_error();
+  test_sign();
+
+  puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,227 @@
+#include "CsvCache.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Cache test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+static void
+write_file (const char *path, const std::string &contents)
+{
+  FILE *fp = std::fopen(path, "wb");
+  if (!fp || std::fwrite(contents.data(), 1, contents.size(), fp) != contents.size())
+    fail("setup", "cannot write input file");
+  std::fclose(fp);
+}
+
+static void
+test_roundtrip (void)
+{
+  std::string csv;
+  for (int i = 0; i < 1000; i++) {
+    csv += std::to_string(i) + "," + std::to_string(i * 0.5) + "," + (i % 3 ? "BUY" : "SELL") + "\n";
+  }
+  write_file("test_cache.csv", csv);
+
+  const std::vector<csv::ColumnSpec> columns = {{"id", csv::ColumnType::Int64},
+                                                {"px", csv::ColumnType::Float64},
+                                                {"side", csv::ColumnType::Utf8}};
+  csv::CsvParser p;
+  csv::CsvCache::convert("test_cache.csv", "test_cache.bin", columns, p, 300);
+
+  if (!csv::CsvCache::is_fresh("test_cache.bin", "test_cache.csv"))
+    fail("roundtrip", "cache not fresh after convert");
+
+  csv::CsvCache cache = csv::CsvCache::open("test_cache.bin", "test_cache.csv");
+  if (cache.rows() != 1000 || cache.columns() != 3 || cache.row_groups() < 2)
+    fail("roundtrip", "unexpected shape");
+  if (cache.spec(2).name != "side" || cache.spec(2).type != csv::ColumnType::Utf8)
+    fail("roundtrip", "schema mismatch");
+  if (!cache.verify())
+    fail("roundtrip", "checksum mismatch");
+
+  size_t seen = 0;
+  for (size_t g = 0; g < cache.row_groups(); g++) {
+    csv::ColumnChunk id = cache.chunk(g, 0);
+    csv::ColumnChunk px = cache.chunk(g, 1);
+    csv::ColumnChunk side = cache.chunk(g, 2);
+    if (side.dict_size != 2)
+      fail("roundtrip", "string dictionary not deduplicated");
+    for (size_t r = 0; r < id.rows; r++) {
+      size_t row = cache.row_group_first_row(g) + r;
+      if (!id.is_valid(r) || id.int64_at(r) != static_cast<int64_t>(row) || px.float64_at(r) != row * 0.5)
+        fail("roundtrip", "numeric value mismatch");
+      if (side.string_at(r) != (row % 3 ? "BUY" : "SELL"))
+        fail("roundtrip", "string value mismatch");
+    }
+    seen += id.rows;
+  }
+  if (seen != 1000)
+    fail("roundtrip", "row groups do not cover all rows");
+}
+
+static void
+test_stale (void)
+{
+  write_file("test_cache.csv", "1,2.0,x\n2,3.0,y\n");
+  if (csv::CsvCache::is_fresh("test_cache.bin", "test_cache.csv"))
+    fail("stale", "cache considered fresh after source changed");
+  try {
+    csv::CsvCache::open("test_cache.bin", "test_cache.csv");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("stale", "wrong error type");
+    return;
+  }
+  fail("stale", "stale cache was opened");
+}
+
+/* Rows of a cache as "id|px|side", across row groups */
+static std::vector<std::string>
+dump (const char *cache_path, const char *csv_path)
+{
+  csv::CsvCache cache = csv::CsvCache::open(cache_path, csv_path);
+  if (!cache.verify())
+    fail("refresh", "checksum mismatch");
+  std::vector<std::string> rows;
+  for (size_t g = 0; g < cache.row_groups(); g++) {
+    csv::ColumnChunk id = cache.chunk(g, 0);
+    csv::ColumnChunk px = cache.chunk(g, 1);
+    csv::ColumnChunk side = cache.chunk(g, 2);
+    if (cache.row_group_first_row(g) != rows.size())
+      fail("refresh", "row group numbering broken");
+    for (size_t r = 0; r < id.rows; r++) {
+      rows.push_back(std::to_string(id.int64_at(r)) + "|" + std::to_string(px.float64_at(r)) + "|" +
+                     std::string(side.is_valid(r) ? side.string_at(r) : "NULL"));
+    }
+  }
+  return rows;
+}
+
+static std::string
+refresh_rows (int from, int to)
+{
+  std::string csv;
+  for (int i = from; i < to; i++) {
+    csv += std::to_string(i) + "," + std::to_string(i * 0.25) + "," + (i % 5 ? "\"BUY\"" : "\"SELL,\nX\"") +
+           (i % 2 ? "\n" : "\r\n");
+  }
+  return csv;
+}
+
+/* Refreshes after writing @p csv, then checks the result against a fresh conversion */
+static csv::CsvCache::RefreshStats
+refresh_to (const std::string &csv)
+{
+  const std::vector<csv::ColumnSpec> columns = {{"id", csv::ColumnType::Int64},
+                                                {"px", csv::ColumnType::Float64},
+                                                {"side", csv::ColumnType::Utf8}};
+  write_file("test_cache.csv", csv);
+  /* A same-size rewrite within the mtime granularity must still look changed */
+  std::filesystem::last_write_time("test_cache.csv",
+    std::filesystem::last_write_time("test_cache.csv") + std::chrono::seconds(1));
+
+  csv::CsvParser p;
+  p.set_header_row(true);
+  csv::CsvCache::RefreshStats stats = csv::CsvCache::refresh("test_cache.csv", "test_cache.bin", p);
+  std::vector<std::string> refreshed = dump("test_cache.bin", "test_cache.csv");
+
+  csv::CsvParser q;
+  q.set_header_row(true);
+  csv::CsvCache::convert("test_cache.csv", "test_cache_full.bin", columns, q, 100);
+  if (refreshed != dump("test_cache_full.bin", "test_cache.csv"))
+    fail("refresh", "refreshed cache differs from a fresh conversion");
+  return stats;
+}
+
+static void
+test_refresh (void)
+{
+  const std::vector<csv::ColumnSpec> columns = {{"id", csv::ColumnType::Int64},
+                                                {"px", csv::ColumnType::Float64},
+                                                {"side", csv::ColumnType::Utf8}};
+  const std::string head = "id,px,side\n";
+  std::string csv = head + refresh_rows(0, 2000);
+  write_file("test_cache.csv", csv);
+  csv::CsvParser p;
+  p.set_header_row(true);
+  csv::CsvCache::convert("test_cache.csv", "test_cache.bin", columns, p, 100);
+  if (csv::CsvCache::open("test_cache.bin", "test_cache.csv").row_groups() != 20)
+    fail("refresh", "unexpected row groups");
+
+  csv::CsvCache::RefreshStats stats = csv::CsvCache::refresh("test_cache.csv", "test_cache.bin", p);
+  if (stats.reparsed_groups != 0 || stats.row_groups != 20)
+    fail("refresh", "unchanged source parsed again");
+
+  /* Same-length edit in one row */
+  size_t at = csv.find("\n1234,") + 1;
+  csv[at] = '9';
+  stats = refresh_to(csv);
+  if (stats.reparsed_groups != 1 || stats.row_groups != 20)
+    fail("refresh", "same-length edit parsed more than its group");
+
+  /* A row inserted in the middle shifts everything after it */
+  at = csv.find("\n777,") + 1;
+  csv.insert(at, "5000,1.5,\"NEW\"\n");
+  stats = refresh_to(csv);
+  if (stats.reparsed_groups != 1 || stats.reparsed_bytes > 4096)
+    fail("refresh", "insertion parsed more than its group");
+
+  /* Appended rows reparse the last group only */
+  csv += refresh_rows(2000, 2150);
+  stats = refresh_to(csv);
+  if (stats.reparsed_groups > 3 || stats.row_groups < 21)
+    fail("refresh", "append parsed more than the tail");
+
+  /* An edit to the first data row, and unbalanced quotes that move row boundaries */
+  csv[head.size()] = '7';
+  at = csv.find("\"BUY\"", csv.find("\n1501,"));
+  csv.erase(at + 4, 1);
+  at = csv.find("\"BUY\"", csv.find("\n1521,"));
+  csv.erase(at, 1);
+  stats = refresh_to(csv);
+  if (stats.reparsed_groups < 2 || stats.reparsed_groups > 6)
+    fail("refresh", "unexpected groups parsed for edits");
+
+  /* A quote left open in the last row of a group swallows the next group's first row */
+  {
+    csv::CsvCache cache = csv::CsvCache::open("test_cache.bin", "test_cache.csv");
+    const std::string first = std::to_string(cache.chunk(5, 0).int64_at(0));
+    at = csv.find("\n" + first + ",");
+    csv.erase(at - (csv[at - 1] == '\r' ? 2 : 1), 1);
+  }
+  stats = refresh_to(csv);
+  if (stats.reparsed_groups != 2)
+    fail("refresh", "row boundary change not followed into the next group");
+
+  csv::CsvParser tsv;
+  tsv.set_header_row(true);
+  tsv.set_delimiter('\t');
+  try {
+    (void)csv::CsvCache::refresh("test_cache.csv", "test_cache.bin", tsv);
+    fail("refresh", "parser mismatch accepted");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("refresh", "wrong error type");
+  }
+  std::remove("test_cache_full.bin");
+}
+
+int main (void) {
+  test_roundtrip();
+  test_stale();
+  test_refresh();
+
+  std::remove("test_cache.csv");
+  std::remove("test_cache.bin");
+  puts("All tests passed");
+  return 0;
+}
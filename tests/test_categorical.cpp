@@ -0,0 +1,81 @@
+#include "Categorical.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Categorical test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+enum class Side { Buy, Sell, Unknown };
+
+constexpr std::string_view kSides[] = {"BUY", "SELL"};
+constexpr csv::Categorical<2> sides(kSides);
+
+/* The perfect hash is built during compilation for constexpr sets */
+static_assert(sides.find("SELL") == 1, "compile-time lookup");
+static_assert(sides.find("SEL") == csv::Categorical<2>::unknown, "compile-time unknown");
+
+static void
+test_enum (void)
+{
+  std::string buy = "BUY";
+  if (sides.as<Side>(csv::FieldView(buy.data(), buy.size())) != Side::Buy)
+    fail("enum", "BUY not mapped");
+  if (sides.as<Side>(csv::FieldView("SELL", 4)) != Side::Sell)
+    fail("enum", "SELL not mapped");
+  if (sides.as<Side>(csv::FieldView("buy", 3)) != Side::Unknown)
+    fail("enum", "case-different value not unknown");
+  if (sides.as<Side>(csv::FieldView()) != Side::Unknown)
+    fail("enum", "null field not unknown");
+}
+
+static void
+test_runtime_set (void)
+{
+  /* Status codes sharing long prefixes, built at run time */
+  const std::string_view codes[] = {"STATUS_PENDING_REVIEW", "STATUS_PENDING_RETRY", "STATUS_FAILED",
+                                    "STATUS_DONE", "N", "Y", "false", "true"};
+  csv::Categorical<8> status(codes);
+  for (size_t i = 0; i < 8; i++) {
+    if (status.find(codes[i]) != i)
+      fail("runtime_set", "declared value not found");
+  }
+  if (status.find("STATUS_PENDING_REVIEX") != status.unknown)
+    fail("runtime_set", "near miss not unknown");
+  if (status.find("") != status.unknown)
+    fail("runtime_set", "empty field not unknown");
+}
+
+/* Long values that differ only in the middle */
+constexpr std::string_view kAccounts[] = {"ACCOUNT_STATUS_OPEN_PENDING", "ACCOUNT_STATUS_SHUT_PENDING"};
+constexpr csv::Categorical<2> accounts(kAccounts);
+static_assert(accounts.find("ACCOUNT_STATUS_SHUT_PENDING") == 1, "compile-time middle difference");
+
+static void
+test_long_values (void)
+{
+  const std::string_view codes[] = {"ACCOUNT_STATUS_OPEN_PENDING_REVIEW_QUEUE",
+                                    "ACCOUNT_STATUS_SHUT_PENDING_REVIEW_QUEUE",
+                                    "ACCOUNT_STATUS_OPEN_CLOSING_REVIEW_QUEUE",
+                                    "ACCOUNT_STATUS_SHUT_CLOSING_REVIEW_QUEUE"};
+  csv::Categorical<4> status(codes);
+  for (size_t i = 0; i < 4; i++) {
+    if (status.find(codes[i]) != i)
+      fail("long_values", "declared value not found");
+  }
+  if (status.find("ACCOUNT_STATUS_HALT_PENDING_REVIEW_QUEUE") != status.unknown)
+    fail("long_values", "middle near miss not unknown");
+}
+
+int main (void) {
+  test_enum();
+  test_runtime_set();
+  test_long_values();
+
+  puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,208 @@
+#include "RowFilter.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Checkpoint"
+#include "test_fixture.hpp"
+
+/* Checkpoints after every prefix of kCsv and resumes in a fresh parser */
+static void
+check_every_split (const char *name, const Setup &setup)
+{
+  Output whole;
+  run(setup, kCsv, kCsv.size(), whole);
+
+  for (size_t k = 0; k <= kCsv.size(); k++) {
+    Output out;
+    std::string state;
+    {
+      csv::CsvParser first;
+      setup(first);
+      first.parse(kCsv.data(), k, field_cb, row_cb, &out);
+      state = first.checkpoint(k, out.rows);
+    }
+    csv::CsvParser second;
+    setup(second);
+    const csv::CsvParser::ResumePoint at = second.restore(state);
+    if (at.offset != k || at.row != out.rows)
+      fail(name, "offset or row not restored");
+    second.parse(kCsv.data() + at.offset, kCsv.size() - at.offset, field_cb, row_cb, &out);
+    second.finish(field_cb, row_cb, &out);
+    if (out.text != whole.text) {
+      std::fprintf(stderr, "split at %zu:\n%s\nexpected:\n%s\n", k, out.text.c_str(), whole.text.c_str());
+      fail(name, "resumed output differs");
+    }
+  }
+}
+
+static void
+test_splits (void)
+{
+  check_every_split("plain", [](csv::CsvParser &) {});
+  check_every_split("options", [](csv::CsvParser &p) {
+    p.set_options({csv::CsvParser::Option::RepAllNl, csv::CsvParser::Option::AppendNull,
+                   csv::CsvParser::Option::EmptyIsNull});
+  });
+  check_every_split("header", [](csv::CsvParser &p) {
+    p.set_header_row(true);
+    p.set_named_projection({"note", "id"});
+  });
+  /* The filter holds back the fields before "qty" until it is tested */
+  check_every_split("filter", [](csv::CsvParser &p) {
+    p.set_header_row(true);
+    p.set_filter(csv::RowFilter().int_range("qty", 15, 45));
+  });
+  check_every_split("block size", [](csv::CsvParser &p) { p.set_block_size(4); });
+  check_every_split("runs", [](csv::CsvParser &p) { p.set_engine(csv::CsvParser::Engine::Runs); });
+  check_every_split("runs projection", [](csv::CsvParser &p) {
+    p.set_engine(csv::CsvParser::Engine::Runs);
+    p.set_projection({0, 3});
+  });
+}
+
+static void
+test_counters (void)
+{
+  const std::string csv = "a,1\nb,2\nc,3\nd,4\n";
+  csv::CsvParser p;
+  p.set_filter(csv::RowFilter().equals(0, "c"));
+  Output out;
+  p.parse(csv.data(), 10, field_cb, row_cb, &out);
+  const std::string state = p.checkpoint(1000010, 7);
+
+  csv::CsvParser q;
+  q.set_filter(csv::RowFilter().equals(0, "c"));
+  q.restore(state);
+  if (q.rows_filtered() != 2)
+    fail("counters", "rejected rows not restored");
+  q.parse(csv.data() + 10, csv.size() - 10, field_cb, row_cb, &out);
+  q.finish(field_cb, row_cb, &out);
+  if (out.text != "[c][3]/10\n" || q.rows_filtered() != 3)
+    fail("counters", "wrong rows after resume");
+}
+
+/* A checkpoint taken right after a delimiter carries an empty field, which finish() must still deliver */
+static void
+test_empty_field (void)
+{
+  for (const bool append_null : {false, true}) {
+    std::vector<csv::CsvParser::Option> options;
+    if (append_null) options.push_back(csv::CsvParser::Option::AppendNull);
+
+    Output whole;
+    {
+      csv::CsvParser p(options);
+      p.parse("x,", 2, field_cb, row_cb, &whole);
+      p.finish(field_cb, row_cb, &whole);
+    }
+
+    Output out;
+    csv::CsvParser p(options);
+    p.parse("x,", 2, field_cb, row_cb, &out);
+    const std::string state = p.checkpoint(2, 0);
+    csv::CsvParser q(options);
+    q.restore(state);
+    q.finish(field_cb, row_cb, &out);
+    if (out.text != whole.text || out.text != "[x][]/-1\n")
+      fail("empty field", append_null ? "wrong output with AppendNull" : "wrong output");
+  }
+}
+
+static void
+expect_invalid (const char *name, csv::CsvParser &p, const std::string &state)
+{
+  try {
+    p.restore(state);
+    fail(name, "bad checkpoint accepted");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail(name, "wrong error type");
+  }
+}
+
+/* Offsets of tokenizer fields in the checkpoint header */
+enum { kSpacesAt = 32, kEntryPosAt = 40, kPstateAt = 72, kQuotedAt = 76, kStatusAt = 80 };
+
+template <typename T>
+static std::string
+patched (std::string state, size_t at, T value)
+{
+  std::memcpy(&state[at], &value, sizeof(value));
+  return state;
+}
+
+static std::string
+state_after (const char *input)
+{
+  csv::CsvParser p;
+  p.parse(input, std::strlen(input), nullptr, nullptr, nullptr);
+  return p.checkpoint(std::strlen(input), 0);
+}
+
+/* Tokenizer states csv_parse() never leaves are rejected before they reach the parser */
+static void
+test_corrupt_state (void)
+{
+  const std::string field = state_after("ab");         /* unquoted field, 2 bytes */
+  const std::string between = state_after("a,");       /* no field begun */
+  const std::string closed = state_after("\"ab\"");  /* quoted field, may have ended */
+  std::uint64_t closed_pos;
+  std::memcpy(&closed_pos, closed.data() + kEntryPosAt, sizeof(closed_pos));
+
+  csv::CsvParser p;
+  for (const std::string *state : {&field, &between, &closed}) p.restore(*state);
+
+  expect_invalid("spaces", p, patched(field, kSpacesAt, std::uint64_t{3}));
+  expect_invalid("spaces", p, patched(patched(field, kSpacesAt, std::uint64_t{100}), kPstateAt, std::int32_t{3}));
+  expect_invalid("spaces", p, patched(closed, kSpacesAt, closed_pos));
+  expect_invalid("spaces", p, patched(between, kSpacesAt, std::uint64_t{1}));
+  expect_invalid("quoted", p, patched(field, kQuotedAt, std::int32_t{2}));
+  expect_invalid("quoted", p, patched(field, kQuotedAt, std::int32_t{-1}));
+  expect_invalid("quoted", p, patched(between, kQuotedAt, std::int32_t{1}));
+  expect_invalid("quoted", p, patched(closed, kQuotedAt, std::int32_t{0}));
+  expect_invalid("status", p, patched(field, kStatusAt, std::int32_t{1}));  /* CSV_EPARSE */
+  expect_invalid("status", p, patched(field, kStatusAt, std::int32_t{42}));
+}
+
+static void
+test_invalid (void)
+{
+  csv::CsvParser p;
+  p.parse("x,\"partial", 10, nullptr, nullptr, nullptr);
+  const std::string state = p.checkpoint(10, 0);
+
+  csv::CsvParser tsv;
+  tsv.set_delimiter('\t');
+  expect_invalid("config", tsv, state);
+  csv::CsvParser strict({csv::CsvParser::Option::Strict});
+  expect_invalid("config", strict, state);
+  csv::CsvParser projected;
+  projected.set_projection({1});
+  expect_invalid("projection", projected, state);
+
+  csv::CsvParser q;
+  expect_invalid("garbage", q, "not a checkpoint");
+  expect_invalid("truncated", q, state.substr(0, state.size() - 1));
+  expect_invalid("trailing", q, state + "x");
+
+  /* A rejected checkpoint leaves the parser usable */
+  Output out;
+  q.parse("1,2\n", 4, field_cb, row_cb, &out);
+  if (out.text != "[1][2]/10\n")
+    fail("invalid", "parser disturbed by a rejected checkpoint");
+}
+
+int
+main (void)
+{
+  test_splits();
+  test_counters();
+  test_empty_field();
+  test_invalid();
+  test_corrupt_state();
+  std::puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,153 @@
+#include "ColumnBuilder.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Column test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+static bool
+is_valid (const ArrowArray *a, int64_t i)
+{
+  const uint8_t *bits = static_cast<const uint8_t *>(a->buffers[0]);
+  return (bits[i / 8] >> (i % 8)) & 1;
+}
+
+static void
+test_arrow_export (void)
+{
+  const char data[] = "1,1.5,true,abc\n,2.5,0,\"d,e\"\n3,,1\n";
+  csv::ColumnBuilder builder({{"id", csv::ColumnType::Int64},
+                              {"px", csv::ColumnType::Float64},
+                              {"ok", csv::ColumnType::Bool},
+                              {"name", csv::ColumnType::Utf8}});
+  csv::CsvParser p;
+  builder.parse(p, data, sizeof(data) - 1);
+  builder.finish(p);
+  if (builder.rows() != 3)
+    fail("arrow_export", "unexpected row count");
+
+  ArrowArray array;
+  ArrowSchema schema;
+  builder.export_arrow(&array, &schema);
+
+  if (std::strcmp(schema.format, "+s") != 0 || schema.n_children != 4)
+    fail("arrow_export", "bad struct schema");
+  if (std::strcmp(schema.children[3]->format, "u") != 0 ||
+      std::strcmp(schema.children[3]->name, "name") != 0)
+    fail("arrow_export", "bad child schema");
+  if (array.length != 3 || array.n_children != 4)
+    fail("arrow_export", "bad struct array");
+
+  const ArrowArray *id = array.children[0];
+  const int64_t *ids = static_cast<const int64_t *>(id->buffers[1]);
+  if (id->null_count != 1 || is_valid(id, 1) || ids[0] != 1 || ids[2] != 3)
+    fail("arrow_export", "int64 column mismatch");
+
+  const ArrowArray *px = array.children[1];
+  const double *pxs = static_cast<const double *>(px->buffers[1]);
+  if (px->null_count != 1 || !is_valid(px, 1) || is_valid(px, 2) || pxs[1] != 2.5)
+    fail("arrow_export", "float64 column mismatch");
+
+  const ArrowArray *ok = array.children[2];
+  const uint8_t *oks = static_cast<const uint8_t *>(ok->buffers[1]);
+  if (ok->null_count != 0 || oks[0] != 0x5)
+    fail("arrow_export", "bool column mismatch");
+
+  const ArrowArray *name = array.children[3];
+  const int32_t *offsets = static_cast<const int32_t *>(name->buffers[1]);
+  const char *chars = static_cast<const char *>(name->buffers[2]);
+  if (name->null_count != 1 || is_valid(name, 2) || offsets[1] != 3 || offsets[2] != 6 ||
+      std::memcmp(chars, "abcd,e", 6) != 0)
+    fail("arrow_export", "utf8 column mismatch");
+
+  array.release(&array);
+  schema.release(&schema);
+  if (array.release != nullptr || schema.release != nullptr)
+    fail("arrow_export", "release did not mark structs as released");
+  if (builder.rows() != 0)
+    fail("arrow_export", "builder not reset after export");
+}
+
+static void
+test_export_mid_row (void)
+{
+  const char part1[] = "1,abc\n2,d";
+  const char part2[] = "ef\n";
+  csv::ColumnBuilder builder({{"id", csv::ColumnType::Int64},
+                              {"name", csv::ColumnType::Utf8}});
+  csv::CsvParser p;
+  ArrowArray array;
+  ArrowSchema schema;
+
+  /* "2" has been submitted but its row has not ended yet */
+  builder.parse(p, part1, sizeof(part1) - 1);
+  builder.export_arrow(&array, &schema);
+  if (array.length != 1 || array.children[0]->length != 1 || array.children[1]->length != 1)
+    fail("export_mid_row", "partial row leaked into first batch");
+  array.release(&array);
+  schema.release(&schema);
+
+  builder.parse(p, part2, sizeof(part2) - 1);
+  builder.finish(p);
+  builder.export_arrow(&array, &schema);
+  const int64_t *ids = static_cast<const int64_t *>(array.children[0]->buffers[1]);
+  const char *chars = static_cast<const char *>(array.children[1]->buffers[2]);
+  if (array.length != 1 || ids[0] != 2 || std::memcmp(chars, "def", 3) != 0)
+    fail("export_mid_row", "partial row not carried into second batch");
+  array.release(&array);
+  schema.release(&schema);
+}
+
+static void
+test_convert_error (void)
+{
+  const char data[] = "x\n";
+  csv::ColumnBuilder builder({{"id", csv::ColumnType::Int64}});
+  csv::CsvParser p;
+  try {
+    builder.parse(p, data, sizeof(data) - 1);
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Econvert)
+      fail("convert_error", "wrong error type");
+    return;
+  }
+  fail("convert_error", "expected conversion error");
+}
+
+/* int32 offsets address 2 GiB - 1 bytes of Utf8 data, so the 2048th row of 1 MiB fails the column */
+static void
+test_utf8_limit (void)
+{
+  const std::string row = std::string(size_t{1} << 20, 'x') + "\n";
+  csv::ColumnBuilder builder({{"text", csv::ColumnType::Utf8}});
+  csv::CsvParser p;
+  p.set_engine(csv::CsvParser::Engine::Runs);  // copies each row as one run
+  for (size_t r = 0; r < 2048; r++) {
+    try {
+      builder.parse(p, row.data(), row.size());
+    } catch (const csv::CsvError &e) {
+      if (e.type != csv::CsvError::ErrorType::Econvert)
+        fail("utf8_limit", "wrong error type");
+      if (r != 2047 || std::strstr(e.what(), "row 2047") == nullptr)
+        fail("utf8_limit", "wrong row reported");
+      return;
+    }
+  }
+  fail("utf8_limit", "expected conversion error past 2 GiB");
+}
+
+int main (void) {
+  test_arrow_export();
+  test_export_mid_row();
+  test_convert_error();
+  test_utf8_limit();
+
+  puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,204 @@
+#include "RowCounter.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Count test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+/* What a CsvParser or RowCounter run produced */
+struct Result {
+  csv::RowCounts counts;
+  size_t fields_in_row = 0;
+  std::string error;
+  size_t error_at = 0;
+};
+
+static void
+cb1 (void *, size_t, void *data)
+{
+  Result *r = static_cast<Result *>(data);
+  ++r->counts.fields;
+  ++r->fields_in_row;
+}
+
+static void
+cb2 (int, void *data)
+{
+  Result *r = static_cast<Result *>(data);
+  size_t w = r->fields_in_row;
+  if (++r->counts.rows == 1 || w < r->counts.min_fields) r->counts.min_fields = w;
+  if (w > r->counts.max_fields) r->counts.max_fields = w;
+  r->fields_in_row = 0;
+}
+
+static Result
+run_parser (csv::CsvParser &p, const std::string &input, size_t chunk)
+{
+  Result r;
+  try {
+    for (size_t off = 0; off < input.size(); off += chunk) {
+      size_t n = input.size() - off < chunk ? input.size() - off : chunk;
+      p.parse(input.data() + off, n, cb1, cb2, &r);
+    }
+    p.finish(cb1, cb2, &r);
+  } catch (const csv::CsvError &e) {
+    r.error = e.what();
+    r.error_at = e.bytes_parsed;
+  } catch (const std::exception &e) {
+    r.error = e.what();
+  }
+  r.fields_in_row = 0;
+  return r;
+}
+
+static Result
+run_counter (const csv::CsvParser &p, const std::string &input, size_t chunk)
+{
+  Result r;
+  csv::RowCounter counter(p, true);
+  try {
+    for (size_t off = 0; off < input.size(); off += chunk) {
+      size_t n = input.size() - off < chunk ? input.size() - off : chunk;
+      counter.count(input.data() + off, n);
+    }
+    r.counts = counter.finish();
+  } catch (const csv::CsvError &e) {
+    r.error = e.what();
+    r.error_at = e.bytes_parsed;
+  } catch (const std::exception &e) {
+    r.error = e.what();
+  }
+  return r;
+}
+
+static bool
+same (const Result &a, const Result &b)
+{
+  if (a.error != b.error || a.error_at != b.error_at) return false;
+  if (!a.error.empty()) return true;
+  return a.counts.rows == b.counts.rows && a.counts.fields == b.counts.fields &&
+         a.counts.min_fields == b.counts.min_fields && a.counts.max_fields == b.counts.max_fields;
+}
+
+/* Random documents biased towards the cases that leave the fast path */
+static std::string
+random_document (std::mt19937 &rng, char delim)
+{
+  static const char *const pieces[] = {
+    "abc", "12", "x", " ", "\t", "\"", "\"\"", "\"q\"", "\"a,b\"", "\"line\nbreak\"",
+    " \"spaced\" ", "\"q\"x", "a\"b", "\r\n", "\n", "\r", "\n\n", "  \n", "", "\"\"\"",
+  };
+  std::uniform_int_distribution<size_t> len(0, 120);
+  std::uniform_int_distribution<size_t> pick(0, sizeof(pieces) / sizeof(pieces[0]));
+  std::string doc;
+  for (size_t i = len(rng); i > 0; --i) {
+    size_t k = pick(rng);
+    if (k == sizeof(pieces) / sizeof(pieces[0])) doc += delim;
+    else doc += pieces[k];
+  }
+  return doc;
+}
+
+/* make() configures a fresh parser per run: a parse error leaves one mid-row */
+template <class Make>
+static void
+check (const char *name, Make make, const std::string &input)
+{
+  for (size_t chunk : {size_t{1}, size_t{7}, size_t{64}, size_t{100}, input.size() + 1}) {
+    csv::CsvParser p;
+    make(p);
+    Result expected = run_parser(p, input, chunk);
+    csv::CsvParser q;
+    make(q);
+    if (!same(expected, run_counter(q, input, chunk)))
+      fail(name, ("counts differ for input \"" + input + "\"").c_str());
+  }
+}
+
+static void
+test_fuzz (void)
+{
+  using O = csv::CsvParser::Option;
+  std::mt19937 rng(20261017);
+  for (int round = 0; round < 3000; ++round) {
+    std::string doc = random_document(rng, ',');
+    check("default", [](csv::CsvParser &) {}, doc);
+    check("strict", [](csv::CsvParser &p) { p.set_options({O::Strict}); }, doc);
+    check("strict_fini", [](csv::CsvParser &p) { p.set_options({O::Strict, O::StrictFini}); }, doc);
+    check("repall", [](csv::CsvParser &p) { p.set_options({O::RepAllNl}); }, doc);
+    check("tsv", [](csv::CsvParser &p) { p.set_delimiter('\t'); }, random_document(rng, '\t'));
+  }
+}
+
+static void
+test_long_rows (void)
+{
+  /* Plain data that stays on the block path end to end */
+  std::string doc;
+  for (int i = 0; i < 500; ++i) {
+    doc += std::to_string(i) + ",\"name " + std::to_string(i) + "\",\"a \"\"b\"\"\"";
+    for (int j = 0; j < i % 5; ++j) doc += ",x";
+    doc += i % 3 ? "\n" : "\r\n";
+  }
+  check("long_rows", [](csv::CsvParser &) {}, doc);
+
+  csv::CsvParser p;
+  csv::RowCounter counter(p, true);
+  counter.count(doc.data(), doc.size());
+  csv::RowCounts c = counter.finish();
+  if (c.rows != 500 || c.min_fields != 3 || c.max_fields != 7)
+    fail("long_rows", "unexpected totals");
+}
+
+static int
+comma_only (unsigned char c)
+{
+  return c == ',';
+}
+
+static void
+test_custom_classes (void)
+{
+  /* A space function that differs from the default disables the block path */
+  std::string doc;
+  for (int i = 0; i < 50; ++i) doc += "a, b ,\"c\" , d\n";
+  check("custom_classes", [](csv::CsvParser &p) {
+    p.set_space_func(comma_only);
+    p.set_delimiter(';');
+  }, doc);
+}
+
+static void
+test_reset (void)
+{
+  csv::CsvParser p;
+  csv::RowCounter counter(p);
+  counter.count("a,b\nc", 5);
+  if (counter.counts().rows != 1 || counter.counts().fields != 2)
+    fail("reset", "unexpected running totals");
+  csv::RowCounts c = counter.finish();
+  if (c.rows != 2 || c.fields != 3)
+    fail("reset", "final row not counted");
+  counter.count("x\n", 2);
+  c = counter.finish();
+  if (c.rows != 1 || c.fields != 1)
+    fail("reset", "counter not reset by finish");
+}
+
+int
+main (void)
+{
+  test_fuzz();
+  test_long_rows();
+  test_custom_classes();
+  test_reset();
+  puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,39 @@
+# csvgrep --index must print what a scan prints under the same -s, -H and -c
+# settings. The runs share one .csvtxt sidecar, so one built with other
+# settings has to be rebuilt rather than reused.
+#
+#   cmake -DCSVGREP=<csvgrep> -DWORK_DIR=<dir> -P test_csvgrep.cmake
+
+set(csv "${WORK_DIR}/test_csvgrep.csv")
+file(WRITE "${csv}"
+  "id,Gateway,note\n"
+  "1,gateway timeout,disk full\n"
+  "2,Gateway retry,\"gateway, again\"\n"
+  "3,ok,Gateway down\n"
+  "4,GATEWAY,\n")
+file(REMOVE "${csv}.csvtxt")
+
+set(runs
+  "gateway"
+  "-c 1 gateway"
+  "-s Gateway"
+  "-H gateway"
+  "-H -c 2 gateway"
+  "-s -H -c 2 -c 1 Gateway"
+  "-c 2 -c 1 -s -H Gateway"
+  "gateway")
+
+foreach(run IN LISTS runs)
+  separate_arguments(args UNIX_COMMAND "${run}")
+  execute_process(COMMAND "${CSVGREP}" ${args} "${csv}"
+                  OUTPUT_VARIABLE scan_out RESULT_VARIABLE scan_rc)
+  execute_process(COMMAND "${CSVGREP}" --index ${args} "${csv}"
+                  OUTPUT_VARIABLE index_out RESULT_VARIABLE index_rc)
+  if(NOT scan_out STREQUAL index_out OR NOT scan_rc STREQUAL index_rc)
+    message(FATAL_ERROR "csvgrep test '${run}' failed: --index printed\n${index_out}(${index_rc})\n"
+                        "but the scan printed\n${scan_out}(${scan_rc})")
+  endif()
+endforeach()
+
+file(REMOVE "${csv}" "${csv}.csvtxt")
+message(STATUS "All tests passed")
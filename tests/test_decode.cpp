@@ -0,0 +1,176 @@
+#include "BlobDecoder.hpp"
+#include "CsvParser.hpp"
+#include "FieldView.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Decode test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+/* Reference encoders, long enough inputs exercise the vector paths */
+static std::string
+to_hex (const std::vector<unsigned char> &bytes, bool upper)
+{
+  const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  std::string s;
+  for (unsigned char b : bytes) {
+    s += digits[b >> 4];
+    s += digits[b & 15];
+  }
+  return s;
+}
+
+static std::string
+to_base64 (const std::vector<unsigned char> &bytes)
+{
+  static const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string s;
+  size_t i = 0;
+  for (; i + 3 <= bytes.size(); i += 3) {
+    unsigned v = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+    s += alphabet[v >> 18];
+    s += alphabet[(v >> 12) & 63];
+    s += alphabet[(v >> 6) & 63];
+    s += alphabet[v & 63];
+  }
+  if (bytes.size() - i == 1) {
+    unsigned v = bytes[i] << 16;
+    s += alphabet[v >> 18];
+    s += alphabet[(v >> 12) & 63];
+    s += "==";
+  } else if (bytes.size() - i == 2) {
+    unsigned v = (bytes[i] << 16) | (bytes[i + 1] << 8);
+    s += alphabet[v >> 18];
+    s += alphabet[(v >> 12) & 63];
+    s += alphabet[(v >> 6) & 63];
+    s += '=';
+  }
+  return s;
+}
+
+static std::vector<unsigned char>
+sample (size_t n)
+{
+  std::vector<unsigned char> v(n);
+  for (size_t i = 0; i < n; ++i) v[i] = static_cast<unsigned char>(i * 131 + 7);
+  return v;
+}
+
+template <typename F>
+static bool
+throws_convert (F f)
+{
+  try {
+    f();
+  } catch (const csv::CsvError &e) {
+    return e.type == csv::CsvError::ErrorType::Econvert;
+  }
+  return false;
+}
+
+static void
+test_hex (void)
+{
+  for (size_t n = 0; n < 100; ++n) {
+    std::vector<unsigned char> bytes = sample(n);
+    std::string text = to_hex(bytes, n % 2 == 1);
+    std::vector<unsigned char> out(n + 1);
+    csv::FieldView f(text.data(), text.size());
+    if (f.decode_hex(out.data(), out.size()) != n || std::memcmp(out.data(), bytes.data(), n) != 0)
+      fail("hex", "roundtrip mismatch");
+  }
+
+  std::string bad = to_hex(sample(40), false);
+  bad[37] = 'g';  /* inside the first vector block */
+  unsigned char out[64];
+  if (!throws_convert([&] { csv::FieldView(bad.data(), bad.size()).decode_hex(out, sizeof(out)); }))
+    fail("hex", "invalid digit accepted");
+  if (!throws_convert([&] { csv::FieldView("abc", 3).decode_hex(out, sizeof(out)); }))
+    fail("hex", "odd length accepted");
+}
+
+static void
+test_base64 (void)
+{
+  for (size_t n = 0; n < 100; ++n) {
+    std::vector<unsigned char> bytes = sample(n);
+    std::string text = to_base64(bytes);
+    std::vector<unsigned char> out(n + 3);
+    csv::FieldView f(text.data(), text.size());
+    if (f.decode_base64(out.data(), out.size()) != n || std::memcmp(out.data(), bytes.data(), n) != 0)
+      fail("base64", "roundtrip mismatch");
+
+    /* Unpadded input decodes to the same bytes */
+    while (!text.empty() && text.back() == '=') text.pop_back();
+    f = csv::FieldView(text.data(), text.size());
+    if (f.decode_base64(out.data(), out.size()) != n || std::memcmp(out.data(), bytes.data(), n) != 0)
+      fail("base64", "unpadded roundtrip mismatch");
+  }
+
+  unsigned char out[64];
+  std::string bad = to_base64(sample(30));
+  bad[5] = '-';
+  if (!throws_convert([&] { csv::FieldView(bad.data(), bad.size()).decode_base64(out, sizeof(out)); }))
+    fail("base64", "invalid character accepted");
+  std::string early = "QQ==" + to_base64(sample(30));
+  if (!throws_convert([&] { csv::FieldView(early.data(), early.size()).decode_base64(out, sizeof(out)); }))
+    fail("base64", "data after padding accepted");
+  if (!throws_convert([&] { csv::FieldView("QUJDR", 5).decode_base64(out, sizeof(out)); }))
+    fail("base64", "dangling character accepted");
+
+  try {
+    std::string text = to_base64(sample(30));
+    csv::FieldView(text.data(), text.size()).decode_base64(out, 10);
+    fail("base64", "short output buffer accepted");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid) fail("base64", "wrong error for short buffer");
+  }
+}
+
+static void
+test_streaming (void)
+{
+  /* A large blob fed in odd-sized pieces through a small fixed buffer */
+  std::vector<unsigned char> bytes = sample(100000);
+  std::string hex = to_hex(bytes, false);
+  std::string b64 = to_base64(bytes);
+  unsigned char buf[64];
+  std::vector<unsigned char> decoded;
+
+  csv::HexDecoder hd;
+  for (size_t pos = 0; pos < hex.size(); pos += 37) {
+    size_t len = std::min<size_t>(37, hex.size() - pos);
+    size_t n = hd.update(hex.data() + pos, len, buf, sizeof(buf));
+    decoded.insert(decoded.end(), buf, buf + n);
+  }
+  hd.finish();
+  if (decoded != bytes) fail("streaming", "hex mismatch");
+
+  decoded.clear();
+  csv::Base64Decoder bd;
+  for (size_t pos = 0; pos < b64.size(); pos += 41) {
+    size_t len = std::min<size_t>(41, b64.size() - pos);
+    size_t n = bd.update(b64.data() + pos, len, buf, sizeof(buf));
+    decoded.insert(decoded.end(), buf, buf + n);
+  }
+  size_t n = bd.finish(buf, sizeof(buf));
+  decoded.insert(decoded.end(), buf, buf + n);
+  if (decoded != bytes) fail("streaming", "base64 mismatch");
+}
+
+int
+main (void)
+{
+  test_hex();
+  test_base64();
+  test_streaming();
+  std::puts("All tests passed");
+  return 0;
+}
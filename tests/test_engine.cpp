@@ -0,0 +1,190 @@
+#include "CsvParser.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Engine"
+#include "test_fixture.hpp"
+
+/* Output, bytes consumed, error and buffer size of one run split after @p k bytes */
+static std::string
+run_engine (const Setup &setup, csv::CsvParser::Engine engine, const std::string &input, size_t k,
+            bool append_null)
+{
+  Output out;
+  out.append_null = append_null;
+  const std::string text = run([&](csv::CsvParser &p) {
+    setup(p);
+    p.set_engine(engine);
+  }, input, k, out);
+  return text + "<buffer " + std::to_string(out.buffer_size) + ">";
+}
+
+/* Every engine matches csv_parse() whatever the chunk boundary */
+static void
+check_engines (const char *name, const Setup &setup, bool append_null = false,
+               const std::string &input = kCsv)
+{
+  using Engine = csv::CsvParser::Engine;
+  for (size_t k = 0; k <= input.size(); k++) {
+    const std::string expected = run_engine(setup, Engine::Libcsv, input, k, append_null);
+    for (const Engine engine : {Engine::Runs, Engine::Simd, Engine::Auto}) {
+      const std::string actual = run_engine(setup, engine, input, k, append_null);
+      if (actual != expected) {
+        std::fprintf(stderr, "engine %d, split at %zu:\n%s\nexpected:\n%s\n", static_cast<int>(engine), k,
+                     actual.c_str(), expected.c_str());
+        fail(name, "output differs from csv_parse()");
+      }
+    }
+  }
+}
+
+static int
+is_pipe_or_space (unsigned char c)
+{
+  return c == ' ' || c == '|';
+}
+
+static int
+is_semicolon (unsigned char c)
+{
+  return c == ';';
+}
+
+/* Fails past 256 bytes, like an allocator out of memory */
+static void *
+capped_realloc (void *p, size_t size)
+{
+  return size > 256 ? nullptr : std::realloc(p, size);
+}
+
+static void
+test_parity (void)
+{
+  using Option = csv::CsvParser::Option;
+  check_engines("plain", [](csv::CsvParser &) {});
+  check_engines("options", [](csv::CsvParser &p) {
+    p.set_options({Option::RepAllNl, Option::EmptyIsNull});
+  });
+  check_engines("append_null", [](csv::CsvParser &p) {
+    p.set_options({Option::AppendNull});
+  }, true);
+  check_engines("strict", [](csv::CsvParser &p) {
+    p.set_options({Option::Strict, Option::StrictFini});
+  });
+  check_engines("blocks", [](csv::CsvParser &p) {
+    p.set_block_size(3);
+    p.set_options({Option::AppendNull});
+  }, true);
+  check_engines("classes", [](csv::CsvParser &p) {
+    p.set_space_func(is_pipe_or_space);
+    p.set_term_func(is_semicolon);
+  }, false, "a|b ,|c| |;\"x|;y\" | ;d|||;");
+  check_engines("header", [](csv::CsvParser &p) {
+    p.set_header_row(true);
+    p.set_named_projection({"note", "id"});
+  });
+  check_engines("out_of_memory", [](csv::CsvParser &p) {
+    p.set_block_size(16);
+    p.set_realloc_func(capped_realloc);
+  });
+  if (run_engine([](csv::CsvParser &p) { p.set_realloc_func(capped_realloc); },
+                 csv::CsvParser::Engine::Runs, kCsv, 0, false).find("<error 2 at ") == std::string::npos)
+    fail("out_of_memory", "field larger than the allocator allows accepted");
+}
+
+/* Both engines share the parser state, so switching mid-document is seamless */
+static void
+test_switch (void)
+{
+  Output expected;
+  {
+    csv::CsvParser p;
+    p.parse(kCsv.data(), kCsv.size(), field_cb, row_cb, &expected);
+    p.finish(field_cb, row_cb, &expected);
+  }
+  for (size_t k = 0; k <= kCsv.size(); k++) {
+    Output out;
+    csv::CsvParser p;
+    if (p.get_engine() != csv::CsvParser::Engine::Libcsv)
+      fail("switch", "wrong default engine");
+    p.parse(kCsv.data(), k, field_cb, row_cb, &out);
+    p.set_engine(csv::CsvParser::Engine::Runs);
+    p.parse(kCsv.data() + k, kCsv.size() - k, field_cb, row_cb, &out);
+    p.set_engine(csv::CsvParser::Engine::Libcsv);
+    p.finish(field_cb, row_cb, &out);
+    if (out.text != expected.text)
+      fail("switch", "output differs after switching engines");
+  }
+}
+
+static void
+parse_chunks (csv::CsvParser &p, const std::string &input, size_t chunk)
+{
+  Output out;
+  for (size_t at = 0; at < input.size(); at += chunk) {
+    p.parse(input.data() + at, std::min(chunk, input.size() - at), field_cb, row_cb, &out);
+  }
+  p.finish(field_cb, row_cb, &out);
+}
+
+/* Engine::Auto follows the data, block by block, and reports what it ran */
+static void
+test_auto (void)
+{
+  using Engine = csv::CsvParser::Engine;
+  const size_t block = csv::CsvParser::auto_block_size();
+
+  /* 8 blocks, then 16 each: every part includes a monitored block */
+  std::string digits, words, quoted;
+  while (digits.size() < 8 * block) digits += "1,2,3,4,5,6,7,8\n";
+  while (words.size() < 16 * block) words += "alphabet soup,quick brown fox,lazy dog jumps\n";
+  while (quoted.size() < 16 * block) quoted += "\"alphabet soup\",\"quick, brown fox\"\n";
+
+  csv::CsvParser p;
+  p.set_engine(Engine::Auto);
+  parse_chunks(p, digits, 3 * block);
+  csv::CsvParser::EngineStats st = p.engine_stats();
+  if (st.active != Engine::Libcsv || st.bytes[0] != digits.size() || st.blocks != 8 || st.sampled != 4 ||
+      st.switches != 0)
+    fail("auto", "short fields not parsed with csv_parse()");
+
+  /* Monitoring picks up the change */
+  parse_chunks(p, words, block);
+  st = p.engine_stats();
+  if (st.active != Engine::Simd || st.switches != 1 || st.bytes[2] == 0)
+    fail("auto", "long unquoted fields not parsed with masks");
+  parse_chunks(p, quoted, block);
+  st = p.engine_stats();
+  if (st.active != Engine::Runs || st.switches != 2 || st.bytes[1] == 0 ||
+      st.bytes[0] + st.bytes[1] + st.bytes[2] != digits.size() + words.size() + quoted.size())
+    fail("auto", "quoted fields not parsed with runs");
+
+  /* No csv_parse() while the tokenizer acts, no masks with other character classes */
+  csv::CsvParser h;
+  h.set_engine(Engine::Auto);
+  h.set_projection({0, 2});
+  parse_chunks(h, digits, block);
+  if (h.engine_stats().bytes[0] != 0 || h.engine_stats().active != Engine::Runs)
+    fail("auto", "csv_parse() used with a projection");
+  csv::CsvParser c;
+  c.set_engine(Engine::Simd);
+  c.set_term_func(is_semicolon);
+  parse_chunks(c, words, block);
+  if (c.engine_stats().active != Engine::Runs || c.engine_stats().bytes[1] != words.size())
+    fail("auto", "masks used with a custom terminator function");
+}
+
+int
+main (void)
+{
+  test_parity();
+  test_switch();
+  test_auto();
+  std::puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,124 @@
+#ifndef CSV_TEST_FIXTURE_HPP
+#define CSV_TEST_FIXTURE_HPP
+
+/*
+ * Fixture of the suites comparing a tokenizing path (engines, in-situ,
+ * raw fields, checkpoints) with parse(): one document covering quoting,
+ * padding, blank lines and long fields, callbacks rendering what they
+ * receive as text, and a driver splitting the input at any byte. Define
+ * TEST_NAME before including this header.
+ */
+
+#include "CsvParser.hpp"
+#include "test_util.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Fields as "[text]" or "NULL" (with "!" if AppendNull left no terminator),
+ * rows as "/<c>\n"; fields pointing into [begin, end) are counted
+ */
+struct Output {
+  std::string text;
+  std::uint64_t rows = 0;
+  bool append_null = false;
+  const char *begin = nullptr;
+  const char *end = nullptr;
+  size_t inside = 0;
+  size_t buffer_size = 0;  // entry buffer after run()
+};
+
+inline void
+field_cb (void *s, size_t len, void *data)
+{
+  Output *o = static_cast<Output *>(data);
+  const char *p = static_cast<const char *>(s);
+  if (!p) {
+    o->text += "NULL";
+    return;
+  }
+  o->text += "[" + std::string(p, len) + "]";
+  if (o->append_null && p[len] != '\0') o->text += "!";
+  if (p >= o->begin && p < o->end) o->inside++;
+}
+
+inline void
+row_cb (int c, void *data)
+{
+  Output *o = static_cast<Output *>(data);
+  o->text += "/" + std::to_string(c) + "\n";
+  ++o->rows;
+}
+
+/*
+ * A BOM, quoted fields with delimiters, doubled quotes and newlines,
+ * padding around quoted and unquoted fields, malformed (non-strict)
+ * quoting, fields longer than the 16-byte unescape path and the default
+ * entry buffer, and a quoted field left open at the end
+ */
+static const std::string kCsv =
+  "\xEF\xBB\xBFid,name,qty,note\n"
+  "1,alpha,10,\"plain\"\r\n"
+  "\n"
+  "2, \"be,ta\" ,20,\"say \"\"hi\"\"\nthen \"\"bye\"\"\"\n"
+  "3,gamma  ,,  spaced  \n"
+  "4,\"delta\"  ,40,\"\"\n"
+  "5,\"ab\" \"cd\",50,a\"\"b\n"
+  "6,\"a\"\"\"\"\",60,\"x\" \"\"y\"\n"
+  "7,\"" + std::string(70, 'q') + "\"\"" + std::string(30, 'r') + "\"\"\"\"" + std::string(20, 's') + "\"," +
+  std::string(300, 'u') + "   ,\"tail \n"
+  "8,epsilon,80,last";
+
+typedef std::function<void (csv::CsvParser &)> Setup;
+
+/* One call on a piece of a writable copy of the input; returns the bytes consumed */
+typedef std::function<size_t (csv::CsvParser &, char *, size_t, Output &)> Feed;
+typedef std::function<void (csv::CsvParser &, Output &)> Finish;
+
+inline size_t
+feed_parse (csv::CsvParser &p, char *s, size_t n, Output &out)
+{
+  return p.parse(s, n, field_cb, row_cb, &out);
+}
+
+inline void
+finish_parse (csv::CsvParser &p, Output &out)
+{
+  p.finish(field_cb, row_cb, &out);
+}
+
+/*
+ * Feeds @p input split after @p k bytes, then finishes. Returns the
+ * rendered output followed by the bytes each call consumed and any error;
+ * @p out keeps the counters.
+ */
+inline std::string
+run (const Setup &setup, const std::string &input, size_t k, Output &out,
+     const Feed &feed = feed_parse, const Finish &finish = finish_parse)
+{
+  std::vector<char> buf(input.begin(), input.end());
+  out.begin = buf.data();
+  out.end = buf.data() + buf.size();
+  csv::CsvParser p;
+  setup(p);
+  std::string log;
+  size_t at = 0;
+  try {
+    for (const size_t n : {k, input.size() - k}) {
+      log += "<" + std::to_string(feed(p, buf.data() + at, n, out)) + ">";
+      at += n;
+    }
+    finish(p, out);
+  } catch (const csv::CsvError &e) {
+    log += "<error " + std::to_string(static_cast<int>(e.type)) + " at " + std::to_string(e.bytes_parsed) + ">";
+  } catch (const std::runtime_error &e) {
+    log += std::string("<fini ") + e.what() + ">";
+  }
+  out.buffer_size = p.get_buffer_size();
+  out.begin = out.end = nullptr;
+  return out.text + log;
+}
+
+#endif // CSV_TEST_FIXTURE_HPP
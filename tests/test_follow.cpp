@@ -0,0 +1,114 @@
+#include "FollowSource.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Follow"
+#include "test_util.hpp"
+
+static const std::string kLog =
+  "1,start,\"multi\nline\"\r\n"
+  "2,\"quoted, with \"\"escapes\"\"\",x\n"
+  "3,plain, spaced \n"
+  "\n"
+  "4,\"ends in quote\"\r\n"
+  "5,last,row";
+
+static void
+test_appends (void)
+{
+  for (size_t piece : {1, 3, 7, 1000}) {
+    write_file("test_follow.csv", "", "wb");
+    csv::FollowSource src("test_follow.csv");
+    csv::CsvParser p;
+    Rows r;
+    for (size_t off = 0; off < kLog.size(); off += piece) {
+      write_file("test_follow.csv", kLog.substr(off, piece), "ab");
+      src.poll(p, cb1, cb2, &r);
+      if (!r.current.empty())
+        fail("appends", "partial row delivered");
+      if (src.offset() + src.pending() != off + (kLog.size() - off < piece ? kLog.size() - off : piece))
+        fail("appends", "unexpected offset");
+    }
+    if (r.rows.size() != 4 || src.pending() != 11)  /* "\n" of the CRLF plus the last row */
+      fail("appends", "last row delivered before its terminator");
+    src.finish(p, cb1, cb2, &r);
+    csv::CsvParser whole;
+    if (r.rows != parse_all(whole, kLog))
+      fail("appends", "rows differ from a single parse");
+  }
+}
+
+static void
+test_resume (void)
+{
+  write_file("test_follow.csv", kLog.substr(0, 40), "wb");
+  std::uint64_t offset;
+  {
+    csv::FollowSource src("test_follow.csv");
+    csv::CsvParser p;
+    Rows r;
+    src.poll(p, cb1, cb2, &r);
+    offset = src.offset();
+  }
+  write_file("test_follow.csv", kLog.substr(40), "ab");
+
+  csv::FollowSource src("test_follow.csv", offset);
+  csv::CsvParser p;
+  Rows r;
+  src.finish(p, cb1, cb2, &r);
+  csv::CsvParser whole;
+  std::vector<std::string> all = parse_all(whole, kLog);
+  if (r.rows.empty() || r.rows.back() != all.back() || r.rows.front() != all[all.size() - r.rows.size()])
+    fail("resume", "unexpected rows after restart");
+}
+
+static void
+test_truncate (void)
+{
+  write_file("test_follow.csv", "a,1\nb,2\n", "wb");
+  csv::FollowSource src("test_follow.csv");
+  csv::CsvParser p;
+  Rows r;
+  src.poll(p, cb1, cb2, &r);
+  write_file("test_follow.csv", "c,3\n", "wb");
+  src.poll(p, cb1, cb2, &r);
+  if (r.rows.size() != 3 || r.rows[2] != "c|3")
+    fail("truncate", "file was not reread from the start");
+}
+
+static void
+test_wait (void)
+{
+  write_file("test_follow.csv", "a,1\n", "wb");
+  csv::FollowSource src("test_follow.csv");
+  csv::CsvParser p;
+  Rows r;
+  src.poll(p, cb1, cb2, &r);
+#if defined(__linux__)
+  if (!src.uses_inotify())
+    fail("wait", "inotify not used on Linux");
+  src.wait(0);  /* drain events of the initial write */
+#endif
+  if (src.wait(20))
+    fail("wait", "woke up without a change");
+  write_file("test_follow.csv", "b,2\n", "ab");
+  if (!src.wait(1000))
+    fail("wait", "append not noticed");
+  src.poll(p, cb1, cb2, &r);
+  if (r.rows.size() != 2)
+    fail("wait", "appended row not parsed");
+}
+
+int
+main (void)
+{
+  test_appends();
+  test_resume();
+  test_truncate();
+  test_wait();
+  std::remove("test_follow.csv");
+  puts("All tests passed");
+  return 0;
+}
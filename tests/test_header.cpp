@@ -0,0 +1,219 @@
+#include "CsvBinding.hpp"
+#include "CsvParser.hpp"
+#include "HeaderMap.hpp"
+#include "RowFilter.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct Reading {
+  long id = 0;
+  double value = 0.0;
+  std::string sensor;
+};
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Header test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+static void
+cb1 (void *s, size_t len, void *data)
+{
+  std::string *out = static_cast<std::string *>(data);
+  if (s) *out += std::string(static_cast<const char *>(s), len) + ";";
+  else *out += "<null>;";
+}
+
+static void
+cb2 (int, void *data)
+{
+  *static_cast<std::string *>(data) += "\n";
+}
+
+static std::string
+run (csv::CsvParser &p, const std::string &input, size_t slice)
+{
+  std::string out;
+  for (size_t off = 0; off < input.size(); off += slice) {
+    size_t n = input.size() - off < slice ? input.size() - off : slice;
+    p.parse(input.data() + off, n, cb1, cb2, &out);
+  }
+  p.finish(cb1, cb2, &out);
+  return out;
+}
+
+static const std::string kData =
+  "\xEF\xBB\xBFid, \"sensor\" ,value\r\n"
+  "1,north,0.5\r\n"
+  "2,south,7\r\n"
+  "3,north,12.25";
+
+static void
+test_map (void)
+{
+  std::vector<std::string> names;
+  for (int i = 0; i < 1000; i++) names.push_back("col" + std::to_string(i));
+  names.push_back("col7");
+  names.push_back("");
+  csv::HeaderMap h(names);
+
+  if (h.size() != 1002 || h.name(3) != "col3")
+    fail("map", "unexpected size or name");
+  for (size_t i = 0; i < 1000; i++)
+    if (h.find("col" + std::to_string(i)) != i)
+      fail("map", "lookup mismatch");
+  if (h.find("col7") != 7)
+    fail("map", "duplicate name does not resolve to its first column");
+  if (h.find("") != 1001 || h.contains("col1000") || h.find("col") != csv::HeaderMap::npos)
+    fail("map", "unexpected lookup result");
+
+  bool thrown = false;
+  try {
+    (void)h.index("missing");
+  } catch (const csv::CsvError &e) {
+    thrown = e.type == csv::CsvError::ErrorType::Einvalid;
+  }
+  if (!thrown)
+    fail("map", "unknown name did not throw Einvalid");
+  if (csv::HeaderMap().find("id") != csv::HeaderMap::npos)
+    fail("map", "empty map found a name");
+}
+
+static void
+test_capture (void)
+{
+  for (size_t slice : {1, 3, 1000}) {
+    csv::CsvParser p;
+    p.set_header_row(true);
+    if (run(p, kData, slice) != "1;north;0.5;\n2;south;7;\n3;north;12.25;\n")
+      fail("capture", "unexpected rows");
+    const csv::HeaderMap &h = p.header();
+    if (h.size() != 3 || h.name(0) != "id" || h.index("sensor") != 1 || h.index("value") != 2)
+      fail("capture", "unexpected header");
+
+    /* Blank lines reported under RepAllNl do not count as the header */
+    csv::CsvParser q({csv::CsvParser::Option::RepAllNl});
+    q.set_header_row(true);
+    if (run(q, "\n\nx,y\n1,2\n\n", slice) != "1;2;\n\n" || q.header().find("y") != 1)
+      fail("capture", "blank lines before the header");
+  }
+
+  /* A header-only document still yields a header */
+  csv::CsvParser p;
+  p.set_header_row(true);
+  if (!run(p, "a,b", 1000).empty() || p.header().size() != 2)
+    fail("capture", "header-only document");
+}
+
+static void
+test_named (void)
+{
+  for (size_t slice : {1, 5, 1000}) {
+    csv::CsvParser p;
+    p.set_header_row(true);
+    p.set_named_projection({"value", "id"});
+    if (run(p, kData, slice) != "1;0.5;\n2;7;\n3;12.25;\n")
+      fail("named", "projection mismatch");
+
+    csv::RowFilter f;
+    f.equals("sensor", "north").float_range("value", 1.0, 100.0);
+    p.set_filter(f);
+    if (run(p, kData, slice) != "3;12.25;\n" || p.rows_filtered() != 2)
+      fail("named", "filter mismatch");
+  }
+
+  /* Names are resolved again for every document */
+  csv::CsvParser p;
+  p.set_header_row(true);
+  p.set_named_projection({"b"});
+  if (run(p, "a,b\n1,2\n", 1000) != "2;\n" || run(p, "b,a\n3,4\n", 1000) != "3;\n")
+    fail("named", "second document");
+}
+
+static void
+test_errors (void)
+{
+  bool thrown = false;
+  try {
+    csv::CsvParser p;
+    p.set_named_projection({"id"});
+  } catch (const csv::CsvError &e) {
+    thrown = e.type == csv::CsvError::ErrorType::Einvalid;
+  }
+  if (!thrown)
+    fail("errors", "names accepted without a header row");
+
+  thrown = false;
+  csv::CsvParser p;
+  p.set_header_row(true);
+  csv::RowFilter f;
+  f.equals("nope", "x");
+  p.set_filter(f);
+  try {
+    std::string out;
+    p.parse(kData.data(), kData.size(), cb1, cb2, &out);
+  } catch (const csv::CsvError &e) {
+    thrown = e.type == csv::CsvError::ErrorType::Einvalid;
+  }
+  if (!thrown)
+    fail("errors", "unknown column resolved");
+
+  thrown = false;
+  try {
+    p.set_named_projection({"nope"});
+  } catch (const csv::CsvError &e) {
+    thrown = e.type == csv::CsvError::ErrorType::Einvalid;
+  }
+  if (!thrown)
+    fail("errors", "unknown column accepted against a captured header");
+}
+
+static void
+test_binding (void)
+{
+  auto binding = csv::bind<Reading>(&Reading::value, &Reading::sensor);
+  for (bool project : {false, true}) {
+    csv::CsvParser p;
+    p.set_header_row(true);
+    if (project) p.set_named_projection({"sensor", "value"});
+    std::vector<Reading> rows;
+    auto reader = binding.reader(rows).by_name({"value", "sensor"});
+    for (size_t i = 0; i < kData.size(); i++)
+      reader.parse(p, kData.data() + i, 1);
+    reader.finish(p);
+
+    if (rows.size() != 3)
+      fail("binding", "unexpected row count");
+    if (rows[0].value != 0.5 || rows[0].sensor != "north" || rows[2].value != 12.25 || rows[1].sensor != "south")
+      fail("binding", "row mismatch");
+  }
+
+  bool thrown = false;
+  try {
+    csv::CsvParser p;
+    p.set_header_row(true);
+    std::vector<Reading> rows;
+    auto reader = binding.reader(rows).by_name({"value", "station"});
+    reader.parse(p, kData.data(), kData.size());
+  } catch (const csv::CsvError &e) {
+    thrown = e.type == csv::CsvError::ErrorType::Einvalid;
+  }
+  if (!thrown)
+    fail("binding", "unknown column bound");
+}
+
+int
+main (void)
+{
+  test_map();
+  test_capture();
+  test_named();
+  test_errors();
+  test_binding();
+  puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,270 @@
+#include "RowIndex.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Index"
+#include "test_util.hpp"
+
+static std::vector<std::string>
+parse_file (csv::CsvParser &p, FILE *fp, size_t limit)
+{
+  Rows r;
+  r.limit = limit;
+  char buf[4096];
+  while (r.rows.size() < limit) {
+    size_t n = std::fread(buf, 1, sizeof(buf), fp);
+    if (n == 0) break;
+    p.parse(buf, n, cb1, cb2, &r);
+  }
+  p.finish(cb1, cb2, &r);
+  return r.rows;
+}
+
+/* Quoted fields with embedded newlines, delimiters and doubled quotes */
+static std::string
+make_csv (void)
+{
+  std::string csv = "id,text,n\r\n";
+  for (int i = 0; i < 20000; i++) {
+    csv += std::to_string(i) + ",";
+    switch (i % 5) {
+      case 0: csv += "\"multi\nline,\"\"quoted\"\"\nvalue\""; break;
+      case 1: csv += "plain value"; break;
+      case 2: csv += "\"\""; break;
+      case 3: csv += "  spaced  "; break;
+      case 4: csv += "\"a\" ,x"; break;
+    }
+    csv += "," + std::to_string(i * 7) + (i % 2 ? "\n" : "\r\n");
+    if (i % 97 == 0) csv += "\n";  /* blank lines are not rows */
+  }
+  csv += "last,row,unterminated";
+  return csv;
+}
+
+static void
+check_seek (const char *name, const csv::RowIndex &index, const std::vector<std::string> &all)
+{
+  if (index.rows() != all.size())
+    fail(name, "row count mismatch");
+  const size_t targets[] = {0, 1, 2, 3, 999, 1000, 1001, 12345, all.size() - 2, all.size() - 1};
+  for (size_t row : targets) {
+    csv::CsvParser p;
+    FILE *fp = std::fopen("test_index.csv", "rb");
+    p.seek(index, fp, row);
+    std::vector<std::string> got = parse_file(p, fp, 2);
+    std::fclose(fp);
+    if (got.empty() || got[0] != all[row])
+      fail(name, "seek landed on the wrong row");
+    if (row + 1 < all.size() && (got.size() < 2 || got[1] != all[row + 1]))
+      fail(name, "row after seek target mismatch");
+  }
+}
+
+static void
+test_build (void)
+{
+  write_file("test_index.csv", make_csv());
+  csv::CsvParser full;
+  FILE *fp = std::fopen("test_index.csv", "rb");
+  std::vector<std::string> all = parse_file(full, fp, SIZE_MAX);
+  std::fclose(fp);
+
+  csv::CsvParser p;
+  csv::IndexOptions opts;
+  opts.stride = 1;
+  csv::RowIndex::build("test_index.csv", "test_index.csvidx", p, opts);
+  csv::RowIndex every = csv::RowIndex::open("test_index.csvidx", "test_index.csv");
+  if (every.entries() != all.size())
+    fail("build", "stride 1 must index every row");
+  check_seek("sequential", every, all);
+
+  /* Chunk boundaries land inside quoted fields; speculation must recover */
+  opts.stride = 1000;
+  opts.threads = 7;
+  csv::RowIndex::build("test_index.csv", "test_index.csvidx", p, opts);
+  csv::RowIndex sparse = csv::RowIndex::open("test_index.csvidx", "test_index.csv");
+  if (sparse.stride() != 1000 || sparse.entries() != (all.size() + 999) / 1000)
+    fail("build", "unexpected entry count");
+  check_seek("parallel", sparse, all);
+  for (size_t k = 0; k < sparse.entries(); k++) {
+    if (sparse.locate(k * 1000).offset != every.locate(k * 1000).offset)
+      fail("parallel", "offsets differ from sequential build");
+  }
+}
+
+static void
+test_cells (void)
+{
+  /* A wide file: one field of 70000 bytes forces 32-bit deltas in its row */
+  std::string csv;
+  for (int r = 0; r < 50; r++) {
+    for (int c = 0; c < 300; c++) {
+      if (c) csv += ',';
+      if (r == 7 && c == 3) csv += std::string(70000, 'w');
+      else if (c % 50 == 1) csv += "\"q\nq,\"\"" + std::to_string(c) + "\"";
+      else csv += std::to_string(r * 1000 + c);
+    }
+    csv += r % 2 ? "\r\n" : "\n";
+  }
+  csv += "x,,";  /* unterminated last row with empty fields */
+  write_file("test_index.csv", csv);
+
+  csv::CsvParser p;
+  csv::IndexOptions opts;
+  opts.field_offsets = true;
+  opts.threads = 3;
+  csv::RowIndex::build("test_index.csv", "test_index.csvidx", p, opts);
+  csv::RowIndex index = csv::RowIndex::open("test_index.csvidx", "test_index.csv");
+  if (!index.has_field_offsets() || index.stride() != 1 || index.rows() != 51)
+    fail("cells", "unexpected index shape");
+  if (index.fields(0) != 300 || index.fields(7) != 300 || index.fields(50) != 3)
+    fail("cells", "wrong field counts");
+
+  FILE *fp = std::fopen("test_index.csv", "rb");
+  if (p.read_cell(index, fp, 0, 0) != "0" || p.read_cell(index, fp, 12, 299) != "12299")
+    fail("cells", "plain cell mismatch");
+  if (p.read_cell(index, fp, 3, 51) != "q\nq,\"51")
+    fail("cells", "quoted cell mismatch");
+  if (p.read_cell(index, fp, 7, 3) != std::string(70000, 'w') || p.read_cell(index, fp, 7, 4) != "7004")
+    fail("cells", "wide row mismatch");
+  if (p.read_cell(index, fp, 50, 0) != "x" || !p.read_cell(index, fp, 50, 2).empty())
+    fail("cells", "last row mismatch");
+  try {
+    (void) p.read_cell(index, fp, 50, 3);
+    fail("cells", "column past the row end accepted");
+  } catch (const std::out_of_range &) {
+  }
+  std::fclose(fp);
+}
+
+static std::vector<std::string>
+split_row (const std::string &row)
+{
+  std::vector<std::string> fields;
+  size_t begin = 0;
+  for (size_t bar; (bar = row.find('|', begin)) != std::string::npos; begin = bar + 1)
+    fields.push_back(row.substr(begin, bar - begin));
+  fields.push_back(row.substr(begin));
+  return fields;
+}
+
+static void
+test_zones (void)
+{
+  write_file("test_index.csv", make_csv());
+  csv::CsvParser full;
+  FILE *fp = std::fopen("test_index.csv", "rb");
+  std::vector<std::string> all = parse_file(full, fp, SIZE_MAX);
+  std::fclose(fp);
+
+  csv::CsvParser p;
+  csv::IndexOptions opts;
+  opts.stride = 300;
+  opts.threads = 3;
+  opts.zone_rows = 1000;  /* rounded up to 1200 */
+  opts.bloom_bits = 500;
+  csv::RowIndex::build("test_index.csv", "test_index.csvidx", p, opts);
+  csv::RowIndex index = csv::RowIndex::open("test_index.csvidx", "test_index.csv");
+  if (!index.has_zone_maps() || index.zone_rows() != 1200 || index.zones() != (all.size() + 1199) / 1200 ||
+      index.zone_columns() != 4)  /* "\"a\" ,x" adds a column */
+    fail("zones", "unexpected zone layout");
+
+  csv::RowFilter range;
+  range.int_range(0, 5000, 5100);
+  csv::RowFilter absent;
+  absent.equals(1, "no such value");
+  size_t kept = 0;
+  for (size_t z = 0; z < index.zones(); z++) {
+    csv::RowIndex::ZoneSpan span = index.zone_span(z);
+    if (span.row != z * 1200 || span.rows != std::min<size_t>(1200, all.size() - span.row))
+      fail("zones", "unexpected zone span");
+
+    /* The span is exactly the block's rows */
+    fp = std::fopen("test_index.csv", "rb");
+    std::fseek(fp, static_cast<long>(span.begin), SEEK_SET);
+    std::string bytes(static_cast<size_t>(span.end - span.begin), '\0');
+    if (std::fread(&bytes[0], 1, bytes.size(), fp) != bytes.size())
+      fail("zones", "cannot read zone bytes");
+    std::fclose(fp);
+    csv::CsvParser zp;
+    Rows r;
+    zp.parse(bytes.data(), bytes.size(), cb1, cb2, &r);
+    zp.finish(cb1, cb2, &r);
+    if (r.rows.size() != span.rows || r.rows.front() != all[span.row] || r.rows.back() != all[span.row + span.rows - 1])
+      fail("zones", "zone span does not cover its rows");
+
+    long long lo = 0, hi = 0;
+    size_t ints = 0;
+    bool in_range = false;
+    for (size_t row = span.row; row < span.row + span.rows; row++) {
+      std::vector<std::string> f = split_row(all[row]);
+      if (f.size() > 1 && !index.zone(z, 1).may_equal(f[1]))
+        fail("zones", "zone rules out a value it holds");
+      char *end;
+      long long v = std::strtoll(f[0].c_str(), &end, 10);
+      if (f[0].empty() || *end) continue;
+      lo = ints ? std::min(lo, v) : v;
+      hi = ints ? std::max(hi, v) : v;
+      ints++;
+      in_range = in_range || (v >= 5000 && v <= 5100);
+    }
+    csv::RowIndex::ColumnZone id = index.zone(z, 0);
+    if (id.ints != ints || (ints && (id.int_min != lo || id.int_max != hi)))
+      fail("zones", "wrong integer bounds");
+    if (range.may_match(index, z) != in_range)
+      fail("zones", "range filter pruning mismatch");
+    if (absent.may_match(index, z))
+      fail("zones", "bloom filter kept a zone without the value");
+    if (index.zone(z, 5).nulls != span.rows || index.zone(z, 5).has_text)
+      fail("zones", "missing column not reported as NULL");
+    kept += range.may_match(index, z);
+  }
+  if (kept != 1)
+    fail("zones", "range query should touch one zone");
+}
+
+static void
+test_stale (void)
+{
+  if (!csv::RowIndex::is_fresh("test_index.csvidx", "test_index.csv"))
+    fail("stale", "index not fresh after build");
+  write_file("test_index.csv", "a,b\n");
+  if (csv::RowIndex::is_fresh("test_index.csvidx", "test_index.csv"))
+    fail("stale", "modified source still fresh");
+  try {
+    csv::RowIndex::open("test_index.csvidx", "test_index.csv");
+    fail("stale", "stale index opened");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("stale", "wrong error type");
+  }
+
+  csv::CsvParser p;
+  csv::RowIndex::build("test_index.csv", "test_index.csvidx", p);
+  csv::RowIndex index = csv::RowIndex::open("test_index.csvidx", "test_index.csv");
+  csv::CsvParser other(';', '"', {});
+  try {
+    other.seek(index, 0);
+    fail("stale", "index used with a different delimiter");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("stale", "wrong error type for configuration mismatch");
+  }
+}
+
+int
+main (void)
+{
+  test_build();
+  test_cells();
+  test_zones();
+  test_stale();
+  std::remove("test_index.csv");
+  std::remove("test_index.csvidx");
+  std::puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include "RowBatch.hpp"
+#include "RowFilter.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "In-situ"
+#include "test_fixture.hpp"
+
+static size_t
+feed_insitu (csv::CsvParser &p, char *s, size_t n, Output &out)
+{
+  return p.parse_insitu(s, n, field_cb, row_cb, &out);
+}
+
+/* One in-situ call per half of the input, split at every offset, against parse() split alike */
+static void
+check_insitu (const char *name, const Setup &setup, bool append_null)
+{
+  for (size_t k = 0; k <= kCsv.size(); k++) {
+    Output ref, out;
+    ref.append_null = out.append_null = append_null;
+    const std::string expected = run(setup, kCsv, k, ref);
+    const std::string got = run(setup, kCsv, k, out, feed_insitu);
+    if (got != expected) {
+      std::fprintf(stderr, "split at %zu:\n%s\nexpected:\n%s\n", k, got.c_str(), expected.c_str());
+      fail(name, "output differs from parse()");
+    }
+    if (got.find("]!") != std::string::npos)
+      fail(name, "field not null-terminated");
+    /* Without a split, fields come from the buffer itself */
+    if (k == kCsv.size() && out.inside == 0)
+      fail(name, "fields not delivered in place");
+  }
+}
+
+static void
+test_parse (void)
+{
+  check_insitu("plain", [](csv::CsvParser &) {}, false);
+  check_insitu("options", [](csv::CsvParser &p) {
+    p.set_options({csv::CsvParser::Option::RepAllNl, csv::CsvParser::Option::AppendNull,
+                   csv::CsvParser::Option::EmptyIsNull});
+  }, true);
+  check_insitu("header", [](csv::CsvParser &p) {
+    p.set_header_row(true);
+    p.set_named_projection({"note", "id"});
+  }, false);
+  check_insitu("filter", [](csv::CsvParser &p) {
+    p.set_header_row(true);
+    p.set_filter(csv::RowFilter().int_range("qty", 15, 45));
+  }, false);
+
+  /* Unescaped in place: the quoted field is compacted right after its opening quote */
+  char buf[] = "\"a\"\"b\",c\n";
+  Output out;
+  out.begin = buf;
+  out.end = buf + sizeof(buf) - 1;
+  out.append_null = true;
+  csv::CsvParser p({csv::CsvParser::Option::AppendNull});
+  p.parse_insitu(buf, sizeof(buf) - 1, field_cb, row_cb, &out);
+  if (out.text != "[a\"b][c]/10\n" || out.inside != 2)
+    fail("compact", "wrong fields");
+  if (std::memcmp(buf + 1, "a\"b\0", 4) != 0 || buf[8] != '\0')
+    fail("compact", "field or terminator not written in place");
+}
+
+struct Batches {
+  std::string text;
+};
+
+static void
+on_batch (const csv::RowBatch &b, void *data)
+{
+  Batches *s = static_cast<Batches *>(data);
+  for (size_t r = 0; r < b.rows(); r++) {
+    for (size_t c = 0; c < b.fields(r); c++) {
+      const csv::FieldView f = b.field(r, c);
+      s->text += f.is_null() ? "NULL" : "[" + f.str() + "]";
+    }
+    s->text += "\n";
+  }
+  s->text += "--\n";
+}
+
+static void
+test_batch (void)
+{
+  const std::string csv = "a,,\"x\"\"y\",d\n1,2\n\"multi\nline\",3\n,,\nlast,row";
+  Batches expected;
+  {
+    csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+    csv::RowBatch batch(2);
+    batch.parse(p, csv.data(), csv.size(), on_batch, &expected);
+    batch.finish(p, on_batch, &expected);
+  }
+
+  for (size_t chunk = 1; chunk <= csv.size(); chunk++) {
+    csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+    csv::RowBatch batch(2);
+    Batches got;
+    std::vector<char> buf(chunk);
+    for (size_t at = 0; at < csv.size(); at += chunk) {
+      const size_t n = csv.size() - at < chunk ? csv.size() - at : chunk;
+      std::memcpy(buf.data(), csv.data() + at, n);
+      batch.parse_insitu(p, buf.data(), n, on_batch, &got);
+      std::memset(buf.data(), 'X', buf.size());  // the buffer is reused right away
+    }
+    batch.finish(p, on_batch, &got);
+    if (got.text != expected.text) {
+      std::fprintf(stderr, "chunk %zu:\n%s\nexpected:\n%s\n", chunk, got.text.c_str(), expected.text.c_str());
+      fail("batch", "batches differ from parse()");
+    }
+  }
+
+  /* Mixing copying and in-situ calls within one batch */
+  csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+  csv::RowBatch batch(2);
+  Batches got;
+  std::vector<char> buf(csv.begin() + 5, csv.end());
+  batch.parse(p, csv.data(), 5, on_batch, &got);
+  batch.parse_insitu(p, buf.data(), buf.size(), on_batch, &got);
+  batch.finish(p, on_batch, &got);
+  if (got.text != expected.text)
+    fail("batch", "mixed calls differ from parse()");
+}
+
+int
+main (void)
+{
+  test_parse();
+  test_batch();
+  std::puts("All tests passed");
+  return 0;
+}
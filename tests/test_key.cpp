@@ -0,0 +1,128 @@
+#include "KeyIndex.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Key"
+#include "test_util.hpp"
+
+/* Keys repeat every 1000 rows; some are quoted, spaced or contain newlines */
+static std::string
+make_rows (int from, int to)
+{
+  std::string csv;
+  for (int i = from; i < to; i++) {
+    std::string key = "K" + std::to_string(i % 1000);
+    switch (i % 4) {
+      case 0: csv += key; break;
+      case 1: csv += "\"" + key + "\""; break;
+      case 2: csv += "  " + key + " "; break;
+      case 3: csv += "\"" + key + "\""; break;
+    }
+    csv += "," + std::to_string(i) + ",\"note\n" + std::to_string(i) + "\"" + (i % 2 ? "\n" : "\r\n");
+  }
+  return csv;
+}
+
+static std::vector<std::string>
+lookup (const char *name, csv::CsvParser &p, std::string_view key)
+{
+  csv::KeyIndex index = csv::KeyIndex::open("test_key.csvkey", "test_key.csv");
+  Rows r;
+  size_t n = index.lookup(p, key, cb1, cb2, &r);
+  if (n != r.rows.size())
+    fail(name, "lookup count differs from delivered rows");
+  return r.rows;
+}
+
+static void
+test_lookup (void)
+{
+  write_file("test_key.csv", "id,n,note\n" + make_rows(0, 5000), "wb");
+  csv::CsvParser p;
+  csv::KeyIndex::build("test_key.csv", "test_key.csvkey", p, "id");
+  csv::KeyIndex index = csv::KeyIndex::open("test_key.csvkey", "test_key.csv");
+  if (index.rows() != 5001 || index.size() != 5000 || index.column() != 0 || !index.has_header())
+    fail("lookup", "unexpected index shape");
+
+  std::vector<csv::KeyIndex::Match> m = index.find(p, "K42");
+  if (m.size() != 5 || m[0].row != 43 || m[4].row != 4043)
+    fail("lookup", "wrong rows for key");
+  if (!index.find(p, "K4200").empty() || !index.find(p, "id").empty())
+    fail("lookup", "found a missing key");
+
+  std::vector<std::string> rows = lookup("lookup", p, "K7");
+  if (rows.size() != 5 || rows[0] != "K7|7|note\n7" || rows[4] != "K7|4007|note\n4007")
+    fail("lookup", "wrong rows parsed");
+
+  /* A header-aware parser captures the header and can project by name */
+  csv::CsvParser named;
+  named.set_header_row(true);
+  named.set_named_projection({"n"});
+  rows = lookup("lookup", named, "K999");
+  if (rows.size() != 5 || rows[0] != "999" || named.header().size() != 3)
+    fail("lookup", "header or projection not applied");
+}
+
+static void
+test_update (void)
+{
+  csv::CsvParser p;
+  std::string head = "id,n,note\n" + make_rows(0, 3000);
+  write_file("test_key.csv", head + "K1,tail", "wb");  /* unterminated last row */
+  csv::KeyIndex::build("test_key.csv", "test_key.csvkey", p, static_cast<size_t>(0));
+
+  /* The last row grows and more rows follow */
+  write_file("test_key.csv", "row\n" + make_rows(3000, 4000), "ab");
+  if (!csv::KeyIndex::update("test_key.csv", "test_key.csvkey", p))
+    fail("update", "append not handled incrementally");
+  std::vector<std::string> rows = lookup("update", p, "K1");
+  if (rows.size() != 5 || rows[3] != "K1|tailrow" || rows[4] != "K1|3001|note\n3001")
+    fail("update", "appended rows not indexed");
+
+  /* Matches a fresh build exactly */
+  csv::KeyIndex updated = csv::KeyIndex::open("test_key.csvkey", "test_key.csv");
+  std::vector<csv::KeyIndex::Match> a = updated.find(p, "K500");
+  csv::KeyIndex::build("test_key.csv", "test_key.csvkey", p, static_cast<size_t>(0));
+  csv::KeyIndex fresh = csv::KeyIndex::open("test_key.csvkey", "test_key.csv");
+  std::vector<csv::KeyIndex::Match> b = fresh.find(p, "K500");
+  if (updated.rows() != fresh.rows() || updated.size() != fresh.size() || a.size() != b.size() ||
+      a.back().begin != b.back().begin || a.back().end != b.back().end)
+    fail("update", "incremental index differs from a rebuild");
+
+  /* Rewriting earlier bytes forces a rebuild */
+  write_file("test_key.csv", "X" + head.substr(1) + make_rows(9000, 9100), "wb");
+  if (csv::KeyIndex::update("test_key.csv", "test_key.csvkey", p))
+    fail("update", "rewritten file updated incrementally");
+  if (lookup("update", p, "K50").size() != 4)
+    fail("update", "rebuilt index wrong");
+
+  /* So does rewriting bytes far before the end of the indexed rows */
+  head = "id,n,note\n" + make_rows(0, 6000);
+  write_file("test_key.csv", head, "wb");
+  csv::KeyIndex::build("test_key.csv", "test_key.csvkey", p, static_cast<size_t>(0));
+  write_file("test_key.csv", "ID" + head.substr(2) + make_rows(6000, 6010), "wb");
+  if (csv::KeyIndex::update("test_key.csv", "test_key.csvkey", p))
+    fail("update", "file rewritten at its start updated incrementally");
+
+  try {
+    write_file("test_key.csv", "a\n", "ab");
+    csv::KeyIndex::open("test_key.csvkey", "test_key.csv");
+    fail("update", "stale index opened");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("update", "wrong error type");
+  }
+}
+
+int
+main (void)
+{
+  test_lookup();
+  test_update();
+  std::remove("test_key.csv");
+  std::remove("test_key.csvkey");
+  std::puts("All tests passed");
+  return 0;
+}
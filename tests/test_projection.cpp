@@ -0,0 +1,145 @@
+#include "CsvParser.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Projection test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+/* Events are recorded as "F<value>" / "N" (null) / "R" so runs can be compared */
+static void
+cb1 (void *s, size_t len, void *data)
+{
+  std::string *out = static_cast<std::string *>(data);
+  if (s) *out += "F" + std::string(static_cast<const char *>(s), len) + ";";
+  else *out += "N;";
+}
+
+static void
+cb2 (int, void *data)
+{
+  *static_cast<std::string *>(data) += "R\n";
+}
+
+/* Reference: full libcsv parse, filtering field events by column */
+struct Filtered {
+  std::string out;
+  std::vector<size_t> keep;
+  size_t col = 0;
+};
+
+static void
+ref_cb1 (void *s, size_t len, void *data)
+{
+  Filtered *f = static_cast<Filtered *>(data);
+  for (size_t k : f->keep) {
+    if (k == f->col) cb1(s, len, &f->out);
+  }
+  f->col++;
+}
+
+static void
+ref_cb2 (int c, void *data)
+{
+  Filtered *f = static_cast<Filtered *>(data);
+  cb2(c, &f->out);
+  f->col = 0;
+}
+
+static void
+compare (const char *name, const std::string &input, const std::vector<size_t> &keep,
+         csv::CsvParser::Options options, size_t slice)
+{
+  csv::CsvParser ref(options);
+  Filtered f;
+  f.keep = keep;
+  ref.parse(input.data(), input.size(), ref_cb1, ref_cb2, &f);
+  ref.finish(ref_cb1, ref_cb2, &f);
+
+  csv::CsvParser p(options);
+  p.set_projection(keep);
+  std::string out;
+  for (size_t off = 0; off < input.size(); off += slice) {
+    size_t n = input.size() - off < slice ? input.size() - off : slice;
+    p.parse(input.data() + off, n, cb1, cb2, &out);
+  }
+  p.finish(cb1, cb2, &out);
+  if (out != f.out)
+    fail(name, "projected events differ from the filtered full parse");
+}
+
+static void
+test_parity (void)
+{
+  const std::string input =
+    "a,b,c,d\n"
+    "1, \"two, \"\"2\"\"\" ,3,4\r\n"
+    "\"x\ny\",,  z  ,\"\"\n"
+    "\n"
+    "only\n"
+    "p,q \"r\" ,\"s\" t,u\n"
+    "1,2,3,\"unterminated";
+  const std::vector<std::vector<size_t>> keeps = {{0}, {1}, {2, 3}, {0, 3}, {3}, {7}};
+  const csv::CsvParser::Options option_sets[] = {
+    {}, {csv::CsvParser::Option::EmptyIsNull, csv::CsvParser::Option::AppendNull},
+    {csv::CsvParser::Option::RepAllNl}};
+  for (const auto &keep : keeps) {
+    for (const auto &options : option_sets) {
+      for (size_t slice : {1, 3, 1000}) compare("parity", input, keep, options, slice);
+    }
+  }
+  /* Unprojected final field ending in a closing quote */
+  compare("parity", "a,\"b\"", {0}, {csv::CsvParser::Option::AppendNull}, 2);
+}
+
+static void
+test_no_copy (void)
+{
+  /* A huge skipped field must not grow the entry buffer */
+  std::string input = "id,\"" + std::string(1 << 20, 'x') + "\",blob" + std::string(1 << 20, 'y') + "\n";
+  csv::CsvParser p;
+  p.set_projection({0});
+  std::string out;
+  p.parse(input.data(), input.size(), cb1, cb2, &out);
+  p.finish(cb1, cb2, &out);
+  if (out != "Fid;R\n")
+    fail("no_copy", "unexpected events");
+  if (p.get_buffer_size() > 1024)
+    fail("no_copy", "skipped field was buffered");
+  if (p.get_projection() != std::vector<size_t>{0})
+    fail("no_copy", "projection not reported");
+  p.clear_projection();
+  if (!p.get_projection().empty())
+    fail("no_copy", "projection not cleared");
+}
+
+static void
+test_strict (void)
+{
+  const std::string input = "a,b\"c\n";
+  csv::CsvParser p({csv::CsvParser::Option::Strict});
+  p.set_projection({0});
+  std::string out;
+  try {
+    p.parse(input.data(), input.size(), cb1, cb2, &out);
+    fail("strict", "error in skipped field not reported");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Eparse || e.bytes_parsed != 3)
+      fail("strict", "wrong error for skipped field");
+  }
+}
+
+int
+main (void)
+{
+  test_parity();
+  test_no_copy();
+  test_strict();
+  std::puts("All tests passed");
+  return 0;
+}
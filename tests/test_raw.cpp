@@ -0,0 +1,195 @@
+#include "RawField.hpp"
+#include "RowFilter.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Raw"
+#include "test_fixture.hpp"
+
+static void
+raw_field_cb (const csv::RawField &f, void *data)
+{
+  Output *o = static_cast<Output *>(data);
+  if (f.is_null()) o->text += "NULL";
+  else o->text += "[" + f.str() + "]";
+}
+
+static size_t
+feed_raw (csv::CsvParser &p, char *s, size_t n, Output &out)
+{
+  return p.parse_raw(s, n, raw_field_cb, row_cb, &out);
+}
+
+static void
+finish_raw (csv::CsvParser &p, Output &out)
+{
+  p.finish_raw(raw_field_cb, row_cb, &out);
+}
+
+/* Values through parse_raw() and str() match parse(), whatever the chunk boundary */
+static void
+check_values (const char *name, const Setup &setup)
+{
+  for (size_t k = 0; k <= kCsv.size(); k++) {
+    Output ref, out;
+    const std::string expected = run(setup, kCsv, k, ref);
+    const std::string got = run(setup, kCsv, k, out, feed_raw, finish_raw);
+    if (got != expected) {
+      std::fprintf(stderr, "split at %zu:\n%s\nexpected:\n%s\n", k, got.c_str(), expected.c_str());
+      fail(name, "values differ from parse()");
+    }
+  }
+}
+
+static void
+test_values (void)
+{
+  check_values("plain", [](csv::CsvParser &) {});
+  check_values("options", [](csv::CsvParser &p) {
+    p.set_options({csv::CsvParser::Option::RepAllNl, csv::CsvParser::Option::EmptyIsNull});
+  });
+  check_values("header", [](csv::CsvParser &p) {
+    p.set_header_row(true);
+    p.set_named_projection({"note", "name"});
+  });
+  check_values("filter", [](csv::CsvParser &p) {
+    p.set_header_row(true);
+    p.set_filter(csv::RowFilter().int_range("qty", 15, 75));
+  });
+}
+
+struct Fields {
+  std::string input;
+  std::vector<csv::RawField> fields;
+};
+
+static void
+keep_field (const csv::RawField &f, void *data)
+{
+  static_cast<Fields *>(data)->fields.push_back(f);
+}
+
+static void
+test_flags (void)
+{
+  Fields r;
+  r.input = "  \"say \"\"hi\"\"\"  ,plain  ,\"\",,x\n";
+  csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+  p.parse_raw(r.input.data(), r.input.size(), keep_field, nullptr, &r);
+  if (r.fields.size() != 5)
+    fail("flags", "wrong field count");
+
+  const csv::RawField &q = r.fields[0];
+  if (!q.quoted() || !q.escaped() || q.trailing_spaces() != 2 || q.raw() != "\"say \"\"hi\"\"\"  " ||
+      q.span() != "say \"\"hi\"\"" || q.str() != "say \"hi\"")
+    fail("flags", "quoted field");
+  if (q.data() != r.input.data() + 2)
+    fail("flags", "field not delivered in place");
+
+  const csv::RawField &u = r.fields[1];
+  std::string scratch;
+  if (u.quoted() || u.escaped() || u.trailing_spaces() != 2 || u.span() != "plain" ||
+      u.value(scratch).data() != u.data() || !scratch.empty())
+    fail("flags", "unquoted field");
+
+  if (r.fields[2].is_null() || !r.fields[2].quoted() || !r.fields[2].span().empty() ||
+      !r.fields[3].is_null() || r.fields[4].span() != "x")
+    fail("flags", "empty and NULL fields");
+}
+
+static void
+test_strict (void)
+{
+  const std::string bad = "a,b\"c\n";
+  csv::CsvParser p({csv::CsvParser::Option::Strict});
+  Output out;
+  try {
+    p.parse_raw(bad.data(), bad.size(), raw_field_cb, row_cb, &out);
+    fail("strict", "malformed field accepted");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Eparse || e.bytes_parsed != 3)
+      fail("strict", "wrong error");
+  }
+}
+
+/* Fails past 256 bytes, like an allocator out of memory */
+static void *
+capped_realloc (void *p, size_t size)
+{
+  return size > 256 ? nullptr : std::realloc(p, size);
+}
+
+/* Bytes parsed until Enomem stops a call, or all of @p input, split after @p k bytes */
+static size_t
+parse_until_error (csv::CsvParser &p, const std::string &input, size_t k, bool raw, Output &out)
+{
+  size_t at = 0;
+  try {
+    for (const size_t n : {k, input.size() - k}) {
+      if (raw) p.parse_raw(input.data() + at, n, raw_field_cb, row_cb, &out);
+      else p.parse(input.data() + at, n, field_cb, row_cb, &out);
+      at += n;
+    }
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Enomem)
+      fail("out_of_memory", "wrong error type");
+    return at + e.bytes_parsed;
+  }
+  return at;
+}
+
+/*
+ * A carried field outgrowing the entry buffer stops the call at the first
+ * byte that does not fit, with the state of the bytes reported as parsed
+ */
+static void
+test_out_of_memory (void)
+{
+  const std::string fields[] = {"ab" + std::string(300, 'u'),
+                                "\"a\"\"b" + std::string(300, 'u') + "\"\"c\""};
+  for (const std::string &field : fields) {
+    const std::string input = "x," + field + ",y\n";
+    for (const size_t k : {3, 5, 6, 200}) {
+      Output out;
+      csv::CsvParser p;
+      p.set_realloc_func(capped_realloc);
+      const size_t parsed = parse_until_error(p, input, k, true, out);
+      p.finish_raw(raw_field_cb, row_cb, &out);
+      if (parsed >= input.size())
+        fail("out_of_memory", "field larger than the allocator allows accepted");
+
+      /* What remains is what parsing only those bytes gives */
+      Output expected;
+      csv::CsvParser q;
+      q.parse(input.data(), parsed, field_cb, row_cb, &expected);
+      q.finish(field_cb, row_cb, &expected);
+      if (out.text != expected.text) {
+        std::fprintf(stderr, "split at %zu, %zu parsed:\n%s\nexpected:\n%s\n", k, parsed, out.text.c_str(),
+                     expected.text.c_str());
+        fail("out_of_memory", "state differs from the bytes reported as parsed");
+      }
+
+      /* Unquoted, raw and unescaped bytes are the same, so csv_parse() stops at the same byte */
+      if (field[0] != '"') {
+        Output ignored;
+        csv::CsvParser c;
+        c.set_realloc_func(capped_realloc);
+        if (parse_until_error(c, input, k, false, ignored) != parsed)
+          fail("out_of_memory", "stopped elsewhere than csv_parse()");
+      }
+    }
+  }
+}
+
+int
+main (void)
+{
+  test_values();
+  test_flags();
+  test_strict();
+  test_out_of_memory();
+  std::puts("All tests passed");
+  return 0;
+}
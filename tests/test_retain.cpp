@@ -0,0 +1,211 @@
+#include "CsvParser.hpp"
+#include "FieldArena.hpp"
+#include "RawField.hpp"
+#include "RowBatch.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, "Retain test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+static const std::string kCsv =
+  "id,name,note\n"
+  "1,alpha,\"plain\"\n"
+  "2,\"be,ta\",\"say \"\"hi\"\"\"\n"
+  "3,,\"\"\n"
+  "4,delta,last";
+
+/* Fields as "[text]" or "NULL", rows as "/\n" */
+static std::string
+render (const std::vector<std::vector<csv::FieldView> > &rows)
+{
+  std::string text;
+  for (const auto &row : rows) {
+    for (const csv::FieldView &v : row) text += v.is_null() ? "NULL" : "[" + v.str() + "]";
+    text += "/\n";
+  }
+  return text;
+}
+
+struct Retained {
+  csv::FieldArena arena{32};
+  std::vector<std::vector<csv::FieldView> > rows{1};
+  const char *begin = nullptr;
+  const char *end = nullptr;
+  size_t inside = 0;
+};
+
+static void
+field_cb (void *s, size_t len, void *data)
+{
+  Retained *r = static_cast<Retained *>(data);
+  r->rows.back().push_back(s ? r->arena.copy(static_cast<const char *>(s), len) : csv::FieldView());
+}
+
+static void
+raw_cb (const csv::RawField &f, void *data)
+{
+  Retained *r = static_cast<Retained *>(data);
+  const csv::FieldView v = f.retain(r->arena);
+  if (v.data() >= r->begin && v.data() < r->end) r->inside++;
+  r->rows.back().push_back(v);
+}
+
+static void
+row_cb (int, void *data)
+{
+  static_cast<Retained *>(data)->rows.emplace_back();
+}
+
+static std::string
+reference (void)
+{
+  Retained r;
+  csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+  p.parse(kCsv.data(), kCsv.size(), field_cb, row_cb, &r);
+  p.finish(field_cb, row_cb, &r);
+  return render(r.rows);
+}
+
+static void
+test_arena (void)
+{
+  csv::FieldArena arena(16);
+  std::vector<csv::FieldView> views;
+  std::vector<std::string> values;
+  for (size_t i = 0; i < 40; i++) {
+    values.push_back(std::string(i % 13, static_cast<char>('a' + i % 26)));
+    views.push_back(arena.copy(values.back().data(), values.back().size()));
+  }
+  values.push_back(std::string(100, 'z'));
+  views.push_back(arena.copy(values.back().data(), values.back().size()));
+  for (size_t i = 0; i < values.size(); i++) {
+    if (views[i].is_null() || views[i].view() != values[i])
+      fail("arena", "copy not stable");
+  }
+  if (arena.size() == 0)
+    fail("arena", "size not counted");
+  arena.clear();
+  if (arena.size() != 0)
+    fail("arena", "clear() did not reset");
+  const csv::FieldView again = arena.copy("xy", 2);
+  if (again.view() != "xy" || arena.size() != 2)
+    fail("arena", "copy after clear()");
+}
+
+static void
+test_view (void)
+{
+  csv::FieldArena arena;
+  const char text[] = "stable";
+  const csv::FieldView fixed(text, 6);
+  if (fixed.transient() || fixed.retain(arena).data() != text || arena.size() != 0)
+    fail("view", "non-transient view copied");
+  if (!csv::FieldView().retain(arena).is_null())
+    fail("view", "NULL view not kept");
+
+  std::string scratch = "moving";
+  const csv::FieldView moving(scratch.data(), scratch.size(), true);
+  const csv::FieldView kept = moving.retain(arena);
+  scratch = "gone!!";
+  if (kept.data() == scratch.data() || kept.view() != "moving" || kept.transient())
+    fail("view", "transient view not copied");
+
+  const csv::FieldView empty = csv::FieldView(scratch.data(), 0, true).retain(arena);
+  if (empty.is_null() || !empty.empty())
+    fail("view", "empty view became NULL");
+}
+
+/* Raw fields retained across every chunk split: only carried or escaped ones are copied */
+static void
+test_raw (void)
+{
+  const std::string expected = reference();
+  for (size_t k = 0; k <= kCsv.size(); k++) {
+    Retained r;
+    r.begin = kCsv.data();
+    r.end = kCsv.data() + kCsv.size();
+    csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+    p.parse_raw(kCsv.data(), k, raw_cb, row_cb, &r);
+    p.parse_raw(kCsv.data() + k, kCsv.size() - k, raw_cb, row_cb, &r);
+    p.finish_raw(raw_cb, row_cb, &r);
+    if (render(r.rows) != expected) {
+      std::fprintf(stderr, "split at %zu:\n%s\nexpected:\n%s\n", k, render(r.rows).c_str(), expected.c_str());
+      fail("raw", "retained values differ");
+    }
+    /* 14 non-NULL fields: the escaped one and the last, unterminated one are copied */
+    if (k == kCsv.size() && (r.inside != 12 || r.arena.size() != std::strlen("say \"\"hi\"\"last")))
+      fail("raw", "fields in the input copied");
+  }
+}
+
+struct Batches {
+  csv::FieldArena arena;
+  std::vector<std::vector<csv::FieldView> > rows;
+  const char *begin = nullptr;
+  const char *end = nullptr;
+  size_t inside = 0;
+};
+
+static void
+batch_cb (const csv::RowBatch &b, void *data)
+{
+  Batches *r = static_cast<Batches *>(data);
+  for (size_t row = 0; row < b.rows(); row++) {
+    r->rows.push_back(b.retain(row, r->arena));
+    for (const csv::FieldView &v : r->rows.back()) {
+      if (v.data() >= r->begin && v.data() < r->end) r->inside++;
+    }
+  }
+}
+
+static void
+test_batch (void)
+{
+  std::string expected = reference();
+  expected.erase(expected.size() - 2);  // no trailing empty row from batches
+
+  Batches copied;
+  {
+    csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+    csv::RowBatch batch(2);
+    batch.parse(p, kCsv.data(), kCsv.size(), batch_cb, &copied);
+    batch.finish(p, batch_cb, &copied);
+  }
+  if (render(copied.rows) != expected)
+    fail("batch", "retained rows differ");
+
+  /* In place, fields still in the caller's buffer are not copied again */
+  std::vector<char> buf(kCsv.begin(), kCsv.end());
+  Batches insitu;
+  insitu.begin = buf.data();
+  insitu.end = buf.data() + buf.size();
+  {
+    csv::CsvParser p({csv::CsvParser::Option::EmptyIsNull});
+    csv::RowBatch batch(2);
+    batch.parse_insitu(p, buf.data(), buf.size(), batch_cb, &insitu);
+    batch.finish(p, batch_cb, &insitu);
+  }
+  if (render(insitu.rows) != expected)
+    fail("batch", "retained in-situ rows differ");
+  if (insitu.inside == 0 || insitu.arena.size() >= copied.arena.size())
+    fail("batch", "in-situ fields copied");
+}
+
+int
+main (void)
+{
+  test_arena();
+  test_view();
+  test_raw();
+  test_batch();
+  std::puts("All tests passed");
+  return 0;
+}
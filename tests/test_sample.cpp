@@ -0,0 +1,127 @@
+#include "RowSampler.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Sample"
+#include "test_util.hpp"
+
+/* Parsed form of row i */
+static std::string
+expected_row (int i, bool quotes)
+{
+  if (quotes && i % 3 == 0) return std::to_string(i) + "|say \"hi\",\nline " + std::to_string(i) + "|" + std::string(i % 50, 'x');
+  return std::to_string(i) + "|plain|" + std::string(i % 50, 'y');
+}
+
+/* Rows of varying length; a third hold quoted fields with quotes, delimiters and newlines */
+static std::string
+make_file (int rows, bool quotes)
+{
+  std::string csv = "id,text,pad\n";
+  for (int i = 0; i < rows; i++) {
+    if (quotes && i % 3 == 0)
+      csv += std::to_string(i) + ",\"say \"\"hi\"\",\nline " + std::to_string(i) + "\"," + std::string(i % 50, 'x');
+    else
+      csv += std::to_string(i) + ",plain," + std::string(i % 50, 'y');
+    csv += i % 2 ? "\n" : "\r\n";
+  }
+  return csv;
+}
+
+/* Every parsed row must be a genuine row of the file, each at most once */
+static void
+check_rows (const char *name, const Rows &r, int rows, bool quotes)
+{
+  std::vector<bool> seen(rows);
+  for (const std::string &row : r.rows) {
+    const int id = std::atoi(row.c_str());
+    if (id < 0 || id >= rows || seen[id] || row != expected_row(id, quotes))
+      fail(name, ("not a row of the file: " + row).c_str());
+    seen[id] = true;
+  }
+}
+
+static void
+test_index (void)
+{
+  write_file("test_sample.csv", make_file(2000, true));
+  csv::CsvParser p;
+  p.set_header_row(true);
+  csv::IndexOptions options;
+  options.stride = 16;
+  csv::RowIndex::build("test_sample.csv", "test_sample.csvidx", p, options);
+  csv::RowIndex index = csv::RowIndex::open("test_sample.csvidx", "test_sample.csv");
+
+  csv::RowSampler sampler("test_sample.csv", 7);
+  Rows r;
+  if (sampler.read(p, index, 300, cb1, cb2, &r) != 300 || r.rows.size() != 300)
+    fail("index", "wrong sample size");
+  check_rows("index", r, 2000, true);
+  if (p.header().size() != 3)
+    fail("index", "header not captured");
+
+  /* Roughly uniform: every quarter of the file is represented */
+  int quarters[4] = {};
+  for (const std::string &row : r.rows) ++quarters[std::atoi(row.c_str()) / 500];
+  for (int q : quarters)
+    if (q < 40) fail("index", "sample not spread over the file");
+
+  /* Asking for more rows than the file holds returns them all, header excluded */
+  std::vector<std::uint64_t> all = sampler.locate(p, index, 5000);
+  if (all.size() != 2000 || all[0] != 12)
+    fail("index", "wrong full sample");
+
+  /* Same seed, same sample */
+  csv::RowSampler again("test_sample.csv", 7);
+  Rows s;
+  again.read(p, index, 300, cb1, cb2, &s);
+  if (s.rows != r.rows)
+    fail("index", "sample not reproducible");
+
+  csv::CsvParser tsv;
+  tsv.set_delimiter('\t');
+  try {
+    (void)sampler.locate(tsv, index, 10);
+    fail("index", "parser mismatch accepted");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("index", "wrong error type");
+  }
+}
+
+static void
+test_blocks (void)
+{
+  for (bool quotes : {true, false}) {
+    write_file("test_sample.csv", make_file(3000, quotes));
+    csv::CsvParser p;
+    p.set_header_row(true);
+    csv::RowSampler sampler("test_sample.csv", 11);
+    Rows r;
+    const std::uint64_t n = sampler.read(p, 200, cb1, cb2, &r);
+    if (n != r.rows.size() || n < 190)
+      fail("blocks", "too few rows sampled");
+    check_rows("blocks", r, 3000, quotes);
+  }
+
+  /* A small file is covered completely, the first row included */
+  write_file("test_sample.csv", "a,b\n1,2\n\n3,4\n\n");
+  csv::CsvParser p;
+  csv::RowSampler sampler("test_sample.csv");
+  std::vector<std::uint64_t> starts = sampler.locate(p, 10);
+  if (starts.size() != 3 || starts[0] != 0 || starts[1] != 4 || starts[2] != 8)
+    fail("blocks", "small file not covered");
+}
+
+int
+main (void)
+{
+  test_index();
+  test_blocks();
+  std::remove("test_sample.csv");
+  std::remove("test_sample.csvidx");
+  std::puts("All tests passed");
+  return 0;
+}
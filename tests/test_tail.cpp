@@ -0,0 +1,107 @@
+#include "TailReader.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Tail"
+#include "test_util.hpp"
+
+/* Multi-line quoted fields, escaped quotes, CRLF and blank lines */
+static std::string
+make_log (size_t rows)
+{
+  std::string out;
+  for (size_t i = 0; i < rows; i++) {
+    out += std::to_string(i) + ",";
+    switch (i % 5) {
+      case 0: out += "\"multi\nline\r\nmessage\""; break;
+      case 1: out += "\"say \"\"hi\"\"\""; break;
+      case 2: out += "plain text"; break;
+      case 3: out += "\"a,b\",\"\""; break;
+      default: out += " spaced "; break;
+    }
+    out += i % 7 == 0 ? "\r\n" : "\n";
+    if (i % 11 == 0) out += "\n";
+  }
+  return out;
+}
+
+static void
+check_tail (const char *name, csv::CsvParser &p, const std::string &input, std::uint64_t n)
+{
+  std::vector<std::string> all = parse_all(p, input);
+  write_file("test_tail.csv", input);
+  csv::TailReader tail("test_tail.csv");
+
+  Rows r;
+  std::uint64_t got = tail.read(p, n, cb1, cb2, &r);
+  size_t expect = n < all.size() ? n : all.size();
+  if (got != expect || r.rows.size() != expect)
+    fail(name, "unexpected row count");
+  for (size_t i = 0; i < expect; i++)
+    if (r.rows[i] != all[all.size() - expect + i])
+      fail(name, "row mismatch");
+
+  std::uint64_t off = tail.locate(p, n);
+  if (off > input.size() || (expect > 0 && off == input.size()))
+    fail(name, "unexpected offset");
+}
+
+static void
+test_tail (void)
+{
+  const std::string log = make_log(40000);  /* well beyond the verification window */
+  for (std::uint64_t n : {0, 1, 2, 7, 300, 39999, 40000, 50000}) {
+    csv::CsvParser p;
+    check_tail("tail", p, log, n);
+    csv::CsvParser q({csv::CsvParser::Option::RepAllNl});
+    check_tail("tail_repall", q, log, n);
+  }
+
+  /* Without a trailing terminator, and with a single row */
+  csv::CsvParser p;
+  check_tail("no_newline", p, log + "last,\"row\"", 3);
+  check_tail("single", p, "only,row", 5);
+  check_tail("empty", p, "", 5);
+}
+
+static void
+test_fallback (void)
+{
+  /* A stray quote in an unquoted field breaks quote parity */
+  std::string log = make_log(20000);
+  log += "99,ab\"c\n100,x\n101,y\n";
+  csv::CsvParser p;
+  check_tail("stray_quote", p, log, 3);
+  check_tail("stray_quote_wide", p, log, 10);
+
+  /* The file ends inside a quoted field */
+  check_tail("open_quote", p, make_log(20000) + "5,\"open\nfield", 4);
+}
+
+static void
+test_header (void)
+{
+  const std::string log = "id,msg\n" + make_log(50);
+  csv::CsvParser p;
+  p.set_header_row(true);
+  p.set_named_projection({"msg"});
+  check_tail("header", p, log, 3);
+  check_tail("header_all", p, log, 1000);
+  if (p.header().size() != 2 || p.header().find("msg") != 1)
+    fail("header", "header not captured");
+
+  check_tail("header_only", p, "id,msg", 3);
+}
+
+int
+main (void)
+{
+  test_tail();
+  test_fallback();
+  test_header();
+  std::remove("test_tail.csv");
+  puts("All tests passed");
+  return 0;
+}
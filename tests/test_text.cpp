@@ -0,0 +1,135 @@
+#include "TextIndex.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "Text"
+#include "test_util.hpp"
+
+static const char *const kWords[] = {"Gateway", "timeout", "disk", "full", "retry", "ok"};
+
+/* Row i mentions words i % 6 and i % 4 in its message; the id column holds "w<i>" */
+static std::string
+make_rows (int rows)
+{
+  std::string csv = "id,message,note\n";
+  for (int i = 0; i < rows; i++) {
+    csv += "w" + std::to_string(i) + ",\"" + kWords[i % 6] + ", " + kWords[i % 4] + "\n(" +
+           std::to_string(i) + ")\"," + (i % 10 ? "" : "gateway") + (i % 2 ? "\n" : "\r\n");
+  }
+  return csv;
+}
+
+static void
+test_tokenize (void)
+{
+  std::vector<std::string> t = csv::TextIndex::tokenize("Disk-FULL, r\xC3\xA9seau  id42");
+  if (t.size() != 4 || t[0] != "disk" || t[1] != "full" || t[2] != "r\xC3\xA9seau" || t[3] != "id42")
+    fail("tokenize", "wrong folded tokens");
+  t = csv::TextIndex::tokenize("Disk-FULL", true);
+  if (t.size() != 2 || t[0] != "Disk" || t[1] != "FULL")
+    fail("tokenize", "case not kept");
+  if (!csv::TextIndex::tokenize(" ,;-").empty())
+    fail("tokenize", "separators produced a token");
+}
+
+static void
+test_find (void)
+{
+  write_file("test_text.csv", make_rows(1200), "wb");
+  csv::CsvParser p;
+  csv::TextIndexOptions options;
+  options.columns = {1};
+  options.header_row = true;
+  csv::TextIndex::build("test_text.csv", "test_text.csvtxt", p, options);
+  if (!csv::TextIndex::is_fresh("test_text.csvtxt", "test_text.csv"))
+    fail("find", "new index not fresh");
+  csv::TextIndex index = csv::TextIndex::open("test_text.csvtxt", "test_text.csv");
+  if (index.rows() != 1201 || index.case_sensitive())
+    fail("find", "unexpected index shape");
+  if (index.columns() != std::vector<size_t>{1} || !index.header_row() || !index.built_with(options))
+    fail("find", "build settings not kept");
+  options.columns = {1, 1};
+  if (!index.built_with(options))
+    fail("find", "duplicate column treated as different settings");
+  options.columns = {1, 2};
+  if (index.built_with(options))
+    fail("find", "other columns accepted");
+  options.columns = {1};
+  options.header_row = false;
+  if (index.built_with(options))
+    fail("find", "other header setting accepted");
+  options.header_row = true;
+  options.case_sensitive = true;
+  if (index.built_with(options))
+    fail("find", "other case setting accepted");
+
+  /* "gateway" in the message is i % 6 == 0 or i % 4 == 0; the note column is not indexed */
+  if (index.find("GATEWAY").size() != 400)
+    fail("find", "wrong single token match count");
+  /* Both words: i % 12 is 6 or 8 */
+  if (index.find("disk gateway").size() != 200 || !index.find("timeout nothing").empty() ||
+      !index.find("message").empty() || !index.find("--").empty())
+    fail("find", "wrong intersection");
+  if (index.find("Disk DISK").size() != 400)
+    fail("find", "repeated query token or case not folded");
+
+  Rows r;
+  if (index.lookup(p, "1199", cb1, cb2, &r) != 1 || r.rows.size() != 1 ||
+      r.rows[0] != "w1199|ok, full\n(1199)|")
+    fail("find", "wrong row parsed");
+
+  /* Projection by name applies to the delivered rows */
+  csv::CsvParser named;
+  named.set_header_row(true);
+  named.set_named_projection({"id"});
+  r = Rows();
+  if (named.header().size() != 0 || index.lookup(named, "(120)", cb1, cb2, &r) != 1 ||
+      r.rows.size() != 1 || r.rows[0] != "w120" || named.header().size() != 3)
+    fail("find", "header or projection not applied");
+}
+
+static void
+test_stale (void)
+{
+  csv::CsvParser p;
+  csv::TextIndex::build("test_text.csv", "test_text.csvtxt", p);
+  csv::TextIndex index = csv::TextIndex::open("test_text.csvtxt", "test_text.csv");
+  if (index.find("id").size() != 1 || index.find("w7").size() != 1)
+    fail("stale", "all columns and the header not indexed");
+
+  csv::CsvParser tsv;
+  tsv.set_delimiter('\t');
+  try {
+    Rows r;
+    index.lookup(tsv, "w7", cb1, cb2, &r);
+    fail("stale", "parser mismatch accepted");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("stale", "wrong error type");
+  }
+
+  write_file("test_text.csv", "x,y\n", "ab");
+  if (csv::TextIndex::is_fresh("test_text.csvtxt", "test_text.csv"))
+    fail("stale", "changed source reported fresh");
+  try {
+    csv::TextIndex::open("test_text.csvtxt", "test_text.csv");
+    fail("stale", "stale index opened");
+  } catch (const csv::CsvError &e) {
+    if (e.type != csv::CsvError::ErrorType::Einvalid)
+      fail("stale", "wrong error type");
+  }
+}
+
+int
+main (void)
+{
+  test_tokenize();
+  test_find();
+  test_stale();
+  std::remove("test_text.csv");
+  std::remove("test_text.csvtxt");
+  std::puts("All tests passed");
+  return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef CSV_TEST_UTIL_HPP
+#define CSV_TEST_UTIL_HPP
+
+/*
+ * Helpers shared by the tests that work on files and collect whole rows.
+ * Define TEST_NAME, the prefix of failure messages (e.g. "Tail"), before
+ * including this header.
+ */
+
+#include "CsvParser.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifndef TEST_NAME
+#error "define TEST_NAME before including test_util.hpp"
+#endif
+
+inline void
+fail (const char *test_name, const char *message)
+{
+  std::fprintf(stderr, TEST_NAME " test %s failed: %s\n", test_name, message);
+  std::exit(EXIT_FAILURE);
+}
+
+inline void
+write_file (const char *path, const std::string &contents, const char *mode = "wb")
+{
+  FILE *fp = std::fopen(path, mode);
+  if (!fp || std::fwrite(contents.data(), 1, contents.size(), fp) != contents.size())
+    fail("setup", "cannot write input file");
+  std::fclose(fp);
+}
+
+/* Each row is collected as its fields joined with '|'; rows past `limit` are dropped */
+struct Rows {
+  std::vector<std::string> rows;
+  std::string current;
+  size_t limit = SIZE_MAX;
+};
+
+inline void
+cb1 (void *s, size_t len, void *data)
+{
+  Rows *r = static_cast<Rows *>(data);
+  if (!r->current.empty()) r->current += '|';
+  if (s) r->current.append(static_cast<const char *>(s), len);
+}
+
+inline void
+cb2 (int, void *data)
+{
+  Rows *r = static_cast<Rows *>(data);
+  if (r->rows.size() < r->limit) r->rows.push_back(r->current);
+  r->current.clear();
+}
+
+/* Rows of @p input parsed in one piece by @p p */
+inline std::vector<std::string>
+parse_all (csv::CsvParser &p, const std::string &input)
+{
+  Rows r;
+  p.parse(input.data(), input.size(), cb1, cb2, &r);
+  p.finish(cb1, cb2, &r);
+  return r.rows;
+}
+
+#endif // CSV_TEST_UTIL_HPP